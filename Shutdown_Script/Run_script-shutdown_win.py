@@ -2,6 +2,11 @@
 """
 Shutdown Listener (Hidden)
 - Listens for a special UDP shutdown packet.
+- With a key (--key or WOL_AGENT_KEY, same as agent_key on the ESP32)
+  only signed "WOLA" requests are accepted and acknowledged at once:
+  "shutting down" for a shutdown, "already awake" for a wake request.
+  Replayed requests are refused; resends are re-acked.
+- Without a key the legacy 0xEE packet is accepted (no ack).
 - Runs hidden in background when packaged as .exe with --noconsole.
 - Logs events to C:\ShutdownListener\listener.log
 """
@@ -9,6 +14,9 @@ Shutdown Listener (Hidden)
 import socket
 import os
 import sys
+import hmac
+import struct
+import hashlib
 import logging
 import threading
 from getmac import get_mac_address
@@ -19,6 +27,15 @@ SHUTDOWN_PREFIX = b'\xee\xee\xee\xee\xee\xee'
 PACKET_SIZE = 102
 LOG_FOLDER = r"C:\ShutdownListener"
 LOG_FILE = os.path.join(LOG_FOLDER, "listener.log")
+SEQ_FILE = os.path.join(LOG_FOLDER, "agent_seq.txt")
+
+# Agent protocol (agent.h in the firmware)
+AGENT_MAGIC = b"WOLA"
+AGENT_VERSION = 1
+AGENT_HEAD = struct.Struct("!4sBBBBQ6s2x")
+AGENT_PKT_LEN = AGENT_HEAD.size + 16
+AGENT_SHUTDOWN, AGENT_WAKE, AGENT_ACK = 1, 2, 0x80
+ST_SHUTTING_DOWN, ST_AWAKE = 1, 2
 
 # Ensure log folder exists
 os.makedirs(LOG_FOLDER, exist_ok=True)
@@ -43,13 +60,70 @@ def get_local_mac_bytes():
         raise RuntimeError("Could not obtain local MAC address.")
     return bytes.fromhex(mac_str.replace(':', '').replace('-', ''))
 
+def agent_sign(key, head):
+    return hmac.new(key, head, hashlib.sha256).digest()[:16]
+
+def load_seq():
+    try:
+        with open(SEQ_FILE) as f:
+            seq, status = f.read().split()
+            return int(seq), int(status)
+    except (OSError, ValueError):
+        return 0, 0
+
+def store_seq(seq, status):
+    tmp = SEQ_FILE + ".tmp"
+    with open(tmp, "w") as f:
+        f.write("%d %d\n" % (seq, status))
+    os.replace(tmp, SEQ_FILE)
+
 class UDPShutdownListener:
-    def __init__(self, udp_port=UDP_PORT, simulate=False):
+    def __init__(self, udp_port=UDP_PORT, simulate=False, key=b""):
         self.udp_port = udp_port
         self.simulate = simulate
+        self.key = key
         self.sock = None
         self.local_mac = get_local_mac_bytes()
+        self.last_seq, self.last_status = load_seq()
         logging.info("Local MAC: %s", get_mac_address())
+        logging.info("Mode: %s", "signed agent requests" if key else "legacy packet (no key)")
+
+    def handle_agent(self, data, addr):
+        """Acks a valid request; True when the shutdown must run"""
+        if len(data) != AGENT_PKT_LEN or not data.startswith(AGENT_MAGIC) or data[4] != AGENT_VERSION:
+            return False
+        head = data[:AGENT_HEAD.size]
+        if not hmac.compare_digest(agent_sign(self.key, head), data[AGENT_HEAD.size:]):
+            logging.info("Ignored request from %s: bad signature", addr[0])
+            return False
+        _, _, ptype, _, attempt, seq, mac = AGENT_HEAD.unpack(head)
+        if ptype not in (AGENT_SHUTDOWN, AGENT_WAKE) or mac != self.local_mac:
+            return False
+        if seq < self.last_seq:
+            logging.info("Ignored replayed request %d from %s", seq, addr[0])
+            return False
+
+        fresh = seq > self.last_seq
+        if fresh:
+            self.last_status = ST_SHUTTING_DOWN if ptype == AGENT_SHUTDOWN else ST_AWAKE
+            self.last_seq = seq
+            store_seq(seq, self.last_status)
+
+        ack = AGENT_HEAD.pack(AGENT_MAGIC, AGENT_VERSION, AGENT_ACK | ptype, self.last_status, attempt, seq, mac)
+        self.sock.sendto(ack + agent_sign(self.key, ack), addr)
+        logging.info("%s request %d (attempt %d) from %s acked%s",
+                     "Shutdown" if ptype == AGENT_SHUTDOWN else "Wake", seq, attempt, addr[0],
+                     "" if fresh else " again (resend)")
+        return fresh and ptype == AGENT_SHUTDOWN
+
+    def handle_legacy(self, data, addr):
+        if len(data) != PACKET_SIZE or not data.startswith(SHUTDOWN_PREFIX):
+            return False
+        if data[6:12] != self.local_mac:
+            logging.info("Ignored packet from %s MAC mismatch", addr[0])
+            return False
+        logging.info("Valid shutdown packet received from %s", addr[0])
+        return True
 
     def start(self):
         shutdown_command = "shutdown /s /t 1" if os.name == 'nt' else "sudo /sbin/shutdown -h now"
@@ -72,22 +146,20 @@ class UDPShutdownListener:
                 except OSError:
                     break
 
-                if len(data) != PACKET_SIZE or not data.startswith(SHUTDOWN_PREFIX):
-                    continue
-
-                packet_mac = data[6:12]
-                if packet_mac != self.local_mac:
-                    logging.info("Ignored packet from %s MAC mismatch", addr[0])
+                if self.key:
+                    shutdown = self.handle_agent(data, addr)
+                else:
+                    shutdown = self.handle_legacy(data, addr)
+                if not shutdown:
                     continue
 
-                logging.info("Valid shutdown packet received from %s", addr[0])
                 if self.simulate:
                     logging.info("SIMULATE mode: shutdown skipped")
-                else:
-                    logging.info("Executing shutdown command")
-                    os.system(shutdown_command)
+                    continue
+                logging.info("Executing shutdown command")
+                os.system(shutdown_command)
 
-                # After valid packet, stop listener (optional)
+                # After the shutdown command, stop listener
                 break
 
         except Exception:
@@ -105,7 +177,10 @@ class UDPShutdownListener:
 
 def main():
     simulate = '--simulate' in sys.argv
-    listener = UDPShutdownListener(simulate=simulate)
+    key = os.environ.get("WOL_AGENT_KEY", "")
+    if '--key' in sys.argv and sys.argv.index('--key') + 1 < len(sys.argv):
+        key = sys.argv[sys.argv.index('--key') + 1]
+    listener = UDPShutdownListener(simulate=simulate, key=key.encode())
     listener.start()
 
 if __name__ == "__main__":
@@ -0,0 +1,196 @@
+/*
+ * command_admit_test.cpp
+ * -------------------------------
+ * Checks command admission (cmdAdmit() in command_admit.h, what
+ * commands.cpp runs before every command) on the host:
+ *  - Ids: a repeated id is a duplicate, the ring forgets an id after
+ *    CMD_DEDUP_IDS newer ones, commands without an id always run
+ *  - ts: stale past and future, the CMD_MAX_AGE_MS edge, no stale
+ *    check while the clock is not synced, superseded per key,
+ *    "On"/"Off" sharing a key, targets not sharing one, the stalest
+ *    key evicted when the table is full
+ *  - A rejected command records neither its id nor its ts; a
+ *    corrupt window (RTC memory after power-on) is reset
+ *  - Randomized redelivery: commands duplicated and reordered, as a
+ *    broker does on reconnect; each id must run at most once and
+ *    the ts run per key must never go back
+ *  - Exit code 1 when a check fails
+ *
+ *   g++ -std=c++17 -O2 -I.. command_admit_test.cpp -o command_admit_test
+ *   ./command_admit_test [--rounds 2000] [--seed 1]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "command_admit.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+  if(!(cond)){ failures++; printf("FAIL: %s: ", #cond); printf(__VA_ARGS__); printf("\n"); } \
+} while(0)
+
+#define NOW 1760000000000ULL   // a synced wall clock, ms
+
+static CmdWindow window;
+
+static CommandStatus admit(const char* id, const char* name, const char* target = "", uint64_t ts = 0, uint64_t now = NOW){
+  return cmdAdmit(window, id, name, strlen(name), target, ts, now);
+}
+
+static void reset(){
+  memset(&window, 0xA5, sizeof(window));   // what RTC_NOINIT memory holds after power-on
+}
+
+static void checkIds(){
+  reset();
+  CHECK(admit("a1", "WakeHost", "pc") == CMD_OK, "first delivery");
+  CHECK(admit("a1", "WakeHost", "pc") == CMD_DUPLICATE, "redelivery");
+  CHECK(admit("a1", "PinOut1On") == CMD_DUPLICATE, "same id, other command");
+  CHECK(admit("", "WakeHost", "pc") == CMD_OK && admit("", "WakeHost", "pc") == CMD_OK, "no id");
+
+  char id[16];
+  for(int i = 0; i < CMD_DEDUP_IDS - 1; i++){
+    snprintf(id, sizeof(id), "r%d", i);
+    CHECK(admit(id, "Ping") == CMD_OK, "id %s", id);
+  }
+  CHECK(admit("a1", "WakeHost", "pc") == CMD_DUPLICATE, "a1 is still among the last %d", CMD_DEDUP_IDS);
+  CHECK(admit("r-last", "Ping") == CMD_OK, "one more id");
+  CHECK(admit("a1", "WakeHost", "pc") == CMD_OK, "a1 forgotten after %d newer ids", CMD_DEDUP_IDS);
+  CHECK(admit("r0", "Ping") == CMD_OK, "a1 took r0's place");
+  CHECK(admit("r2", "Ping") == CMD_DUPLICATE, "r2 still remembered");
+}
+
+static void checkStale(){
+  reset();
+  CHECK(admit("s1", "PinOut1On", "", NOW - CMD_MAX_AGE_MS - 1) == CMD_STALE, "old ts");
+  CHECK(admit("s2", "PinOut1On", "", NOW + CMD_MAX_AGE_MS + 1) == CMD_STALE, "ts from the future");
+  CHECK(admit("s3", "PinOut1On", "", NOW - CMD_MAX_AGE_MS) == CMD_OK, "ts at the edge");
+  CHECK(admit("s1", "PinOut1On", "", NOW) == CMD_OK, "retry of a stale id with a fresh ts");
+
+  // Not synced: any ts passes the age check, the order check still applies
+  reset();
+  CHECK(admit("u1", "PinOut2On", "", 5000, 0) == CMD_OK, "unsynced, small ts");
+  CHECK(admit("u2", "PinOut2Off", "", 4000, 0) == CMD_SUPERSEDED, "unsynced, older ts");
+  CHECK(admit("u3", "PinOut2Off", "", NOW - 86400000ULL, NOW) == CMD_STALE, "synced again");
+}
+
+static void checkOrder(){
+  reset();
+  CHECK(admit("o1", "PinOut1On", "", NOW - 100) == CMD_OK, "on");
+  CHECK(admit("o2", "PinOut1Off", "", NOW - 200) == CMD_SUPERSEDED, "off sent before the on");
+  CHECK(admit("o2", "PinOut1Off", "", NOW - 50) == CMD_OK, "superseded id not recorded");
+  CHECK(admit("o3", "PinOut1On", "", NOW - 50) == CMD_OK, "same ts");
+  CHECK(admit("o4", "PinOut2On", "", NOW - 500) == CMD_OK, "other output");
+  CHECK(admit("o5", "WakeHost", "pc", NOW - 100) == CMD_OK, "target pc");
+  CHECK(admit("o6", "WakeHost", "nas", NOW - 300) == CMD_OK, "target nas has its own key");
+  CHECK(admit("o7", "WakeHost", "pc", NOW - 300) == CMD_SUPERSEDED, "target pc again, older");
+  CHECK(admit("o8", "On", "", NOW - 100) == CMD_OK && admit("o9", "On", "", NOW - 200) == CMD_SUPERSEDED,
+        "a name that is only the suffix");
+  CHECK(admit("o10", "PinOut1On", "", 0) == CMD_OK, "no ts: no order check");
+
+  // Full table: the stalest key gives way and its history with it
+  reset();
+  char name[16];
+  for(int i = 0; i < CMD_ORDER_KEYS; i++){
+    snprintf(name, sizeof(name), "Out%dOn", i);
+    CHECK(admit("", name, "", NOW - 1000 + i) == CMD_OK, "%s", name);
+  }
+  CHECK(admit("", "Out0Off", "", NOW - 2000) == CMD_SUPERSEDED, "Out0 still kept");
+  CHECK(admit("", "ExtraOn", "", NOW) == CMD_OK, "17th key");
+  CHECK(admit("", "Out0Off", "", NOW - 2000) == CMD_OK, "Out0 (stalest) evicted");
+  CHECK(admit("", "Out2Off", "", NOW - 2000) == CMD_SUPERSEDED, "Out2 still kept");
+}
+
+static void checkCorrupt(){
+  reset();
+  window.magic = CMD_WINDOW_MAGIC;
+  window.head = CMD_DEDUP_IDS;   // would index past ids[]
+  CHECK(admit("c1", "Ping") == CMD_OK, "reset on a bad head");
+  CHECK(window.head == 1, "head %u after the reset", window.head);
+
+  admit("c2", "PinOut1On", "", NOW);
+  window.magic ^= 1;
+  CHECK(admit("c2", "PinOut1Off", "", NOW - 10) == CMD_OK, "bad magic forgets ids and keys");
+}
+
+// ---- Redelivery ----
+
+struct Sent {
+  std::string id;
+  std::string name;
+  uint64_t    ts;
+};
+
+static void checkRedelivery(unsigned rounds, uint32_t seed){
+  static const char* const names[] = { "PinOut1On", "PinOut1Off", "PinOut2On", "PinOut2Off", "Ping" };
+  std::mt19937 rng(seed);
+  unsigned ran = 0, dup = 0, sup = 0;
+
+  for(unsigned r = 0; r < rounds; r++){
+    reset();
+    uint64_t now = NOW + r * 60000ULL;
+    std::vector<Sent> sent;
+    int n = 2 + rng() % 12;
+    for(int i = 0; i < n; i++){
+      sent.push_back({ "m" + std::to_string(r) + "-" + std::to_string(i), names[rng() % 5], now - 1000 + i * 10 });
+    }
+
+    // QoS 1 redelivery: some messages twice or three times, order shuffled within a few places
+    std::vector<Sent> wire;
+    for(const Sent &s : sent){
+      int copies = 1 + (rng() % 4 == 0) + (rng() % 8 == 0);
+      for(int c = 0; c < copies; c++) wire.push_back(s);
+    }
+    for(size_t i = 0; i + 1 < wire.size(); i++){
+      if(rng() % 3 == 0) std::swap(wire[i], wire[i + 1 + rng() % std::min<size_t>(3, wire.size() - i - 1)]);
+    }
+
+    std::set<std::string> runIds;
+    std::map<std::string, uint64_t> lastTs;
+    for(const Sent &s : wire){
+      CommandStatus st = cmdAdmit(window, s.id.c_str(), s.name.c_str(), s.name.size(), "", s.ts, now);
+      if(st == CMD_DUPLICATE){ dup++; continue; }
+      if(st == CMD_SUPERSEDED){ sup++; continue; }
+      CHECK(st == CMD_OK, "round %u: %s %s", r, s.id.c_str(), commandStatusNames[st]);
+      CHECK(runIds.insert(s.id).second, "round %u: %s ran twice", r, s.id.c_str());
+
+      std::string key = s.name;
+      if(key.size() > 3 && !key.compare(key.size() - 3, 3, "Off")) key.resize(key.size() - 3);
+      else if(key.size() > 2 && !key.compare(key.size() - 2, 2, "On")) key.resize(key.size() - 2);
+      CHECK(s.ts >= lastTs[key], "round %u: %s went back to ts %llu", r, key.c_str(), (unsigned long long)s.ts);
+      lastTs[key] = s.ts;
+      ran++;
+    }
+  }
+  printf("redelivery: %u rounds, %u run, %u duplicates, %u superseded\n", rounds, ran, dup, sup);
+}
+
+int main(int argc, char** argv){
+  unsigned rounds = 2000;
+  uint32_t seed = 1;
+  for(int i = 1; i < argc; i++){
+    if(!strcmp(argv[i], "--rounds") && i + 1 < argc) rounds = strtoul(argv[++i], nullptr, 10);
+    else if(!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "usage: %s [--rounds N] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  checkIds();
+  checkStale();
+  checkOrder();
+  checkCorrupt();
+  checkRedelivery(rounds, seed);
+
+  printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+/*
+ * command_bench.cpp
+ * -------------------------------
+ * Host benchmark of command dispatch: commandParse() and the
+ * compile-time perfect hash (command_parse.h, what commands.cpp
+ * runs) against the mqttCallback() they replaced:
+ *  - "String loop": the payload appended to a String one byte at a
+ *    time with trim() after every byte, then up to nine == compares.
+ *    The String is modelled on the Arduino-ESP32 one: 11 bytes
+ *    inline, then a realloc() to the exact length on every append
+ *  - "in place": commandParse() over the byte buffer and one
+ *    CmdPerfectHash::find() over the firmware's command names
+ *  - Message groups: short and long names, names with trailing
+ *    whitespace, "name:target", the JSON form and unknown names
+ *  - First checks that both resolve every plain message to the same
+ *    command (exit 1 if not), then prints ns per message, heap
+ *    allocations and bytes per message for each group
+ *
+ *   g++ -std=c++17 -O2 -I.. command_bench.cpp -o command_bench
+ *   ./command_bench [--seconds 2]
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include "command_parse.h"
+
+// ---- Heap accounting ----
+
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+
+static void* countedRealloc(void* p, size_t n){
+  allocCount++;
+  allocBytes += n;
+  return realloc(p, n);
+}
+
+void* operator new(size_t n){
+  allocCount++;
+  allocBytes += n;
+  void* p = malloc(n ? n : 1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ---- The String of the old callback ----
+
+class LegacyString {
+public:
+  ~LegacyString(){ free(heap); }
+
+  LegacyString& operator+=(char c){
+    reserve(len + 1);
+    buf()[len++] = c;
+    buf()[len] = '\0';
+    return *this;
+  }
+
+  void trim(){
+    char* b = buf();
+    size_t start = 0, end = len;
+    while(start < end && isspace((unsigned char)b[start])) start++;
+    while(end > start && isspace((unsigned char)b[end - 1])) end--;
+    len = end - start;
+    if(start) memmove(b, b + start, len);
+    b[len] = '\0';
+  }
+
+  bool operator==(const char* s) const {
+    return strcmp(buf(), s) == 0;
+  }
+
+private:
+  static constexpr size_t SSO = 11;
+
+  char*       buf()       { return heap ? heap : sso; }
+  const char* buf() const { return heap ? heap : sso; }
+
+  void reserve(size_t n){
+    if(n <= (heap ? cap : SSO)) return;
+    char* p = (char*)countedRealloc(heap, n + 1);
+    if(!heap) memcpy(p, sso, len + 1);
+    heap = p;
+    cap = n;
+  }
+
+  char   sso[SSO + 1] = "";
+  char*  heap = nullptr;
+  size_t cap = 0;
+  size_t len = 0;
+};
+
+static const char* const legacyNames[] = {
+  "TurnOn", "TurnOff", "CheckUpdate", "FactoryReset", "PingPC",
+  "PinOut1On", "PinOut1Off", "PinOut2On", "PinOut2Off"
+};
+
+// mqttCallback(): -1 when nothing matched
+static int legacyDispatch(const uint8_t* payload, size_t len){
+  LegacyString msg;
+  for(size_t i = 0; i < len; i++){
+    msg += (char)payload[i];
+    msg.trim();
+  }
+  for(int i = 0; i < 9; i++) if(msg == legacyNames[i]) return i;
+  return -1;
+}
+
+// ---- The in-place dispatcher ----
+
+struct BenchEntry {
+  const char* name;
+  int         id;
+};
+
+// cmdTable[] in commands.cpp
+static constexpr BenchEntry table[] = {
+  { "TurnOn", 0 }, { "TurnOff", 1 }, { "CheckUpdate", 2 }, { "FactoryReset", 3 },
+  { "PingPC", 4 }, { "WakeHost", 9 }, { "WakeGroup", 10 }, { "WakeAll", 11 },
+  { "PingHost", 12 }, { "PingAll", 13 }, { "LogLevel", 14 }, { "PinOut1On", 5 },
+  { "PinOut1Off", 6 }, { "PinOut2On", 7 }, { "PinOut2Off", 8 }, { "PresenceDump", 15 },
+};
+
+static constexpr CmdPerfectHash<BenchEntry, sizeof(table) / sizeof(table[0])> cmdIndex(table);
+
+static int inPlaceDispatch(const uint8_t* payload, size_t len){
+  Command cmd;
+  if(!commandParse((const char*)payload, len, cmd)) return -1;
+  const BenchEntry* e = cmdIndex.find(cmd.name, cmd.nameLen);
+  return e ? e->id : -1;
+}
+
+// ---- Workload ----
+
+struct Group {
+  const char* name;
+  const char* msgs[4];
+  bool        legacyKnows;   // the old callback understands the form
+};
+
+static const Group groups[] = {
+  { "short name",      { "TurnOn", "PingPC", "TurnOff", "PingPC" }, true },
+  { "long name",       { "FactoryReset", "CheckUpdate", "PinOut2Off", "PinOut1On" }, true },
+  { "trailing ws",     { "TurnOn\r\n", "  PinOut1Off \n", "CheckUpdate\t", " PingPC\r\n" }, true },
+  { "name:target",     { "WakeHost:rack3-01", "WakeGroup:rack3", "PingHost:nas", "LogLevel:debug" }, false },
+  { "json",            { "{\"cmd\":\"TurnOn\",\"target\":\"rack3\",\"count\":5}",
+                         "{\"cmd\":\"PinOut1On\",\"id\":\"a1b2c3\",\"ts\":1760000000000}",
+                         "{ \"cmd\": \"WakeAll\", \"count\": 3 }",
+                         "{\"cmd\":\"PingHost\",\"target\":\"nas\",\"id\":\"7f3e\"}" }, false },
+  { "unknown",         { "Reboot", "TurnOnNow", "pinout1on", "SomethingLonger" }, true },
+};
+
+static volatile int sink = 0;
+
+template<typename Dispatch>
+static void measure(const Group &g, double seconds, Dispatch dispatch, double &ns, double &allocs, double &bytes){
+  size_t n = 0;
+  size_t a0 = allocCount, b0 = allocBytes;
+  auto t0 = std::chrono::steady_clock::now();
+  double el = 0;
+  do {
+    for(int r = 0; r < 256; r++){
+      for(const char* m : g.msgs) sink += dispatch((const uint8_t*)m, strlen(m));
+    }
+    n += 256 * 4;
+    el = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  } while(el < seconds);
+  ns = el * 1e9 / n;
+  allocs = double(allocCount - a0) / n;
+  bytes = double(allocBytes - b0) / n;
+}
+
+int main(int argc, char** argv){
+  double seconds = 2;
+  for(int i = 1; i < argc; i++){
+    if(!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--seconds S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int bad = 0;
+  for(const Group &g : groups){
+    if(!g.legacyKnows) continue;
+    for(const char* m : g.msgs){
+      int a = legacyDispatch((const uint8_t*)m, strlen(m));
+      int b = inPlaceDispatch((const uint8_t*)m, strlen(m));
+      if(a != b){
+        printf("FAIL: \"%s\": String loop %d, in place %d\n", m, a, b);
+        bad++;
+      }
+    }
+  }
+  if(bad) return 1;
+
+  double per = seconds / (2 * (sizeof(groups) / sizeof(groups[0])));
+  printf("group        |  String loop ns  allocs  bytes |  in place ns  allocs  bytes\n");
+  for(const Group &g : groups){
+    double ns1, a1, b1, ns2, a2, b2;
+    measure(g, per, legacyDispatch, ns1, a1, b1);
+    measure(g, per, inPlaceDispatch, ns2, a2, b2);
+    printf("%-12s | %14.1f  %6.2f  %5.1f | %12.1f  %6.2f  %5.1f%s\n", g.name, ns1, a1, b1, ns2, a2, b2,
+           g.legacyKnows ? "" : "   (old callback: no match)");
+  }
+  return 0;
+}
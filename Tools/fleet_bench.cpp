@@ -0,0 +1,272 @@
+/*
+ * fleet_bench.cpp
+ * -------------------------------
+ * Host benchmark of the fleet batch sender (FleetBatch<N> and the
+ * prebuilt bodies in fleet_batch.h) against the sendWOL() loop it
+ * replaced, as the fleet grows:
+ *  - "sendWOL loop": per host, the 102-byte packet rebuilt on the
+ *    stack, the broadcast address parsed from its string, n frames
+ *    back to back, a String-style "WOL sent" message built
+ *  - "fleet batch": one (host, wake, n) job per host, sent through
+ *    FleetBatch::tick() FLEET_TX_PER_TICK frames at a time, header
+ *    and the host's prebuilt body as two parts of one datagram
+ *  - Frames go over real UDP sockets to a receiver on 127.0.0.1,
+ *    which checks each one with wolMagicValid() (relay_parse.h);
+ *    exit code 1 if a frame is lost or malformed
+ *  - Prints packets per second, heap allocations and bytes per
+ *    batch (global operator new counted), and the table size
+ *  - Then replays each batch on a fake clock, one tick per
+ *    --gap-ms: batch duration, largest burst handed to the stack
+ *    and the closest two repeats of one host come
+ *
+ *   g++ -std=c++17 -O2 -I.. fleet_bench.cpp -o fleet_bench
+ *   ./fleet_bench [--seconds 1] [--repeats 3] [--gap-ms 5]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <chrono>
+#include <new>
+#include <random>
+#include <string>
+#include "fleet_batch.h"
+#include "relay_parse.h"
+
+// ---- Heap accounting ----
+
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+
+void* operator new(size_t n){
+  allocCount++;
+  allocBytes += n;
+  void* p = malloc(n ? n : 1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ---- Sockets ----
+
+static int txSock = -1;
+static int rxSock = -1;
+static sockaddr_in rxAddr;
+static size_t received = 0;
+static size_t malformed = 0;
+
+static bool openSockets(){
+  txSock = socket(AF_INET, SOCK_DGRAM, 0);
+  rxSock = socket(AF_INET, SOCK_DGRAM, 0);
+  if(txSock < 0 || rxSock < 0) return false;
+
+  int big = 1 << 20;
+  setsockopt(rxSock, SOL_SOCKET, SO_RCVBUF, &big, sizeof(big));
+  memset(&rxAddr, 0, sizeof(rxAddr));
+  rxAddr.sin_family = AF_INET;
+  rxAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(rxAddr);
+  return bind(rxSock, (sockaddr*)&rxAddr, sizeof(rxAddr)) == 0 &&
+         getsockname(rxSock, (sockaddr*)&rxAddr, &len) == 0;
+}
+
+static void drain(){
+  uint8_t buf[WOL_MAGIC_MAX_LEN + 4], mac[6];
+  ssize_t n;
+  while((n = recv(rxSock, buf, sizeof(buf), MSG_DONTWAIT)) > 0){
+    received++;
+    if(!wolMagicValid(buf, n, mac)) malformed++;
+  }
+}
+
+// ---- The fleet ----
+
+static FleetHost hosts[FLEET_MAX_HOSTS];
+static uint8_t bodies[FLEET_MAX_HOSTS][FLEET_BODY_LEN];
+static const char* broadcastIPStr = "127.0.0.1";   // config.broadcastIPStr
+static volatile size_t published = 0;
+
+static void makeFleet(int n, std::mt19937 &rng){
+  for(int i = 0; i < n; i++){
+    FleetHost &h = hosts[i];
+    snprintf(h.name, sizeof(h.name), "host%d", i);
+    snprintf(h.group, sizeof(h.group), "rack%d", i / 32);
+    for(auto &b : h.mac) b = rng();
+    h.mac[0] &= 0xFE;
+    h.mac[5] |= 1;
+    h.port = ntohs(rxAddr.sin_port);
+    h.iface = 1;
+    fleetBuildBody(bodies[i], h.mac);
+  }
+}
+
+// The replaced sendWOL(): everything redone for every call
+static void legacySend(int host, int n){
+  uint8_t pkt[WOL_MAGIC_LEN];
+  memset(pkt, 0xFF, 6);
+  for(int j = 0; j < 16; j++) memcpy(&pkt[6 + j * 6], hosts[host].mac, 6);
+
+  sockaddr_in dst = {};
+  dst.sin_family = AF_INET;
+  dst.sin_port = htons(hosts[host].port);
+  if(inet_pton(AF_INET, broadcastIPStr, &dst.sin_addr) != 1) return;
+  for(int i = 0; i < n; i++) sendto(txSock, pkt, sizeof(pkt), 0, (sockaddr*)&dst, sizeof(dst));
+
+  std::string msg = "WOL sent (Wi-Fi) - " + std::string("MQTT command ") + hosts[host].name;
+  published += msg.size();
+}
+
+static sockaddr_in bcast;
+
+// netifSend(): header and body written into one datagram
+static void batchSend(const FleetJob &job){
+  const FleetHost &h = hosts[job.host];
+  iovec iov[2] = {
+    { (void*)(job.kind == FLEET_PKT_SHUTDOWN ? fleetShutdownHeader : fleetWakeHeader), 6 },
+    { bodies[job.host], FLEET_BODY_LEN }
+  };
+  bcast.sin_port = htons(h.port);
+  msghdr m = {};
+  m.msg_name = &bcast;
+  m.msg_namelen = sizeof(bcast);
+  m.msg_iov = iov;
+  m.msg_iovlen = 2;
+  sendmsg(txSock, &m, 0);
+}
+
+static FleetBatch<FLEET_QUEUE_LEN> batch;
+
+// ---- Measurement ----
+
+struct Result {
+  double pps;
+  double allocs;   // per batch
+  double bytes;
+  bool   ok;
+};
+
+template<typename Run>
+static Result measure(int hosts, int repeats, double seconds, Run run){
+  size_t frames = 0, batches = 0;
+  size_t a0 = allocCount, b0 = allocBytes;
+  received = malformed = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  double el = 0;
+  do {
+    run(hosts, repeats);
+    drain();
+    frames += (size_t)hosts * repeats;
+    batches++;
+    el = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  } while(el < seconds);
+  drain();
+
+  Result r;
+  r.pps = frames / el;
+  r.allocs = double(allocCount - a0) / batches;
+  r.bytes = double(allocBytes - b0) / batches;
+  r.ok = received == frames && malformed == 0;
+  if(!r.ok) printf("FAIL: %zu frames sent, %zu received, %zu malformed\n", frames, received, malformed);
+  return r;
+}
+
+static void runLegacy(int n, int repeats){
+  for(int i = 0; i < n; i++){
+    legacySend(i, repeats);
+    drain();
+  }
+}
+
+static void runBatch(int n, int repeats){
+  for(int i = 0; i < n; i++) batch.add({ (uint16_t)i, FLEET_PKT_WAKE, (uint8_t)repeats });
+  while(batch.tick(FLEET_TX_PER_TICK, batchSend) > 0) drain();
+}
+
+// ---- Pacing on a fake clock ----
+
+struct Paced {
+  uint32_t durationMs;
+  int      burst;
+  uint32_t closestRepeatMs;
+};
+
+static Paced pace(int n, int repeats, uint32_t gapMs){
+  static uint32_t lastAt[FLEET_MAX_HOSTS];
+  static bool seen[FLEET_MAX_HOSTS];
+  memset(seen, 0, sizeof(seen));
+  Paced p = { 0, 0, UINT32_MAX };
+  uint32_t now = 0;
+
+  for(int i = 0; i < n; i++) batch.add({ (uint16_t)i, FLEET_PKT_WAKE, (uint8_t)repeats });
+  for(;;){
+    int sent = batch.tick(FLEET_TX_PER_TICK, [&](const FleetJob &job){
+      if(seen[job.host] && now - lastAt[job.host] < p.closestRepeatMs) p.closestRepeatMs = now - lastAt[job.host];
+      seen[job.host] = true;
+      lastAt[job.host] = now;
+    });
+    if(!sent) break;
+    if(sent > p.burst) p.burst = sent;
+    p.durationMs = now;
+    now += gapMs;
+  }
+  return p;
+}
+
+int main(int argc, char** argv){
+  double seconds = 1;
+  int repeats = 3;
+  uint32_t gapMs = 5;   // TX_GAP_MS_DEFAULT
+  for(int i = 1; i < argc; i++){
+    if(!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+    else if(!strcmp(argv[i], "--repeats") && i + 1 < argc) repeats = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "--gap-ms") && i + 1 < argc) gapMs = strtoul(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "usage: %s [--seconds S] [--repeats N] [--gap-ms MS]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(repeats < 1 || repeats > 255 || !gapMs){
+    fprintf(stderr, "--repeats is 1..255, --gap-ms at least 1\n");
+    return 2;
+  }
+  if(!openSockets()){
+    perror("socket");
+    return 1;
+  }
+  bcast = rxAddr;
+
+  static const int sizes[] = { 1, 16, 64, 128, FLEET_MAX_HOSTS };
+  std::mt19937 rng(1);
+  makeFleet(FLEET_MAX_HOSTS, rng);
+  bool ok = true;
+
+  printf("%d repeats per host, frames to 127.0.0.1:%u; table of %d hosts is %zu bytes (%zu per host), no heap\n\n",
+         repeats, ntohs(rxAddr.sin_port), FLEET_MAX_HOSTS, sizeof(hosts) + sizeof(bodies), sizeof(FleetHost) + FLEET_BODY_LEN);
+  printf("hosts  frames |  sendWOL loop pkt/s  allocs  bytes |  fleet batch pkt/s  allocs  bytes\n");
+  for(int n : sizes){
+    Result a = measure(n, repeats, seconds / 2, runLegacy);
+    Result b = measure(n, repeats, seconds / 2, runBatch);
+    ok &= a.ok && b.ok;
+    printf("%5d  %6d | %19.0f  %6.1f  %5.0f | %18.0f  %6.1f  %5.0f\n",
+           n, n * repeats, a.pps, a.allocs, a.bytes, b.pps, b.allocs, b.bytes);
+  }
+
+  printf("\npaced, one tick of %d frames every %u ms:\n", FLEET_TX_PER_TICK, gapMs);
+  printf("hosts  frames | batch ms  burst  closest repeats | sendWOL loop burst\n");
+  for(int n : sizes){
+    Paced p = pace(n, repeats, gapMs);
+    char closest[16] = "-";
+    if(repeats > 1) snprintf(closest, sizeof(closest), "%u ms", p.closestRepeatMs);
+    printf("%5d  %6d | %8u  %5d  %15s | %18d\n", n, n * repeats, p.durationMs, p.burst, closest, n * repeats);
+  }
+
+  if(!ok) printf("\nframes were lost or malformed\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+/*
+ * host/Arduino.h
+ * -------------------------------
+ * The little of Arduino.h that scheduler.cpp needs, for host builds
+ * of it (Tools/scheduler_sim.cpp): millis() comes from the program's
+ * fake clock, Serial prints to stdout.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+unsigned long millis();   // defined by the host program
+
+struct HostSerial {
+  void println(const char* s){ puts(s); }
+};
+
+inline HostSerial Serial;
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+local_api_bench.py
+-------------------------------
+Round-trip latency of the three command paths of the ESP32
+ - HTTP:  POST /api/cmd (keep-alive), timed until the JSON reply
+ - WS:    text frame on :81, timed until the "ack" frame
+ - MQTT:  publish on wol/event through the broker, timed until the
+          "PinOut 1 -> ..." line comes back on wol/log (needs paho-mqtt)
+Commands alternate PinOut1On / PinOut1Off, so the pin ends OFF.
+
+  python3 local_api_bench.py 192.168.1.50 TOKEN -n 100
+  python3 local_api_bench.py 192.168.1.50 TOKEN --broker host --user u --password p
+"""
+import argparse
+import base64
+import http.client
+import json
+import os
+import socket
+import statistics
+import struct
+import threading
+import time
+
+CMDS = ["PinOut1On", "PinOut1Off"]
+
+
+def report(name, samples):
+    if not samples:
+        print(f"{name:5s} no samples")
+        return
+    s = sorted(samples)
+    p95 = s[min(len(s) - 1, int(len(s) * 0.95))]
+    print(f"{name:5s} n={len(s):4d}  min {s[0]:7.1f}  median {statistics.median(s):7.1f}  "
+          f"p95 {p95:7.1f}  max {s[-1]:7.1f} ms")
+
+
+def bench_http(host, token, n):
+    conn = http.client.HTTPConnection(host, 80, timeout=5)
+    headers = {"Authorization": "Bearer " + token, "Content-Type": "text/plain"}
+    out = []
+    for i in range(n):
+        t0 = time.perf_counter()
+        conn.request("POST", "/api/cmd", body=CMDS[i % 2], headers=headers)
+        r = conn.getresponse()
+        body = r.read()
+        out.append((time.perf_counter() - t0) * 1000)
+        if r.status != 200:
+            raise SystemExit(f"HTTP {r.status}: {body.decode()}")
+    conn.close()
+    return out
+
+
+class WsClient:
+    """Just enough RFC 6455 for the bench: masked text out, unmasked frames in"""
+
+    def __init__(self, host, token):
+        self.sock = socket.create_connection((host, 81), timeout=5)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall((f"GET /?token={token} HTTP/1.1\r\nHost: {host}\r\n"
+                           "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                           f"Sec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n\r\n").encode())
+        resp = b""
+        while b"\r\n\r\n" not in resp:
+            resp += self.sock.recv(512)
+        head, self.buf = resp.split(b"\r\n\r\n", 1)
+        if b" 101 " not in head.split(b"\r\n")[0]:
+            raise SystemExit("WS handshake failed: " + head.split(b"\r\n")[0].decode())
+
+    def send(self, text):
+        data = text.encode()
+        mask = os.urandom(4)
+        body = bytes(b ^ mask[i & 3] for i, b in enumerate(data))
+        hdr = struct.pack("!BB", 0x81, 0x80 | len(data)) if len(data) < 126 else \
+            struct.pack("!BBH", 0x81, 0x80 | 126, len(data))
+        self.sock.sendall(hdr + mask + body)
+
+    def _need(self, n):
+        while len(self.buf) < n:
+            self.buf += self.sock.recv(1024)
+
+    def recv(self):
+        self._need(2)
+        n = self.buf[1] & 0x7F
+        hdr = 2
+        if n == 126:
+            self._need(4)
+            n = struct.unpack("!H", self.buf[2:4])[0]
+            hdr = 4
+        self._need(hdr + n)
+        data, self.buf = self.buf[hdr:hdr + n], self.buf[hdr + n:]
+        return json.loads(data)
+
+    def close(self):
+        self.sock.close()
+
+
+def bench_ws(host, token, n):
+    ws = WsClient(host, token)
+    ws.recv()   # state snapshot
+    out = []
+    for i in range(n):
+        t0 = time.perf_counter()
+        ws.send(CMDS[i % 2])
+        while True:
+            msg = ws.recv()
+            if msg.get("type") == "ack":
+                break
+        out.append((time.perf_counter() - t0) * 1000)
+    ws.close()
+    return out
+
+
+def bench_mqtt(args, n):
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        print("MQTT  skipped (pip install paho-mqtt)")
+        return []
+
+    got = threading.Event()
+    expect = {"line": ""}
+
+    def on_message(client, userdata, msg):
+        if expect["line"] in msg.payload.decode(errors="replace"):
+            got.set()
+
+    c = mqtt.Client()
+    if args.user:
+        c.username_pw_set(args.user, args.password)
+    if args.port == 8883:
+        c.tls_set()
+    c.on_message = on_message
+    c.connect(args.broker, args.port)
+    c.subscribe("wol/log")
+    c.loop_start()
+    time.sleep(1)
+
+    out = []
+    for i in range(n):
+        expect["line"] = "PinOut 1 -> " + ("ON" if i % 2 == 0 else "OFF")
+        got.clear()
+        t0 = time.perf_counter()
+        c.publish("wol/event", CMDS[i % 2])
+        if got.wait(5):
+            out.append((time.perf_counter() - t0) * 1000)
+    c.loop_stop()
+    c.disconnect()
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Local API vs MQTT latency")
+    ap.add_argument("host", help="ESP32 IP address")
+    ap.add_argument("token", help="config api_token")
+    ap.add_argument("-n", type=int, default=50, help="commands per transport")
+    ap.add_argument("--broker", help="MQTT broker (skip MQTT if not set)")
+    ap.add_argument("--port", type=int, default=8883)
+    ap.add_argument("--user")
+    ap.add_argument("--password")
+    args = ap.parse_args()
+
+    report("HTTP", bench_http(args.host, args.token, args.n))
+    report("WS", bench_ws(args.host, args.token, args.n))
+    if args.broker:
+        report("MQTT", bench_mqtt(args, args.n))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,184 @@
+/*
+ * mac_table_test.cpp
+ * -------------------------------
+ * Randomized test of the presence MAC table (MacTable<N> in
+ * presence_parse.h) against a std::map reference:
+ *  - Updates, erases of present and absent MACs and evictions at
+ *    MAX_LOAD, drawn from a MAC pool a few times the table size, so
+ *    probe chains are long, collide and wrap around the end
+ *  - The clock starts just below 2^32, so the least-recently-seen
+ *    eviction is also run across the millis() wrap
+ *  - After every operation: the same MACs are found (and absent ones
+ *    are not), with the same first/last time, count and IP; size()
+ *    and forEach() agree; and no probe chain has a hole, i.e. every
+ *    entry sits after its home slot with only occupied slots between
+ *    (what backward-shift deletion has to keep)
+ *  - Tables of 8, 16, 64 and 128 (PRESENCE_TABLE_SIZE) entries;
+ *    exit code 1 on the first mismatch
+ *
+ *   g++ -std=c++17 -O2 -I.. mac_table_test.cpp -o mac_table_test
+ *   ./mac_table_test [--ops 200000] [--seed 1]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "presence_parse.h"
+
+struct RefEntry {
+  uint64_t lastT;   // unwrapped time, for the eviction order
+  uint32_t lastMs;
+  uint32_t firstMs;
+  uint32_t count;
+  uint8_t  ip[4];
+};
+
+// Same hash as MacTable::home()
+template<size_t N>
+static size_t homeOf(uint64_t k){
+  return (size_t)((k * 0x9E3779B97F4A7C15ULL) >> 32) & (N - 1);
+}
+
+static void macOf(uint64_t k, uint8_t mac[6]){
+  for(int i = 5; i >= 0; i--, k >>= 8) mac[i] = (uint8_t)k;
+}
+
+template<size_t N>
+class Tester {
+  using Table = MacTable<N>;
+  using Entry = typename Table::Entry;
+  static_assert(std::is_standard_layout<Table>::value, "slots[] is read at offset 0");
+
+public:
+  Tester(uint32_t seed) : rng(seed) {
+    for(size_t i = 0; i < N * 3; i++){
+      uint8_t mac[6];
+      for(auto &b : mac) b = rng();
+      mac[0] &= 0xFE;
+      pool.push_back(Table::keyOf(mac) | 1);   // never 0 (free slot)
+    }
+  }
+
+  bool run(unsigned long ops){
+    for(unsigned long op = 0; op < ops; op++){
+      t += 1 + rng() % 4;
+      uint64_t k = pool[rng() % pool.size()];
+      uint8_t mac[6];
+      macOf(k, mac);
+      int what = rng() % 100;
+
+      if(what < 60){
+        PresenceSighting s = {};
+        memcpy(s.mac, mac, 6);
+        if(rng() % 3) for(auto &b : s.ip) b = rng();
+        s.ms = (uint32_t)t;
+        update(s, k);
+      } else if(what < 85){
+        table.erase(table.find(mac));   // absent: erase(nullptr) must do nothing
+        ref.erase(k);
+      } else if(!ref.empty()){
+        auto it = ref.begin();
+        std::advance(it, rng() % ref.size());
+        uint8_t m[6];
+        macOf(it->first, m);
+        table.erase(table.find(m));
+        ref.erase(it);
+      }
+
+      if(!check(op)) return false;
+    }
+    printf("N=%-4zu %lu ops ok, %lu evictions, longest probe chain %zu\n", N, ops, evictions, longest);
+    return true;
+  }
+
+private:
+  void update(const PresenceSighting &s, uint64_t k){
+    auto it = ref.find(k);
+    if(it == ref.end()){
+      if(ref.size() >= Table::MAX_LOAD){
+        auto old = ref.begin();
+        for(auto i = ref.begin(); i != ref.end(); ++i) if(i->second.lastT < old->second.lastT) old = i;
+        ref.erase(old);
+        evictions++;
+      }
+      it = ref.emplace(k, RefEntry{ t, s.ms, s.ms, 0, { 0 } }).first;
+    }
+    RefEntry &r = it->second;
+    r.lastT = t;
+    r.lastMs = s.ms;
+    r.count++;
+    if(s.ip[0] | s.ip[1] | s.ip[2] | s.ip[3]) memcpy(r.ip, s.ip, 4);
+
+    const Entry* e = table.update(s);
+    if(e->count == 1 && r.count != 1) printf("  update() reported a new entry for a known MAC\n");
+  }
+
+  bool fail(unsigned long op, const char* what, uint64_t k){
+    printf("FAIL N=%zu op %lu: %s (MAC %012llx)\n", N, op, what, (unsigned long long)k);
+    return false;
+  }
+
+  bool check(unsigned long op){
+    if(table.size() != ref.size()) return fail(op, "size differs", 0);
+
+    for(uint64_t k : pool){
+      uint8_t mac[6];
+      macOf(k, mac);
+      const Entry* e = table.find(mac);
+      auto it = ref.find(k);
+      if(!e && it != ref.end()) return fail(op, "present MAC not found", k);
+      if(e && it == ref.end()) return fail(op, "absent MAC found", k);
+      if(!e) continue;
+      const RefEntry &r = it->second;
+      if(e->key != k || e->lastMs != r.lastMs || e->firstMs != r.firstMs || e->count != r.count || memcmp(e->ip, r.ip, 4))
+        return fail(op, "entry fields differ", k);
+    }
+
+    size_t seen = 0;
+    table.forEach([&](const Entry &e){ seen += ref.count(e.key); });
+    if(seen != ref.size()) return fail(op, "forEach() differs", 0);
+
+    const Entry* slots = reinterpret_cast<const Entry*>(&table);
+    for(size_t i = 0; i < N; i++){
+      if(!slots[i].key) continue;
+      size_t chain = 1;
+      for(size_t j = homeOf<N>(slots[i].key); j != i; j = (j + 1) & (N - 1), chain++){
+        if(!slots[j].key) return fail(op, "hole between an entry and its home slot", slots[i].key);
+      }
+      if(chain > longest) longest = chain;
+    }
+    return true;
+  }
+
+  std::mt19937 rng;
+  std::vector<uint64_t> pool;
+  std::map<uint64_t, RefEntry> ref;
+  Table table;
+  uint64_t t = 0xFFFF0000u;   // wraps the 32-bit clock early in the run
+  unsigned long evictions = 0;
+  size_t longest = 0;
+};
+
+int main(int argc, char** argv){
+  unsigned long ops = 200000;
+  uint32_t seed = 1;
+  for(int i = 1; i < argc; i++){
+    if(!strcmp(argv[i], "--ops") && i + 1 < argc) ops = strtoul(argv[++i], nullptr, 10);
+    else if(!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "usage: %s [--ops N] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  static Tester<8> t8(seed);
+  static Tester<16> t16(seed);
+  static Tester<64> t64(seed);
+  static Tester<128> t128(seed);
+  bool ok = t8.run(ops) && t16.run(ops) && t64.run(ops) && t128.run(ops);
+  return ok ? 0 : 1;
+}
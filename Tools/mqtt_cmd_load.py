@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+mqtt_cmd_load.py
+-------------------------------
+Load generator for idempotent MQTT commands (commands.h): sends
+bursts of PinOut1On/Off with "id" and "ts" on wol/event and checks
+the replies on wol/response
+ - Every command is sent --dup times (duplicates) and each burst is
+   shuffled (out of order); --stale of them carry a ts 2 min old
+ - Checks: at most one "ok" per id, no "ok" for a stale ts (once the
+   device clock is synced), and per pin the "ok" commands are run in
+   ts order; ids without any reply are reported as lost
+ - Prints replies per status, device receipt-to-action time ("us")
+   and publish-to-reply round trip
+Against a local broker the device points at (mosquitto -p 1883):
+
+  python3 mqtt_cmd_load.py --broker 192.168.1.10 --port 1883 -n 20 --burst 6 --dup 3
+
+Exit code 1 when a check fails. Needs paho-mqtt.
+"""
+import argparse
+import collections
+import json
+import os
+import random
+import statistics
+import threading
+import time
+
+CMDS = ["PinOut1On", "PinOut1Off"]
+STALE_MS = 120000
+
+
+def pct(s, p):
+    return s[min(len(s) - 1, int(len(s) * p))]
+
+
+def report(name, samples, unit):
+    if not samples:
+        print(f"{name:10s} no samples")
+        return
+    s = sorted(samples)
+    print(f"{name:10s} n={len(s):5d}  min {s[0]:9.1f}  median {statistics.median(s):9.1f}  "
+          f"p95 {pct(s, 0.95):9.1f}  max {s[-1]:9.1f} {unit}")
+
+
+def make_burst(args, seq):
+    """Unique commands of one burst, each listed --dup times, shuffled"""
+    now = int(time.time() * 1000)
+    cmds = []
+    for i in range(args.burst):
+        stale = random.random() < args.stale
+        cmds.append({
+            "cmd": CMDS[(seq + i) % 2],
+            "id": f"{os.getpid():x}-{seq + i}",
+            "ts": now - STALE_MS if stale else now + i,   # ts order = intended order
+            "stale": stale,
+        })
+    out = [c for c in cmds for _ in range(args.dup)]
+    random.shuffle(out)
+    return cmds, out
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Duplicate / out-of-order command load for wol/event")
+    ap.add_argument("--broker", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=1883)
+    ap.add_argument("--user")
+    ap.add_argument("--password")
+    ap.add_argument("-n", type=int, default=10, help="bursts")
+    ap.add_argument("--burst", type=int, default=4, help="distinct commands per burst")
+    ap.add_argument("--dup", type=int, default=3, help="copies of each command")
+    ap.add_argument("--stale", type=float, default=0.1, help="fraction sent with an old ts")
+    ap.add_argument("--gap", type=float, default=1.0, help="seconds between bursts")
+    ap.add_argument("--qos", type=int, default=1, choices=(0, 1))
+    ap.add_argument("--wait", type=float, default=3.0, help="seconds to wait for the last replies")
+    ap.add_argument("--seed", type=int)
+    args = ap.parse_args()
+    random.seed(args.seed)
+
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        raise SystemExit("pip install paho-mqtt")
+
+    lock = threading.Lock()
+    sent_at = {}                            # id -> first publish time
+    replies = collections.defaultdict(list)  # id -> [(status, us, rtt_ms)]
+    ok_order = []                           # ids with status ok, in arrival order
+    synced = [False]                        # "age_ms" only comes with a synced device clock
+
+    def on_message(client, userdata, msg):
+        try:
+            r = json.loads(msg.payload)
+        except ValueError:
+            return
+        now = time.perf_counter()
+        with lock:
+            rid = r.get("id")
+            if rid not in sent_at:
+                return
+            synced[0] |= "age_ms" in r
+            replies[rid].append((r.get("status"), r.get("us", 0), (now - sent_at[rid]) * 1000))
+            if r.get("status") == "ok":
+                ok_order.append(rid)
+
+    c = mqtt.Client()
+    if args.user:
+        c.username_pw_set(args.user, args.password)
+    if args.port == 8883:
+        c.tls_set()
+    c.on_message = on_message
+    c.connect(args.broker, args.port)
+    c.subscribe("wol/response")
+    c.loop_start()
+    time.sleep(1)
+
+    meta = {}
+    for b in range(args.n):
+        cmds, out = make_burst(args, b * args.burst)
+        for m in cmds:
+            meta[m["id"]] = m
+        for m in out:
+            with lock:
+                sent_at.setdefault(m["id"], time.perf_counter())
+            body = json.dumps({"cmd": m["cmd"], "id": m["id"], "ts": m["ts"]})
+            c.publish("wol/event", body, qos=args.qos)
+        time.sleep(args.gap)
+    time.sleep(args.wait)
+    c.loop_stop()
+    c.disconnect()
+
+    status = collections.Counter()
+    us, rtt = [], []
+    errors = []
+    for rid, rs in replies.items():
+        for st, u, t in rs:
+            status[st] += 1
+            if st == "ok":
+                us.append(u)
+                rtt.append(t)
+        oks = sum(1 for st, _, _ in rs if st == "ok")
+        if oks > 1:
+            errors.append(f"{rid}: run {oks} times")
+        if oks and meta[rid]["stale"] and synced[0]:
+            errors.append(f"{rid}: stale ts was run")
+    lost = [rid for rid in meta if rid not in replies]
+
+    last_ts = {}
+    for rid in ok_order:
+        pin = meta[rid]["cmd"][:7]
+        if meta[rid]["ts"] < last_ts.get(pin, 0):
+            errors.append(f"{rid}: run after a newer command for {pin}")
+        last_ts[pin] = max(last_ts.get(pin, 0), meta[rid]["ts"])
+
+    sent = args.n * args.burst * args.dup
+    print(f"sent {sent} messages, {len(meta)} ids; replies: "
+          + ", ".join(f"{k} {v}" for k, v in sorted(status.items())) + f"; ids without reply {len(lost)}")
+    if status and not synced[0]:
+        print("note: device clock not synced (SNTP), stale commands were not checked")
+    report("device", us, "us")
+    report("roundtrip", rtt, "ms")
+    for e in errors[:20]:
+        print("FAIL", e)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
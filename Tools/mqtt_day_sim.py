@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+mqtt_day_sim.py
+-------------------------------
+Broker messages per hour published by the ESP32 over a simulated day
+ - Sends a day of commands on wol/event (DAY below: morning wake,
+   evening outputs, a dashboard that re-sends the same output state
+   every hour, night shutdown), time compressed by --speed
+ - Counts every live (non-retained-replay) message on wol/# and
+   homeassistant/#, except the commands it sent itself; an empty
+   wol/event is the firmware's retained clear and counts
+ - Prints messages per topic group and per simulated hour; --out
+   saves the run, --compare puts a saved run next to this one
+Run it once on the old firmware and once on the new one:
+
+  python3 mqtt_day_sim.py --broker host --user u --password p --out before.json
+  python3 mqtt_day_sim.py --broker host --user u --password p --compare before.json
+
+Topics on a wall-clock timer (wol/metrics every 60 s) are counted per
+real time, so with --speed 24 they show 1/24 of a real hour's worth;
+--speed 1 runs a true 24 h day. Needs paho-mqtt.
+"""
+import argparse
+import collections
+import json
+import threading
+import time
+
+# hour -> commands sent during that hour (spread evenly over it)
+DAY = {
+    0: ["PinOut1Off"], 1: ["PinOut1Off"], 2: ["PinOut1Off"], 3: ["PinOut1Off"],
+    4: ["PinOut1Off"], 5: ["PinOut1Off"],
+    6: ["PinOut1Off", "PingPC"],
+    7: ["TurnOn", "PingPC", "PinOut1Off"],
+    8: ["PingPC", "PinOut1Off"], 9: ["PinOut1Off"], 10: ["PinOut1Off"], 11: ["PinOut1Off"],
+    12: ["PingPC", "PinOut1Off"], 13: ["PinOut1Off"], 14: ["PinOut1Off"], 15: ["PinOut1Off"],
+    16: ["PinOut1Off"], 17: ["PinOut1Off"],
+    18: ["TurnOn", "PinOut1On", "PinOut2On"],
+    19: ["PingPC", "PinOut1On"], 20: ["PinOut1On"], 21: ["PinOut1On", "PinOut2Off"],
+    22: ["PingPC", "PinOut1On"],
+    23: ["TurnOff", "PinOut1Off", "PinOut2Off"],
+}
+
+
+def group(topic):
+    """Topics with a per-host or per-entity part are counted together"""
+    parts = topic.split("/")
+    if parts[0] == "homeassistant":
+        return "homeassistant/+" if topic != "homeassistant/status" else topic
+    if parts[:3] == ["wol", "state", "host"]:
+        return "wol/state/host/+"
+    if parts[:2] == ["wol", "boottime"]:
+        return "wol/boottime/+"
+    return topic
+
+
+def schedule(hours, speed):
+    """[(seconds from start, command)] for the day profile"""
+    hour_s = 3600.0 / speed
+    out = []
+    for h in range(hours):
+        cmds = DAY.get(h % 24, [])
+        for i, c in enumerate(cmds):
+            out.append((h * hour_s + (i + 0.5) * hour_s / len(cmds), c))
+    return out
+
+
+def summarize(counts, hours):
+    """{group: [per hour]} -> totals"""
+    total = sum(sum(v) for v in counts.values())
+    return {"hours": hours, "total": total, "per_hour": total / hours if hours else 0,
+            "groups": {g: sum(v) for g, v in counts.items()}}
+
+
+def print_run(counts, hours):
+    groups = sorted(counts)
+    print(f"{'hour':>4}  " + "  ".join(f"{g[-14:]:>14}" for g in groups) + f"  {'total':>6}")
+    for h in range(hours):
+        row = [counts[g][h] for g in groups]
+        print(f"{h:4d}  " + "  ".join(f"{v:14d}" for v in row) + f"  {sum(row):6d}")
+    s = summarize(counts, hours)
+    print(f"\n{s['total']} device messages in {hours} simulated hours, {s['per_hour']:.1f} per hour")
+
+
+def print_compare(before, after):
+    groups = sorted(set(before["groups"]) | set(after["groups"]))
+    print(f"\n{'topic':28s} {'before':>8} {'after':>8}")
+    for g in groups:
+        print(f"{g:28s} {before['groups'].get(g, 0):8d} {after['groups'].get(g, 0):8d}")
+    print(f"{'per hour':28s} {before['per_hour']:8.1f} {after['per_hour']:8.1f}")
+    if before["per_hour"]:
+        print(f"change: {100.0 * (after['per_hour'] - before['per_hour']) / before['per_hour']:+.1f} %")
+
+
+def run(args):
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        raise SystemExit("pip install paho-mqtt")
+
+    hour_s = 3600.0 / args.speed
+    counts = collections.defaultdict(lambda: [0] * args.hours)
+    lock = threading.Lock()
+    own = collections.Counter()   # our commands still to be seen echoed
+    t0 = [None]
+
+    def on_message(client, userdata, msg):
+        if msg.retain or t0[0] is None:
+            return            # replay of what the broker held before the run
+        payload = msg.payload.decode(errors="replace")
+        with lock:
+            if msg.topic == "wol/event" and own[payload] > 0:
+                own[payload] -= 1
+                return
+            h = int((time.monotonic() - t0[0]) / hour_s)
+            if h < args.hours:
+                counts[group(msg.topic)][h] += 1
+
+    c = mqtt.Client()
+    if args.user:
+        c.username_pw_set(args.user, args.password)
+    if args.port == 8883:
+        c.tls_set()
+    c.on_message = on_message
+    c.connect(args.broker, args.port)
+    c.subscribe([("wol/#", 0), ("homeassistant/#", 0)])
+    c.loop_start()
+    time.sleep(2)
+
+    plan = schedule(args.hours, args.speed)
+    print(f"{len(plan)} commands over {args.hours} h, one hour = {hour_s:.0f} s")
+    t0[0] = time.monotonic()
+    for at, cmd in plan:
+        time.sleep(max(0.0, t0[0] + at - time.monotonic()))
+        with lock:
+            own[cmd] += 1
+        c.publish("wol/event", cmd, retain=args.retain)
+    time.sleep(max(0.0, t0[0] + args.hours * hour_s - time.monotonic()))
+    c.loop_stop()
+    c.disconnect()
+    return counts
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Device MQTT messages per hour over a simulated day")
+    ap.add_argument("--broker", required=True)
+    ap.add_argument("--port", type=int, default=8883)
+    ap.add_argument("--user")
+    ap.add_argument("--password")
+    ap.add_argument("--speed", type=float, default=24, help="simulated hours per real hour")
+    ap.add_argument("--hours", type=int, default=24)
+    ap.add_argument("--retain", action="store_true", help="send commands retained, like some dashboards")
+    ap.add_argument("--out", help="save this run (JSON)")
+    ap.add_argument("--compare", help="saved run to compare with")
+    args = ap.parse_args()
+
+    counts = run(args)
+    print_run(counts, args.hours)
+    result = summarize(counts, args.hours)
+    result["hourly"] = dict(counts)
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(result, f, indent=1)
+    if args.compare:
+        with open(args.compare) as f:
+            print_compare(json.load(f), result)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,310 @@
+#!/usr/bin/env python3
+"""
+ota_fault_server.py
+-------------------------------
+Local OTA server that injects faults, to test the resumable download
+of ota.cpp (set OTA_BASE_URL in ota.h to this server)
+ - Serves version.txt (with ETag / 304), WOL_ESP32.bin, its gzip
+   image WOL_ESP32.bin.gz and WOL_ESP32.bin.sha256 for the image given
+ - Honours "Range: bytes=N-" with 206 and Content-Range
+ - Faults, each drawn per image response: the connection cut at a
+   random offset (--drop), a pause longer than OTA_STALL_MS
+   (--stall), Range ignored with a full 200 (--ignore-range), one
+   byte flipped (--corrupt, the digest check has to reject it)
+ - HTTPS with a throwaway self-signed certificate (the firmware
+   accepts any), or --http for plain HTTP tests
+ - --selftest N: runs N updates against itself with a client that
+   does what downloadAndFlashFirmware() does (resume from the last
+   byte, skip bytes after a 200, at most OTA_MAX_RESUMES resumes,
+   gzip first, the raw image at once after a 4xx, SHA-256 of the raw
+   image) and reports resumes, throughput and failures; exit 1 if
+   one fails
+
+  python3 ota_fault_server.py WOL_ESP32.bin --drop 0.5 --stall 0.1
+  python3 ota_fault_server.py WOL_ESP32.bin --drop 0.5 --ignore-range 0.2 --selftest 50
+"""
+import argparse
+import gzip
+import hashlib
+import http.client
+import http.server
+import os
+import random
+import socket
+import ssl
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import zlib
+
+OTA_MAX_RESUMES = 5        # ota.cpp
+OTA_STALL_S = 10.0         # OTA_STALL_MS
+OTA_BUF_SIZE = 4096
+CHUNK = 1460
+
+
+class Files:
+    def __init__(self, image, version):
+        raw = open(image, "rb").read()
+        self.digest = hashlib.sha256(raw).hexdigest()
+        self.version = version.encode() + b"\n"
+        self.etag = '"%s"' % hashlib.sha256(self.version).hexdigest()[:16]
+        self.body = {
+            "/WOL_ESP32.bin": raw,
+            "/WOL_ESP32.bin.gz": gzip.compress(raw, 9, mtime=0),
+            "/WOL_ESP32.bin.sha256": (self.digest + "  WOL_ESP32.bin\n").encode(),
+        }
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    files = None
+    opts = None
+    rng = random.Random(1)
+    lock = threading.Lock()
+    stats = {"requests": 0, "drops": 0, "stalls": 0, "ignored_ranges": 0, "corrupted": 0}
+
+    def log_message(self, fmt, *args):
+        if not self.opts.quiet:
+            sys.stderr.write("%s %s\n" % (self.address_string(), fmt % args))
+
+    def roll(self, p):
+        with self.lock:
+            return self.rng.random() < p
+
+    def send_body(self, status, body, extra=()):
+        self.send_response(status)
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Connection", "close")
+        for k, v in extra:
+            self.send_header(k, v)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        self.stats["requests"] += 1
+        f = self.files
+        if self.path == "/version.txt":
+            if self.headers.get("If-None-Match") == f.etag:
+                self.send_body(304, b"", [("ETag", f.etag)])
+            else:
+                self.send_body(200, f.version, [("ETag", f.etag)])
+            return
+        if self.path == "/WOL_ESP32.bin.gz" and self.opts.no_gzip:
+            self.send_body(404, b"not found\n")
+            return
+        data = f.body.get(self.path)
+        if data is None:
+            self.send_body(404, b"not found\n")
+            return
+        if self.path.endswith(".sha256"):
+            self.send_body(200, data)
+            return
+        self.send_image(data)
+
+    def send_image(self, data):
+        start = 0
+        rng = self.headers.get("Range", "")
+        if rng.startswith("bytes=") and not self.roll(self.opts.ignore_range):
+            start = int(rng[6:].split("-")[0] or 0)
+            if start >= len(data):
+                self.send_body(416, b"", [("Content-Range", "bytes */%d" % len(data))])
+                return
+        elif rng:
+            self.stats["ignored_ranges"] += 1
+        part = bytearray(data[start:])
+
+        if self.roll(self.opts.corrupt):
+            self.stats["corrupted"] += 1
+            part[self.rng.randrange(len(part))] ^= 0x01
+        cut = len(part)
+        if self.roll(self.opts.drop):
+            self.stats["drops"] += 1
+            cut = self.rng.randrange(len(part))
+        stall_at = -1
+        if self.roll(self.opts.stall):
+            self.stats["stalls"] += 1
+            stall_at = self.rng.randrange(cut + 1)
+
+        self.send_response(206 if start else 200)
+        self.send_header("Content-Length", str(len(part)))
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Connection", "close")
+        if start:
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, len(data) - 1, len(data)))
+        self.end_headers()
+
+        pos = 0
+        delay = CHUNK / (self.opts.rate * 1024) if self.opts.rate else 0
+        try:
+            while pos < cut:
+                if stall_at >= 0 and pos >= stall_at:
+                    time.sleep(self.opts.stall_s)
+                    stall_at = -1
+                n = min(CHUNK, cut - pos)
+                self.wfile.write(part[pos:pos + n])
+                pos += n
+                if delay:
+                    time.sleep(delay)
+            self.wfile.flush()
+        except (BrokenPipeError, ConnectionResetError, ssl.SSLError):
+            return
+        if cut < len(part):
+            self.close_connection = True
+            try:
+                self.connection.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+
+
+def self_signed(tmp):
+    cert, key = os.path.join(tmp, "cert.pem"), os.path.join(tmp, "key.pem")
+    subprocess.run(["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes", "-days", "2",
+                    "-subj", "/CN=wol-ota-test", "-keyout", key, "-out", cert],
+                   check=True, capture_output=True)
+    return cert, key
+
+
+# ---- Self-test: the firmware's download loop ----
+
+def download(opts, path, expected, gz):
+    sha = hashlib.sha256()
+    inflate = zlib.decompressobj(16 + zlib.MAX_WBITS) if gz else None
+    size = received = resumes = 0
+    t0 = time.monotonic()
+    while size == 0 or received < size:
+        if opts.http:
+            conn = http.client.HTTPConnection("127.0.0.1", opts.port, timeout=OTA_STALL_S)
+        else:
+            conn = http.client.HTTPSConnection("127.0.0.1", opts.port, timeout=OTA_STALL_S,
+                                               context=ssl._create_unverified_context())
+        headers = {"Range": "bytes=%d-" % received} if received else {}
+        dropped = False
+        try:
+            conn.request("GET", path, headers=headers)
+            r = conn.getresponse()
+            skip = 0
+            if r.status == 206:
+                total = int(r.getheader("Content-Range").split("/")[1])
+            elif r.status == 200:
+                total = int(r.getheader("Content-Length"))
+                skip = received
+            elif 400 <= r.status < 500:
+                return False, resumes, 0, "HTTP %d" % r.status          # OTA_OPEN_MISSING: no retry
+            else:
+                raise http.client.HTTPException("HTTP %d" % r.status)   # OTA_OPEN_RETRY
+            if size == 0:
+                size = total
+            elif total != size:
+                return False, resumes, 0, "size changed"
+
+            while received < size:
+                c = r.read1(OTA_BUF_SIZE)
+                if not c:
+                    dropped = True
+                    break
+                if skip:
+                    d = min(len(c), skip)
+                    skip -= d
+                    c = c[d:]
+                received += len(c)
+                try:
+                    sha.update(inflate.decompress(c) if gz else c)
+                except zlib.error:
+                    return False, resumes, 0, "corrupt gzip stream"
+        except (OSError, http.client.HTTPException):
+            dropped = True
+        finally:
+            conn.close()
+        if dropped or size == 0:
+            resumes += 1
+            if resumes > OTA_MAX_RESUMES:
+                return False, resumes, 0, "too many resumes"
+    if gz and not inflate.eof:
+        return False, resumes, 0, "corrupt gzip stream"
+    kbs = received / 1024 / max(time.monotonic() - t0, 1e-6)
+    if sha.hexdigest() != expected:
+        return False, resumes, kbs, "SHA-256 mismatch"
+    return True, resumes, kbs, "SHA-256 OK"
+
+
+def selftest(opts, files, n):
+    failed = 0
+    all_resumes = []
+    rates = []
+    for i in range(n):
+        ok, resumes, kbs, why = download(opts, "/WOL_ESP32.bin.gz", files.digest, True)
+        if not ok:
+            ok, r2, kbs, why = download(opts, "/WOL_ESP32.bin", files.digest, False)
+            resumes += r2
+        all_resumes.append(resumes)
+        if ok:
+            rates.append(kbs)
+        else:
+            failed += 1
+        print("update %3d: %-16s %d resumes %8.0f KB/s" % (i + 1, why, resumes, kbs))
+    s = Handler.stats
+    print("%d updates, %d failed; resumes per update max %d, mean %.1f; %s" %
+          (n, failed, max(all_resumes), sum(all_resumes) / n,
+           "throughput median %.0f KB/s" % sorted(rates)[len(rates) // 2] if rates else "no throughput"))
+    print("server: %d requests, %d drops, %d stalls, %d ranges ignored, %d corrupted" %
+          (s["requests"], s["drops"], s["stalls"], s["ignored_ranges"], s["corrupted"]))
+    return failed == 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Fault-injecting OTA server")
+    ap.add_argument("image", help="firmware image (WOL_ESP32.bin)")
+    ap.add_argument("--port", type=int, default=8443)
+    ap.add_argument("--version", default="99.0", help="version.txt content (newer than the device)")
+    ap.add_argument("--http", action="store_true", help="plain HTTP instead of HTTPS")
+    ap.add_argument("--cert", help="PEM certificate (default: self-signed)")
+    ap.add_argument("--key", help="PEM key for --cert")
+    ap.add_argument("--drop", type=float, default=0.0, help="probability an image response is cut")
+    ap.add_argument("--stall", type=float, default=0.0, help="probability of a pause mid-response")
+    ap.add_argument("--stall-s", type=float, default=OTA_STALL_S + 2, help="pause length, s")
+    ap.add_argument("--ignore-range", type=float, default=0.0, help="probability Range is ignored")
+    ap.add_argument("--corrupt", type=float, default=0.0, help="probability one byte is flipped")
+    ap.add_argument("--no-gzip", action="store_true", help="404 for the gzip image")
+    ap.add_argument("--rate", type=float, default=0, help="throttle to KB/s (0 = unlimited)")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--selftest", type=int, metavar="N", help="run N updates against this server and exit")
+    ap.add_argument("-q", "--quiet", action="store_true", help="no request log")
+    opts = ap.parse_args()
+
+    files = Files(opts.image, opts.version)
+    Handler.files = files
+    Handler.opts = opts
+    Handler.rng = random.Random(opts.seed)
+    if opts.selftest:
+        opts.quiet = True
+
+    srv = http.server.ThreadingHTTPServer(("127.0.0.1" if opts.selftest else "0.0.0.0", opts.port), Handler)
+    srv.daemon_threads = True
+    with tempfile.TemporaryDirectory() as tmp:
+        if not opts.http:
+            cert, key = (opts.cert, opts.key) if opts.cert else self_signed(tmp)
+            ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+            ctx.load_cert_chain(cert, key)
+            srv.socket = ctx.wrap_socket(srv.socket, server_side=True)
+
+        print("%s://<this host>:%d/  image %d bytes (gzip %d), SHA-256 %s" %
+              ("http" if opts.http else "https", opts.port, len(files.body["/WOL_ESP32.bin"]),
+               len(files.body["/WOL_ESP32.bin.gz"]), files.digest))
+        if not opts.selftest:
+            try:
+                srv.serve_forever()
+            except KeyboardInterrupt:
+                pass
+            return
+
+        threading.Thread(target=srv.serve_forever, daemon=True).start()
+        ok = selftest(opts, files, opts.selftest)
+        srv.shutdown()
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
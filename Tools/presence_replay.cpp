@@ -0,0 +1,132 @@
+/*
+ * presence_replay.cpp
+ * -------------------------------
+ * Replays a pcap capture through the firmware's presence parser and
+ * MAC table (presence_parse.h), on Linux:
+ *  - Classic pcap (tcpdump -w), Ethernet link type, either byte
+ *    order, micro- or nanosecond timestamps
+ *  - Prints every sighting, then the table as the firmware would
+ *    hold it at the end of the capture
+ *  - --table-only skips the sightings; --expect MAC exits 1 unless
+ *    that MAC ended up in the table
+ *
+ *   g++ -std=c++17 -O2 -I.. presence_replay.cpp -o presence_replay
+ *   sudo tcpdump -i wlan0 -w lan.pcap 'arp or (udp dst port 67)'
+ *   ./presence_replay lan.pcap
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "presence_parse.h"
+
+#define REPLAY_TABLE_SIZE 128   // PRESENCE_TABLE_SIZE (presence.h)
+
+static uint32_t rd32(const uint8_t* p, bool swap){
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+static bool parseMacArg(const char* s, uint8_t mac[6]){
+  unsigned m[6];
+  if(sscanf(s, "%x:%x:%x:%x:%x:%x", &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) != 6) return false;
+  for(int i = 0; i < 6; i++) mac[i] = (uint8_t)m[i];
+  return true;
+}
+
+int main(int argc, char** argv){
+  const char* path = nullptr;
+  bool tableOnly = false;
+  bool expect = false;
+  uint8_t expectMac[6];
+
+  for(int i = 1; i < argc; i++){
+    if(!strcmp(argv[i], "--table-only")) tableOnly = true;
+    else if(!strcmp(argv[i], "--expect") && i + 1 < argc && parseMacArg(argv[i + 1], expectMac)){ expect = true; i++; }
+    else path = argv[i];
+  }
+  if(!path){
+    fprintf(stderr, "usage: %s capture.pcap [--table-only] [--expect MAC]\n", argv[0]);
+    return 2;
+  }
+
+  FILE* f = fopen(path, "rb");
+  if(!f){
+    perror(path);
+    return 2;
+  }
+
+  uint8_t gh[24];
+  if(fread(gh, 1, sizeof(gh), f) != sizeof(gh)){
+    fprintf(stderr, "%s: too short\n", path);
+    return 2;
+  }
+  uint32_t magic;
+  memcpy(&magic, gh, 4);
+  bool swap = magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1;
+  bool nano = magic == 0xA1B23C4D || magic == 0x4D3CB2A1;
+  if(!swap && magic != 0xA1B2C3D4 && !nano){
+    fprintf(stderr, "%s: not a classic pcap file (pcapng: convert with editcap -F pcap)\n", path);
+    return 2;
+  }
+  if(rd32(gh + 20, swap) != 1){
+    fprintf(stderr, "%s: link type %u, only Ethernet (1) is supported\n", path, rd32(gh + 20, swap));
+    return 2;
+  }
+
+  MacTable<REPLAY_TABLE_SIZE> table;
+  std::vector<uint8_t> frame;
+  uint8_t rh[16];
+  unsigned long frames = 0, seen = 0;
+  uint32_t firstMs = 0, lastMs = 0;
+
+  while(fread(rh, 1, sizeof(rh), f) == sizeof(rh)){
+    uint32_t sec = rd32(rh, swap);
+    uint32_t frac = rd32(rh + 4, swap);
+    uint32_t capLen = rd32(rh + 8, swap);
+    if(capLen > 262144) break;
+    frame.resize(capLen);
+    if(fread(frame.data(), 1, capLen, f) != capLen) break;
+    frames++;
+
+    uint32_t ms = (uint32_t)((uint64_t)sec * 1000 + (nano ? frac / 1000000 : frac / 1000));
+    if(frames == 1) firstMs = ms;
+    lastMs = ms;
+
+    PresenceSighting s;
+    if(!presenceParseFrame(frame.data(), frame.size(), s)) continue;
+    s.iface = 0;
+    s.ms = ms;
+    const auto* e = table.update(s);
+    seen++;
+    if(!tableOnly){
+      char ip[16];
+      snprintf(ip, sizeof(ip), "%u.%u.%u.%u", e->ip[0], e->ip[1], e->ip[2], e->ip[3]);
+      printf("%10.3f  %02x:%02x:%02x:%02x:%02x:%02x  %-15s  %-14s%s\n", (ms - firstMs) / 1000.0,
+             s.mac[0], s.mac[1], s.mac[2], s.mac[3], s.mac[4], s.mac[5], ip,
+             presenceKindNames[s.kind], e->count == 1 ? "  new" : "");
+    }
+  }
+  fclose(f);
+
+  printf("\n%lu frames, %lu sightings, %zu MACs (table %d, max %zu)\n",
+         frames, seen, table.size(), REPLAY_TABLE_SIZE, table.MAX_LOAD);
+  printf("%-17s  %-15s  %-14s  %8s  %6s\n", "mac", "ip", "last by", "age s", "count");
+  table.forEach([&](const MacTable<REPLAY_TABLE_SIZE>::Entry &e){
+    char ip[16];
+    snprintf(ip, sizeof(ip), "%u.%u.%u.%u", e.ip[0], e.ip[1], e.ip[2], e.ip[3]);
+    printf("%02llx:%02llx:%02llx:%02llx:%02llx:%02llx  %-15s  %-14s  %8.1f  %6u\n",
+           (unsigned long long)(e.key >> 40) & 0xFF, (unsigned long long)(e.key >> 32) & 0xFF,
+           (unsigned long long)(e.key >> 24) & 0xFF, (unsigned long long)(e.key >> 16) & 0xFF,
+           (unsigned long long)(e.key >> 8) & 0xFF, (unsigned long long)e.key & 0xFF,
+           ip, presenceKindNames[e.kind], (lastMs - e.lastMs) / 1000.0, e.count);
+  });
+
+  if(expect && !table.find(expectMac)){
+    printf("expected MAC not seen\n");
+    return 1;
+  }
+  return 0;
+}
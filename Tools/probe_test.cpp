@@ -0,0 +1,338 @@
+/*
+ * probe_test.cpp
+ * -------------------------------
+ * Host test of the probe rounds (ProbeEngine in probe_engine.h)
+ * against a mock socket layer and a fake millisecond clock:
+ *  - Each mock host answers ICMP after a given RTT (or never, or
+ *    from the n-th attempt on), and its TCP port connects, refuses
+ *    or fails after a given time
+ *  - The engine is polled every 10 ms like the probe task
+ *  - Scenarios: first-attempt reply, retries then down, reply on a
+ *    retry, TCP-only hosts, a failed connect waiting for the echo,
+ *    send errors, a late reply, 40 hosts through 16 slots (never more
+ *    than PROBE_MAX_INFLIGHT / PROBE_MAX_TCP in flight, no socket
+ *    left open), a repeated request joining the running round, and
+ *    publish only on a state change or report
+ *  - Prints each check that fails; exit code 1 if any did
+ *
+ *   g++ -std=c++17 -O2 -I.. probe_test.cpp -o probe_test
+ *   ./probe_test [--verbose]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "probe_engine.h"
+
+#define TEST_HOSTS 64
+#define TEST_STEP_MS 10   // PROBE_TASK_MS (probe.h)
+
+static int failures = 0;
+static bool verbose = false;
+
+#define CHECK(cond, ...) do { \
+  if(!(cond)){ failures++; printf("  FAIL line %d: %s: ", __LINE__, #cond); printf(__VA_ARGS__); printf("\n"); } \
+} while(0)
+
+struct HostModel {
+  int  icmpRtt = -1;       // echo reply after this many ms, -1 = never
+  int  icmpFrom = 1;       // first attempt that gets a reply
+  bool sendFails = false;  // sendto() error
+  int  tcpMs = -1;         // connect outcome after this many ms, -1 = stays pending
+  int  tcpResult = 1;      // 1 connected or refused, -1 failed (unreachable, reset)
+  bool tcpStartFails = false;
+};
+
+struct Round {
+  int      host;
+  bool     up;
+  bool     publish;
+  uint32_t at;
+};
+
+struct MockIo {
+  struct Echo { uint16_t seq; uint32_t at; };
+  struct Conn { int host; uint32_t at; int result; bool never; };
+
+  uint32_t now = 0;
+  HostModel model[TEST_HOSTS];
+  int icmpSent[TEST_HOSTS] = {};
+  int tcpStarted[TEST_HOSTS] = {};
+  std::vector<Echo> echoes;
+  std::map<int, Conn> conns;
+  int nextFd = 3;
+  unsigned replies = 0, timeouts = 0;
+  std::vector<Round> rounds;
+
+  bool sendIcmp(int host, uint16_t seq){
+    const HostModel &m = model[host];
+    if(m.sendFails) return false;
+    if(++icmpSent[host] >= m.icmpFrom && m.icmpRtt >= 0) echoes.push_back({ seq, now + m.icmpRtt });
+    return true;
+  }
+
+  bool recvIcmp(uint16_t &seq){
+    for(size_t i = 0; i < echoes.size(); i++){
+      if((int32_t)(now - echoes[i].at) < 0) continue;
+      seq = echoes[i].seq;
+      echoes.erase(echoes.begin() + i);
+      return true;
+    }
+    return false;
+  }
+
+  int startTcp(int host){
+    const HostModel &m = model[host];
+    tcpStarted[host]++;
+    if(m.tcpStartFails) return -1;
+    int fd = nextFd++;
+    conns[fd] = { host, now + (m.tcpMs < 0 ? 0 : m.tcpMs), m.tcpResult, m.tcpMs < 0 };
+    return fd;
+  }
+
+  int tcpResult(int fd){
+    auto it = conns.find(fd);
+    if(it == conns.end()){
+      printf("  FAIL: tcpResult on closed fd %d\n", fd);
+      failures++;
+      return -1;
+    }
+    const Conn &c = it->second;
+    if(c.never || (int32_t)(now - c.at) < 0) return 0;
+    return c.result;
+  }
+
+  void closeTcp(int fd){
+    if(!conns.erase(fd)){
+      printf("  FAIL: fd %d closed twice\n", fd);
+      failures++;
+    }
+  }
+
+  void onReply(uint32_t){ replies++; }
+  void onTimeout(){ timeouts++; }
+
+  void onRound(int host, const ProbeStats &s, bool publish){
+    rounds.push_back({ host, s.state == PROBE_UP, publish, now });
+    if(verbose) printf("    %6u ms  host %d %s%s\n", now, host, s.state == PROBE_UP ? "up" : "down", publish ? " (published)" : "");
+  }
+};
+
+struct Fixture {
+  MockIo io;
+  ProbeEngine<MockIo, TEST_HOSTS> engine{ io };
+  int maxInFlight = 0, maxTcp = 0;
+
+  // Polls every TEST_STEP_MS until untilMs
+  void run(uint32_t untilMs, bool tcp){
+    for(; io.now <= untilMs; io.now += TEST_STEP_MS){
+      engine.poll(io.now, tcp);
+      maxInFlight = std::max(maxInFlight, engine.inFlight());
+      maxTcp = std::max(maxTcp, engine.inFlight(true));
+    }
+  }
+
+  const Round* lastRound(int host) const {
+    for(size_t i = io.rounds.size(); i-- > 0;) if(io.rounds[i].host == host) return &io.rounds[i];
+    return nullptr;
+  }
+
+  int roundCount(int host) const {
+    int n = 0;
+    for(const auto &r : io.rounds) n += r.host == host;
+    return n;
+  }
+};
+
+static void scenario(const char* name){
+  printf("%s\n", name);
+}
+
+int main(int argc, char** argv){
+  verbose = argc > 1 && !strcmp(argv[1], "--verbose");
+
+  {
+    scenario("reply on the first attempt");
+    static Fixture f;
+    f.io.model[0].icmpRtt = 25;
+    f.engine.request(0, false);
+    f.run(2000, false);
+    const Round* r = f.lastRound(0);
+    CHECK(r && r->up, "no up round");
+    CHECK(f.roundCount(0) == 1, "%d rounds", f.roundCount(0));
+    CHECK(r && r->publish, "unknown -> up not published");
+    CHECK(f.engine.stats(0).sent == 1 && f.engine.stats(0).replies == 1, "sent %u replies %u",
+          f.engine.stats(0).sent, f.engine.stats(0).replies);
+    CHECK(f.engine.stats(0).rttMin >= 20 && f.engine.stats(0).rttMin <= 40, "rtt %u", f.engine.stats(0).rttMin);
+    CHECK(f.engine.inFlight() == 0, "%d slots still busy", f.engine.inFlight());
+  }
+
+  {
+    scenario("no reply: PROBE_ATTEMPTS timeouts, then down");
+    static Fixture f;
+    f.engine.request(0, false);
+    f.run(PROBE_ATTEMPTS * PROBE_TIMEOUT_MS + 500, false);
+    const Round* r = f.lastRound(0);
+    CHECK(r && !r->up, "no down round");
+    CHECK(f.roundCount(0) == 1, "%d rounds", f.roundCount(0));
+    CHECK(f.io.timeouts == PROBE_ATTEMPTS, "%u timeouts", f.io.timeouts);
+    CHECK(f.io.icmpSent[0] == PROBE_ATTEMPTS, "%d echoes sent", f.io.icmpSent[0]);
+    CHECK(r && r->at >= PROBE_ATTEMPTS * PROBE_TIMEOUT_MS && r->at < PROBE_ATTEMPTS * PROBE_TIMEOUT_MS + 50,
+          "down after %u ms", r ? r->at : 0);
+    CHECK(f.engine.stats(0).state == PROBE_DOWN, "state %u", f.engine.stats(0).state);
+  }
+
+  {
+    scenario("reply on the second attempt; the late first echo is ignored");
+    static Fixture f;
+    f.io.model[0].icmpRtt = 30;
+    f.io.model[0].icmpFrom = 2;
+    f.engine.request(0, false);
+    f.run(4000, false);
+    const Round* r = f.lastRound(0);
+    CHECK(r && r->up, "not up");
+    CHECK(r && r->at >= PROBE_TIMEOUT_MS + 30 && r->at < PROBE_TIMEOUT_MS + 60, "up after %u ms", r ? r->at : 0);
+    CHECK(f.io.timeouts == 1 && f.io.replies == 1, "timeouts %u replies %u", f.io.timeouts, f.io.replies);
+
+    // An echo for a slot that already timed out matches nothing
+    f.io.model[1].icmpRtt = PROBE_TIMEOUT_MS + 200;
+    f.engine.request(1, false);
+    f.run(f.io.now + PROBE_ATTEMPTS * PROBE_TIMEOUT_MS + 500, false);
+    r = f.lastRound(1);
+    CHECK(r && !r->up, "late echoes counted as replies");
+    CHECK(f.engine.stats(1).replies == 0, "%u replies", f.engine.stats(1).replies);
+  }
+
+  {
+    scenario("ICMP dropped, TCP port refuses: up");
+    static Fixture f;
+    f.io.model[0].tcpMs = 15;
+    f.engine.request(0, false);
+    f.run(1500, true);
+    const Round* r = f.lastRound(0);
+    CHECK(r && r->up && r->at < 50, "not up over TCP");
+    CHECK(f.io.conns.empty(), "%zu sockets left open", f.io.conns.size());
+  }
+
+  {
+    scenario("failed connect waits for the echo of the same attempt");
+    static Fixture f;
+    f.io.model[0].tcpMs = 5;
+    f.io.model[0].tcpResult = -1;
+    f.io.model[0].icmpRtt = 300;
+    f.engine.request(0, false);
+    f.run(1500, true);
+    const Round* r = f.lastRound(0);
+    CHECK(r && r->up && r->at >= 300, "round ended by the failed connect (at %u)", r ? r->at : 0);
+    CHECK(f.io.timeouts == 0, "%u timeouts", f.io.timeouts);
+
+    // Both fail: the attempt ends at the timeout, not at the connect error
+    f.io.model[1].tcpMs = 5;
+    f.io.model[1].tcpResult = -1;
+    uint32_t t0 = f.io.now;
+    f.engine.request(1, false);
+    f.run(t0 + PROBE_ATTEMPTS * PROBE_TIMEOUT_MS + 200, true);
+    r = f.lastRound(1);
+    CHECK(r && !r->up, "not down");
+    CHECK(f.io.tcpStarted[1] == PROBE_ATTEMPTS, "%d connects", f.io.tcpStarted[1]);
+    CHECK(r && r->at - t0 >= PROBE_ATTEMPTS * PROBE_TIMEOUT_MS, "down after %u ms", r ? r->at - t0 : 0);
+    CHECK(f.io.conns.empty(), "%zu sockets left open", f.io.conns.size());
+  }
+
+  {
+    scenario("nothing can be sent: down at once");
+    static Fixture f;
+    f.io.model[0].sendFails = true;
+    f.io.model[0].tcpStartFails = true;
+    f.engine.request(0, true);
+    f.run(0, true);
+    const Round* r = f.lastRound(0);
+    CHECK(r && !r->up && r->at == 0, "not down in the first pass");
+    CHECK(f.engine.stats(0).sent == PROBE_ATTEMPTS, "sent %u", f.engine.stats(0).sent);
+  }
+
+  {
+    scenario("40 hosts through 16 slots, TCP on");
+    static Fixture f;
+    for(int h = 0; h < 40; h++){
+      f.io.model[h].icmpRtt = h % 3 == 0 ? -1 : 5 + h;
+      f.io.model[h].tcpMs = h % 5 == 0 ? 20 : 10;      // the rest fail fast,
+      f.io.model[h].tcpResult = h % 5 == 0 ? 1 : -1;   // so the 4 TCP slots turn over
+      f.engine.request(h, false);
+    }
+    f.run(8000, true);
+    int up = 0, down = 0;
+    for(int h = 0; h < 40; h++){
+      const Round* r = f.lastRound(h);
+      CHECK(r != nullptr, "host %d never finished", h);
+      CHECK(f.roundCount(h) == 1, "host %d: %d rounds", h, f.roundCount(h));
+      bool expectUp = h % 3 != 0 || h % 5 == 0;
+      CHECK(r && r->up == expectUp, "host %d %s", h, r && r->up ? "up" : "down");
+      up += r && r->up;
+      down += r && !r->up;
+    }
+    CHECK(f.maxInFlight <= PROBE_MAX_INFLIGHT, "%d in flight", f.maxInFlight);
+    CHECK(f.maxTcp <= PROBE_MAX_TCP, "%d TCP in flight", f.maxTcp);
+    CHECK(f.maxInFlight == PROBE_MAX_INFLIGHT, "slots never all used (%d)", f.maxInFlight);
+    CHECK(f.io.conns.empty(), "%zu sockets left open", f.io.conns.size());
+    CHECK(f.engine.inFlight() == 0, "%d slots busy", f.engine.inFlight());
+    printf("  %d up, %d down, at most %d in flight (%d TCP)\n", up, down, f.maxInFlight, f.maxTcp);
+  }
+
+  {
+    scenario("a request during a round joins it and keeps its report flag");
+    static Fixture f;
+    f.io.model[0].icmpRtt = 400;
+    f.engine.request(0, false);
+    f.run(100, false);
+    f.engine.request(0, true);
+    CHECK(f.engine.running(0), "round not running");
+    f.run(1000, false);
+    CHECK(f.roundCount(0) == 1, "%d rounds", f.roundCount(0));
+    CHECK(f.io.icmpSent[0] == 1, "%d echoes", f.io.icmpSent[0]);
+
+    scenario("same state again: published only when reported");
+    f.engine.request(0, false);
+    f.run(2000, false);
+    const Round* r = f.lastRound(0);
+    CHECK(f.roundCount(0) == 2 && r && !r->publish, "unchanged state published");
+    f.engine.request(0, true);
+    f.run(3000, false);
+    r = f.lastRound(0);
+    CHECK(f.roundCount(0) == 3 && r && r->publish, "reported round not published");
+
+    f.io.model[0].icmpRtt = -1;
+    f.engine.request(0, false);
+    f.run(7000, false);
+    r = f.lastRound(0);
+    CHECK(r && !r->up && r->publish, "up -> down not published");
+  }
+
+  {
+    scenario("markUp leaves the RTT figures alone");
+    static Fixture f;
+    CHECK(f.engine.markUp(5) == PROBE_UNKNOWN, "previous state");
+    CHECK(f.engine.stats(5).state == PROBE_UP && f.engine.stats(5).sent == 0, "stats changed");
+  }
+
+  {
+    scenario("echo request / reply");
+    uint8_t pkt[PROBE_ECHO_LEN];
+    probeEchoRequest(pkt, 0x1234);
+    CHECK(probeChecksum(pkt, sizeof(pkt)) == 0, "checksum does not verify");
+    uint8_t ip[20 + PROBE_ECHO_LEN] = { 0x45 };
+    memcpy(ip + 20, pkt, sizeof(pkt));
+    uint16_t seq = 0;
+    CHECK(!probeEchoReply(ip, sizeof(ip), seq), "echo request taken as a reply");
+    ip[20] = 0;
+    CHECK(probeEchoReply(ip, sizeof(ip), seq) && seq == 0x1234, "reply not matched (seq %04x)", seq);
+    ip[25] ^= 1;
+    CHECK(!probeEchoReply(ip, sizeof(ip), seq), "foreign id matched");
+    CHECK(!probeEchoReply(ip, 24, seq), "truncated reply matched");
+  }
+
+  printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}
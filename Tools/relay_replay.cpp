@@ -0,0 +1,177 @@
+/*
+ * relay_replay.cpp
+ * -------------------------------
+ * Replays a pcap capture through the firmware's WOL relay filter
+ * (relay_parse.h), on Linux:
+ *  - Classic pcap (tcpdump -w), Ethernet link type, either byte
+ *    order, micro- or nanosecond timestamps
+ *  - Every IPv4 UDP datagram to port 7 or 9 (what the relay listens
+ *    on) is checked with the capture's timestamps, so the per-MAC
+ *    interval applies as on the device; raw EtherType 0x0842 magic
+ *    packets are counted but, like on the device, not relayed
+ *  - --allow MAC (repeatable) is the allowlist, the fleet MACs on
+ *    the device; without it every MAC is allowed when first seen
+ *  - Prints each verdict (--quiet: only the totals);
+ *    --expect-forwarded N exits 1 unless N packets were forwarded
+ *
+ *   g++ -std=c++17 -O2 -I.. relay_replay.cpp -o relay_replay
+ *   sudo tcpdump -i wlan0 -w wol.pcap 'udp port 7 or udp port 9 or ether proto 0x0842'
+ *   ./relay_replay wol.pcap --allow AA:BB:CC:DD:EE:01
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "relay_parse.h"
+
+#define REPLAY_ALLOW_MAX 256   // FLEET_MAX_HOSTS (fleet.h)
+
+static uint32_t rd32(const uint8_t* p, bool swap){
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+static uint16_t be16(const uint8_t* p){ return (uint16_t)(p[0] << 8 | p[1]); }
+
+static bool parseMacArg(const char* s, uint8_t mac[6]){
+  unsigned m[6];
+  if(sscanf(s, "%x:%x:%x:%x:%x:%x", &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) != 6) return false;
+  for(int i = 0; i < 6; i++) mac[i] = (uint8_t)m[i];
+  return true;
+}
+
+// Ethernet II (optionally 802.1Q) -> UDP payload to port 7/9; 0x0842 sets raw
+static bool udpPayload(const uint8_t* f, size_t len, const uint8_t*& payload, size_t &plen,
+                       uint16_t &port, uint8_t src[4], bool &raw){
+  raw = false;
+  if(len < 14) return false;
+  size_t off = 12;
+  uint16_t type = be16(f + off);
+  if(type == 0x8100){
+    if(len < 18) return false;
+    off += 4;
+    type = be16(f + off);
+  }
+  off += 2;
+  const uint8_t* p = f + off;
+  len -= off;
+  if(type == 0x0842){
+    raw = true;
+    return false;
+  }
+  if(type != 0x0800 || len < 20 || (p[0] >> 4) != 4 || p[9] != 17) return false;
+  if(be16(p + 6) & 0x3FFF) return false;   // fragment
+  size_t ihl = (p[0] & 0x0F) * 4;
+  if(ihl < 20 || len < ihl + 8) return false;
+  const uint8_t* udp = p + ihl;
+  port = be16(udp + 2);
+  if(port != 7 && port != 9) return false;
+  size_t udpLen = be16(udp + 4);
+  if(udpLen < 8 || udpLen > len - ihl) return false;   // truncated capture
+  memcpy(src, p + 12, 4);
+  payload = udp + 8;
+  plen = udpLen - 8;
+  return true;
+}
+
+int main(int argc, char** argv){
+  const char* path = nullptr;
+  bool quiet = false;
+  long expect = -1;
+  std::vector<uint64_t> allow;
+
+  for(int i = 1; i < argc; i++){
+    uint8_t mac[6];
+    if(!strcmp(argv[i], "--quiet")) quiet = true;
+    else if(!strcmp(argv[i], "--allow") && i + 1 < argc && parseMacArg(argv[i + 1], mac)){ allow.push_back(relayMacKey(mac)); i++; }
+    else if(!strcmp(argv[i], "--expect-forwarded") && i + 1 < argc) expect = atol(argv[++i]);
+    else path = argv[i];
+  }
+  if(!path){
+    fprintf(stderr, "usage: %s capture.pcap [--allow MAC]... [--quiet] [--expect-forwarded N]\n", argv[0]);
+    return 2;
+  }
+
+  FILE* f = fopen(path, "rb");
+  if(!f){
+    perror(path);
+    return 2;
+  }
+
+  uint8_t gh[24];
+  if(fread(gh, 1, sizeof(gh), f) != sizeof(gh)){
+    fprintf(stderr, "%s: too short\n", path);
+    return 2;
+  }
+  uint32_t magic;
+  memcpy(&magic, gh, 4);
+  bool swap = magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1;
+  bool nano = magic == 0xA1B23C4D || magic == 0x4D3CB2A1;
+  if(!swap && magic != 0xA1B2C3D4 && !nano){
+    fprintf(stderr, "%s: not a classic pcap file (pcapng: convert with editcap -F pcap)\n", path);
+    return 2;
+  }
+  if(rd32(gh + 20, swap) != 1){
+    fprintf(stderr, "%s: link type %u, only Ethernet (1) is supported\n", path, rd32(gh + 20, swap));
+    return 2;
+  }
+
+  static RelayFilter<REPLAY_ALLOW_MAX> filter;
+  bool allowAll = allow.empty();
+  if(!allowAll) filter.setAllowed(allow.size(), [&](size_t i){ return allow[i]; });
+
+  std::vector<uint8_t> frame;
+  uint8_t rh[16];
+  unsigned long frames = 0, datagrams = 0, raw = 0;
+  unsigned long verdicts[RELAY_VERDICT_COUNT] = { 0 };
+  uint32_t firstMs = 0;
+
+  while(fread(rh, 1, sizeof(rh), f) == sizeof(rh)){
+    uint32_t sec = rd32(rh, swap);
+    uint32_t frac = rd32(rh + 4, swap);
+    uint32_t capLen = rd32(rh + 8, swap);
+    if(capLen > 262144) break;
+    frame.resize(capLen);
+    if(fread(frame.data(), 1, capLen, f) != capLen) break;
+    frames++;
+
+    uint32_t ms = (uint32_t)((uint64_t)sec * 1000 + (nano ? frac / 1000000 : frac / 1000));
+    if(frames == 1) firstMs = ms;
+
+    const uint8_t* p;
+    size_t len;
+    uint16_t port;
+    uint8_t src[4], mac[6];
+    bool isRaw;
+    if(!udpPayload(frame.data(), frame.size(), p, len, port, src, isRaw)){
+      raw += isRaw;
+      continue;
+    }
+    datagrams++;
+
+    if(allowAll && wolMagicValid(p, len, mac)) filter.allow(relayMacKey(mac));
+    RelayVerdict v = filter.check(p, len, ms, mac);
+    verdicts[v]++;
+    if(quiet) continue;
+    if(v == RELAY_INVALID)
+      printf("%10.3f  %u.%u.%u.%u:%-2u  %-17s  %4zu B  %s\n", (ms - firstMs) / 1000.0,
+             src[0], src[1], src[2], src[3], port, "-", len, relayVerdictNames[v]);
+    else
+      printf("%10.3f  %u.%u.%u.%u:%-2u  %02x:%02x:%02x:%02x:%02x:%02x  %4zu B  %s\n", (ms - firstMs) / 1000.0,
+             src[0], src[1], src[2], src[3], port, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], len,
+             relayVerdictNames[v]);
+  }
+  fclose(f);
+
+  printf("\n%lu frames, %lu datagrams to port 7/9, %lu raw 0x0842 (not relayed); allowlist %s\n",
+         frames, datagrams, raw, allowAll ? "every MAC seen" : "from --allow");
+  for(int v = 0; v < RELAY_VERDICT_COUNT; v++) printf("  %-13s %lu\n", relayVerdictNames[v], verdicts[v]);
+
+  if(expect >= 0 && verdicts[RELAY_FORWARD] != (unsigned long)expect){
+    printf("expected %ld forwarded, got %lu\n", expect, verdicts[RELAY_FORWARD]);
+    return 1;
+  }
+  return 0;
+}
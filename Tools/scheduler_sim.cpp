@@ -0,0 +1,271 @@
+/*
+ * scheduler_sim.cpp
+ * -------------------------------
+ * Loop latency on a fake clock: the firmware's scheduler.cpp,
+ * built for the host (host/Arduino.h), against a model of the
+ * delay()-based loop it replaced:
+ *  - The same scripted minute for both: broker unreachable for the
+ *    first 8 s, Wi-Fi association 4 s at boot, a Wi-Fi outage from
+ *    30 s to 42 s, MQTT commands with LED blinks at 5, 20 and 50 s
+ *  - "delay loop": setupWiFi() waits for the link, ensureMqtt()
+ *    retries every 2 s until the broker answers, blinkDigit() takes
+ *    300 ms per blink, all inside loop()
+ *  - "scheduler": loop() runs schedulerRun() with the tasks the
+ *    firmware puts on the loop task, each costing a few hundred us
+ *    (MQTT, blinking and buttons have their own tasks there)
+ *  - The time between loop() iterations is the latency: max, p99
+ *    and median per model; exit code 1 if the scheduler's worst case
+ *    exceeds --max-ms
+ *  - Also checks the scheduler itself: intervals kept, a one-shot
+ *    task re-armed from its own callback, cancel, table full
+ *
+ *   g++ -std=c++17 -O2 -Ihost -I.. scheduler_sim.cpp ../scheduler.cpp -o scheduler_sim
+ *   ./scheduler_sim [--seconds 60] [--max-ms 20]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "scheduler.h"
+
+static uint64_t nowUs = 0;
+
+unsigned long millis(){
+  return (unsigned long)(nowUs / 1000);
+}
+
+static void spend(uint64_t us){
+  nowUs += us;
+}
+
+// ---- The scripted minute ----
+
+#define BROKER_UP_AT_MS     8000
+#define WIFI_ASSOC_MS       4000
+#define WIFI_DOWN_FROM_MS   30000
+#define WIFI_DOWN_UNTIL_MS  42000
+#define CONNECT_FAIL_US     300000    // failed TCP/TLS connect to the broker
+#define CONNECT_OK_US       250000    // TLS handshake
+
+struct ScriptedCommand {
+  uint32_t at;
+  int      blinks;
+};
+
+static const ScriptedCommand commands[] = { { 5000, 3 }, { 20000, 5 }, { 50000, 2 } };
+
+static bool wifiUp(){
+  uint64_t ms = nowUs / 1000;
+  return ms >= WIFI_ASSOC_MS && !(ms >= WIFI_DOWN_FROM_MS && ms < WIFI_DOWN_UNTIL_MS);
+}
+
+static bool brokerUp(){
+  return wifiUp() && nowUs / 1000 >= BROKER_UP_AT_MS;
+}
+
+// ---- Latency between loop() iterations ----
+
+struct Gaps {
+  std::vector<uint32_t> us;
+  uint64_t last = 0;
+
+  void mark(){
+    if(last) us.push_back((uint32_t)(nowUs - last));
+    last = nowUs;
+  }
+
+  void print(const char* name){
+    std::vector<uint32_t> s = us;
+    std::sort(s.begin(), s.end());
+    if(s.empty()) return;
+    printf("%-12s %8zu iterations  max %9.1f ms  p99 %7.2f ms  median %6.2f ms\n", name, s.size(),
+           s.back() / 1000.0, s[s.size() * 99 / 100] / 1000.0, s[s.size() / 2] / 1000.0);
+  }
+
+  uint32_t worst() const { return us.empty() ? 0 : *std::max_element(us.begin(), us.end()); }
+};
+
+// ---- The delay() loop ----
+
+static void runDelayLoop(uint64_t endUs, Gaps &gaps){
+  nowUs = 0;
+  size_t nextCmd = 0;
+  bool connected = false;
+
+  // setupWiFi(): 500 ms polls until associated (up to 30)
+  for(int i = 0; i < 30 && !wifiUp(); i++) spend(500000);
+
+  while(nowUs < endUs){
+    gaps.mark();
+    if(!wifiUp()) connected = false;
+
+    // ensureMqtt()
+    while(!connected && nowUs < endUs){
+      if(brokerUp()){
+        spend(CONNECT_OK_US);
+        connected = true;
+      } else {
+        spend(CONNECT_FAIL_US);
+        spend(2000000);
+      }
+    }
+
+    // mqttLoop() -> mqttCallback() -> blinkDigit()
+    if(connected && nextCmd < sizeof(commands) / sizeof(commands[0]) && nowUs / 1000 >= commands[nextCmd].at){
+      spend(commands[nextCmd].blinks * 300000ULL);
+      nextCmd++;
+    }
+
+    spend(200);    // handleButton(), handleScheduledPing(), server.handleClient()
+    spend(1000);   // delay(1)
+  }
+}
+
+// ---- The scheduler loop: the loop task's timers with their cost ----
+
+static bool wifiLinked = false;
+static int  pendingCmd = 0;
+static unsigned calls[16];
+
+#define SIM_TASK(fn, idx, us) static void fn(){ calls[idx]++; spend(us); }
+SIM_TASK(stateTask, 1, 300)          // retained state diff, posts to the mqtt task
+SIM_TASK(metricsTask, 2, 400)
+SIM_TASK(wakeWatchTask, 3, 50)
+SIM_TASK(probeDispatch, 4, 20)
+SIM_TASK(buttonDispatch, 5, 10)
+SIM_TASK(wsTask, 6, 80)
+SIM_TASK(presenceTask, 7, 100)
+SIM_TASK(handleScheduledPing, 8, 20)
+SIM_TASK(agentDispatch, 9, 20)
+SIM_TASK(otaPoll, 10, 50)
+
+// wifiTask(): WiFi.status() each poll, WiFi.begin() / linkUp() on a change
+static void wifiTask(){
+  calls[0]++;
+  spend(150);
+  bool up = wifiUp();
+  if(up != wifiLinked){
+    spend(2500);
+    wifiLinked = up;
+  }
+}
+
+// otaFirstCheck(): one-shot that re-arms itself once
+static int rearmed = 0;
+static void otaFirstCheck(){
+  calls[11]++;
+  spend(5000);
+  if(rearmed++ == 0) schedulerAfter(10000, otaFirstCheck);
+}
+
+// commandPump(): a queued command runs and queues its blinks for the ui task
+static void commandPump(){
+  static size_t nextCmd = 0;
+  if(nextCmd < sizeof(commands) / sizeof(commands[0]) && brokerUp() && nowUs / 1000 >= commands[nextCmd].at){
+    spend(600);
+    pendingCmd++;
+    nextCmd++;
+  }
+}
+
+static const unsigned long intervals[11] = {
+  100, 100, 1000, 100, 10, 2, 10, 50, 100, 20, 1000   // WIFI_POLL_MS ... OTA_POLL_MS
+};
+
+static void runSchedulerLoop(uint64_t endUs, Gaps &gaps){
+  nowUs = 0;
+  schedulerEvery(intervals[0], wifiTask);
+  schedulerEvery(intervals[1], stateTask);
+  schedulerEvery(intervals[2], metricsTask);
+  schedulerEvery(intervals[3], wakeWatchTask);
+  schedulerEvery(intervals[4], probeDispatch);
+  schedulerEvery(intervals[5], buttonDispatch);
+  schedulerEvery(intervals[6], wsTask);
+  schedulerEvery(intervals[7], presenceTask);
+  schedulerEvery(intervals[8], handleScheduledPing);
+  schedulerEvery(intervals[9], agentDispatch);
+  schedulerEvery(intervals[10], otaPoll);
+  schedulerAfter(15000, otaFirstCheck);
+
+  while(nowUs < endUs){
+    gaps.mark();
+    schedulerRun();
+    commandPump();
+    spend(50);     // server.handleClient() with nothing pending
+    spend(1000);   // delay(1)
+  }
+}
+
+// ---- Scheduler checks ----
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+  if(!(cond)){ failures++; printf("FAIL: %s: ", #cond); printf(__VA_ARGS__); printf("\n"); } \
+} while(0)
+
+static void noop(){}
+static unsigned cancelledRuns = 0;
+static void cancelled(){ cancelledRuns++; }
+
+static void checkScheduler(double seconds){
+  for(int i = 0; i < 11; i++){
+    double expect = seconds * 1000 / intervals[i];
+    // A loop pass takes over 1 ms, so the 2 ms task runs at most every 3 ms
+    double low = intervals[i] < 10 ? expect / 2 : expect * 0.9;
+    CHECK(calls[i] >= low && calls[i] <= expect * 1.01, "task %d ran %u times, expected about %.0f", i, calls[i], expect);
+  }
+  CHECK(calls[11] == 2, "one-shot ran %u times, expected 2 (re-armed once)", calls[11]);
+  CHECK(pendingCmd == 3, "%d commands run", pendingCmd);
+
+  int id = schedulerEvery(5, cancelled);
+  CHECK(id >= 0, "no free slot");
+  for(int i = 0; i < 3; i++){
+    spend(6000);
+    schedulerRun();
+  }
+  schedulerCancel(id);
+  unsigned before = cancelledRuns;
+  for(int i = 0; i < 3; i++){
+    spend(6000);
+    schedulerRun();
+  }
+  CHECK(cancelledRuns == 3 && before == 3, "ran %u times before / %u after cancel", before, cancelledRuns - before);
+
+  std::vector<int> ids;
+  int r;
+  while((r = schedulerAfter(1000, noop)) >= 0) ids.push_back(r);
+  CHECK(ids.size() == SCHEDULER_MAX_TASKS - 11, "%zu free slots", ids.size());
+  for(int i : ids) schedulerCancel(i);
+}
+
+int main(int argc, char** argv){
+  double seconds = 60;
+  double maxMs = 20;
+  for(int i = 1; i < argc; i++){
+    if(!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+    else if(!strcmp(argv[i], "--max-ms") && i + 1 < argc) maxMs = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--seconds S] [--max-ms MS]\n", argv[0]);
+      return 2;
+    }
+  }
+  uint64_t endUs = (uint64_t)(seconds * 1e6);
+
+  Gaps before, after;
+  runDelayLoop(endUs, before);
+  runSchedulerLoop(endUs, after);
+
+  printf("%.0f s simulated: broker back at %d s, Wi-Fi down %d-%d s, %zu commands with blinks\n\n", seconds,
+         BROKER_UP_AT_MS / 1000, WIFI_DOWN_FROM_MS / 1000, WIFI_DOWN_UNTIL_MS / 1000, sizeof(commands) / sizeof(commands[0]));
+  before.print("delay loop");
+  after.print("scheduler");
+  printf("\n");
+
+  checkScheduler(seconds);
+  CHECK(after.worst() <= maxMs * 1000, "scheduler loop stalled %.1f ms (limit %.1f)", after.worst() / 1000.0, maxMs);
+  printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}
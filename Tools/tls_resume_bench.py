@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""
+tls_resume_bench.py
+-------------------------------
+MQTT-over-TLS reconnect cost with and without session resumption,
+against a local mosquitto TLS listener (no extra packages needed)
+ - host:   reconnects from this machine, alternating a full handshake
+           and one that offers the previous session; per kind the
+           TCP connect, TLS handshake and CONNACK times and how many
+           sessions the broker actually resumed
+ - device: kicks the ESP32 off the broker by connecting with its
+           client id (ESP32C3-WOL), so it reconnects at once, and
+           collects the "TLS: Handshake ... heap peak ..." and
+           "MQTT: Connected in ..." lines it logs on wol/log.
+           Reconnects that offered the cached session and those
+           that did not are reported apart: handshake ms, heap peak
+           and the lowest free heap. The first connect after power-on
+           is always full; for the device's numbers without
+           resumption, run it again on a build with TLS_NO_RESUME
+           (tls_client.h)
+
+  python3 tls_resume_bench.py host   --broker 127.0.0.1 --port 8883 -n 50
+  python3 tls_resume_bench.py device --broker 192.168.1.10 --user u --password p -n 20
+
+mosquitto.conf for a local test broker:
+  listener 8883
+  certfile server.crt
+  keyfile server.key
+  allow_anonymous true
+"""
+import argparse
+import re
+import socket
+import ssl
+import statistics
+import struct
+import time
+
+DEVICE_ID = "ESP32C3-WOL"
+TLS_LINE = re.compile(r"TLS: Handshake (\d+) ms( \(cached session offered\))?, heap peak (\d+), min free (\d+)")
+MQTT_LINE = re.compile(r"MQTT: Connected in (\d+) ms")
+
+
+def ms_since(t0):
+    return (time.perf_counter() - t0) * 1000
+
+
+def report(name, samples, unit="ms"):
+    if not samples:
+        print(f"  {name:18s} no samples")
+        return
+    s = sorted(samples)
+    p95 = s[min(len(s) - 1, int(len(s) * 0.95))]
+    print(f"  {name:18s} n={len(s):3d}  min {s[0]:8.1f}  median {statistics.median(s):8.1f}  "
+          f"p95 {p95:8.1f}  max {s[-1]:8.1f} {unit}")
+
+
+# ---- A minimal MQTT 3.1.1 client ----
+
+def encode_str(s):
+    b = s.encode()
+    return struct.pack("!H", len(b)) + b
+
+
+def packet(kind, body):
+    n, rl = len(body), b""
+    while True:
+        d, n = n & 0x7F, n >> 7
+        rl += bytes([d | (0x80 if n else 0)])
+        if not n:
+            return bytes([kind]) + rl + body
+
+
+class Mqtt:
+    def __init__(self, args, ctx, client_id, session=None):
+        t0 = time.perf_counter()
+        raw = socket.create_connection((args.broker, args.port), timeout=10)
+        raw.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.tcp_ms = ms_since(t0)
+        t1 = time.perf_counter()
+        self.sock = ctx.wrap_socket(raw, server_hostname=args.broker, session=session)
+        self.tls_ms = ms_since(t1)
+
+        flags, payload = 0x02, encode_str(client_id)   # clean session
+        if args.user:
+            flags |= 0x80
+            payload += encode_str(args.user)
+            if args.password:
+                flags |= 0x40
+                payload += encode_str(args.password)
+        self.sock.sendall(packet(0x10, encode_str("MQTT") + bytes([4, flags]) + struct.pack("!H", 60) + payload))
+        kind, body = self.read()
+        if kind != 0x20 or body[1] != 0:
+            raise SystemExit(f"CONNACK refused ({body[1] if len(body) > 1 else '?'})")
+        self.total_ms = ms_since(t0)
+        self.buf = b""
+
+    def _recv(self, n):
+        data = b""
+        while len(data) < n:
+            c = self.sock.recv(n - len(data))
+            if not c:
+                raise ConnectionError("broker closed the connection")
+            data += c
+        return data
+
+    def read(self):
+        kind = self._recv(1)[0]
+        n, shift = 0, 0
+        while True:
+            d = self._recv(1)[0]
+            n |= (d & 0x7F) << shift
+            shift += 7
+            if not d & 0x80:
+                break
+        return kind & 0xF0, self._recv(n)
+
+    def subscribe(self, topic):
+        self.sock.sendall(packet(0x82, struct.pack("!H", 1) + encode_str(topic) + b"\x00"))
+
+    def ping(self):
+        self.sock.sendall(b"\xc0\x00")
+
+    def close(self):
+        try:
+            self.sock.sendall(b"\xe0\x00")
+            self.sock.close()
+        except OSError:
+            pass
+
+
+def context(args):
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    if args.cafile:
+        ctx.load_verify_locations(args.cafile)
+    else:
+        ctx.check_hostname = False
+        ctx.verify_mode = ssl.CERT_NONE
+    if args.tls12:
+        ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    return ctx
+
+
+# ---- host ----
+
+def bench_host(args):
+    ctx = context(args)
+    kinds = {"full": {"tcp": [], "tls": [], "connack": [], "reused": 0},
+             "resumed": {"tcp": [], "tls": [], "connack": [], "reused": 0}}
+    session = None
+    version = "?"
+    for i in range(args.n * 2):
+        kind = "full" if i % 2 == 0 else "resumed"
+        c = Mqtt(args, ctx, f"tls-bench-{i}", session if kind == "resumed" else None)
+        k = kinds[kind]
+        k["tcp"].append(c.tcp_ms)
+        k["tls"].append(c.tls_ms)
+        k["connack"].append(c.total_ms)
+        k["reused"] += c.sock.session_reused
+        version = c.sock.version()
+        session = c.sock.session   # ticket arrives with the first records, read by now
+        c.close()
+        time.sleep(args.gap)
+
+    print(f"{args.broker}:{args.port} {version}, {args.n} connects of each kind")
+    for kind, k in kinds.items():
+        print(f"{kind} handshake ({k['reused']} of {args.n} resumed by the broker)")
+        report("TCP connect", k["tcp"])
+        report("TLS handshake", k["tls"])
+        report("until CONNACK", k["connack"])
+
+
+# ---- device ----
+
+def bench_device(args):
+    ctx = context(args)
+    sub = Mqtt(args, ctx, f"tls-bench-sub-{int(time.time())}")
+    sub.subscribe("wol/log")
+    sub.sock.settimeout(1)
+    got = {"offered": [], "full": []}
+    connects = []
+    last_ping = time.monotonic()
+
+    def wait_lines(deadline):
+        nonlocal last_ping
+        tls = mqtt = None
+        while time.monotonic() < deadline and (tls is None or mqtt is None):
+            if time.monotonic() - last_ping > 30:
+                sub.ping()
+                last_ping = time.monotonic()
+            try:
+                kind, body = sub.read()
+            except socket.timeout:
+                continue
+            if kind != 0x30:
+                continue
+            tlen = struct.unpack("!H", body[:2])[0]
+            text = body[2 + tlen:].decode(errors="replace")
+            for line in text.splitlines():
+                m = TLS_LINE.search(line)
+                if m:
+                    tls = m
+                m = MQTT_LINE.search(line)
+                if m:
+                    mqtt = int(m.group(1))
+        return tls, mqtt
+
+    for i in range(args.n):
+        kick = Mqtt(args, ctx, DEVICE_ID)   # the broker drops the device's connection
+        kick.close()
+        tls, mqtt = wait_lines(time.monotonic() + args.timeout)
+        if tls is None:
+            print(f"reconnect {i + 1}: no handshake line on wol/log within {args.timeout:.0f} s")
+            continue
+        offered = bool(tls.group(2))
+        got["offered" if offered else "full"].append(tls)
+        if mqtt is not None:
+            connects.append((offered, mqtt))
+        print(f"reconnect {i + 1:3d}: handshake {tls.group(1):>5s} ms{' (session offered)' if offered else '':19s} "
+              f"heap peak {tls.group(3):>6s}  min free {tls.group(4):>6s}")
+        time.sleep(args.gap)
+    sub.close()
+
+    for kind, rows in (("cached session offered", got["offered"]), ("full handshake", got["full"])):
+        print(f"{kind}:")
+        report("TLS handshake", [int(m.group(1)) for m in rows])
+        report("MQTT connect", [ms for o, ms in connects if o == (kind != "full handshake")])
+        report("heap peak", [int(m.group(3)) for m in rows], "B")
+        report("min free heap", [int(m.group(4)) for m in rows], "B")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="MQTT TLS reconnect cost with and without session resumption")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    for name in ("host", "device"):
+        p = sub.add_parser(name)
+        p.add_argument("--broker", default="127.0.0.1")
+        p.add_argument("--port", type=int, default=8883)
+        p.add_argument("--cafile", help="verify the broker against this CA (default: not verified)")
+        p.add_argument("--user")
+        p.add_argument("--password")
+        p.add_argument("--tls12", action="store_true", help="cap at TLS 1.2 (session IDs instead of tickets)")
+        p.add_argument("-n", type=int, default=20, help="connects of each kind / device reconnects")
+        p.add_argument("--gap", type=float, default=0.2 if name == "host" else 3, help="pause between connects, s")
+        if name == "device":
+            p.add_argument("--timeout", type=float, default=90, help="wait for the device's log lines, s")
+    args = ap.parse_args()
+    bench_host(args) if args.cmd == "host" else bench_device(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""
+wol_agent.py
+-------------------------------
+Reference host agent (Linux) for the acknowledged shutdown / wake
+protocol (agent.h), plus a sender that plays the ESP32's part
+ - serve: answers signed requests for this machine's MAC at once
+          ("shutting_down" / "awake"), then runs --exec for a
+          shutdown; the last sequence is kept in --state so replays
+          are refused and resends are re-acked without acting
+ - send:  signs requests like the firmware (same resend back-off)
+          and reports the request -> ack round trip
+Both on one machine, no root needed with a high port:
+
+  python3 wol_agent.py serve --key K --port 40009 --mac 02:00:00:00:00:01
+  python3 wol_agent.py send  --key K --port 40009 --mac 02:00:00:00:00:01 -n 200
+
+Datagram (40 bytes): "WOLA", version, type, status, attempt,
+sequence (u64 BE), MAC, 2 reserved, HMAC-SHA256(key, first 24)[:16]
+"""
+import argparse
+import hashlib
+import hmac
+import os
+import socket
+import statistics
+import struct
+import subprocess
+import sys
+import time
+
+MAGIC = b"WOLA"
+VERSION = 1
+HEAD = struct.Struct("!4sBBBBQ6s2x")
+PKT_LEN = HEAD.size + 16
+
+SHUTDOWN, WAKE, ACK = 1, 2, 0x80
+ST_TIMEOUT, ST_SHUTTING_DOWN, ST_AWAKE, ST_REFUSED = 0, 1, 2, 3
+TYPES = {"shutdown": SHUTDOWN, "wake": WAKE}
+STATUS = {ST_SHUTTING_DOWN: "shutting_down", ST_AWAKE: "awake", ST_REFUSED: "refused"}
+
+RESEND_FIRST_MS = 100
+RESEND_MAX_MS = 1000
+ACK_WAIT_MS = 2000
+
+
+def pack(key, ptype, status, attempt, seq, mac):
+    head = HEAD.pack(MAGIC, VERSION, ptype, status, attempt, seq, mac)
+    return head + hmac.new(key, head, hashlib.sha256).digest()[:16]
+
+
+def unpack(key, data):
+    """(type, status, attempt, seq, mac) of a valid datagram, else None"""
+    if len(data) != PKT_LEN or data[:4] != MAGIC or data[4] != VERSION:
+        return None
+    head = data[:HEAD.size]
+    if not hmac.compare_digest(hmac.new(key, head, hashlib.sha256).digest()[:16], data[HEAD.size:]):
+        return None
+    _, _, ptype, status, attempt, seq, mac = HEAD.unpack(head)
+    return ptype, status, attempt, seq, mac
+
+
+def parse_mac(s):
+    return bytes.fromhex(s.replace(":", "").replace("-", ""))
+
+
+def local_mac(iface):
+    names = [iface] if iface else sorted(n for n in os.listdir("/sys/class/net") if n != "lo")
+    for n in names:
+        try:
+            with open(f"/sys/class/net/{n}/address") as f:
+                mac = f.read().strip()
+            if mac and mac != "00:00:00:00:00:00":
+                return parse_mac(mac)
+        except OSError:
+            pass
+    raise SystemExit("no MAC address found, use --mac")
+
+
+def get_key(args):
+    key = args.key or os.environ.get("WOL_AGENT_KEY", "")
+    if not key:
+        raise SystemExit("set --key or WOL_AGENT_KEY (same as agent_key in the ESP32 config)")
+    return key.encode()
+
+
+# ---- serve ----
+
+class SeqState:
+    """Highest sequence seen and the status it was acked with"""
+
+    def __init__(self, path):
+        self.path = path
+        self.seq, self.status = 0, 0
+        try:
+            with open(path) as f:
+                s, st = f.read().split()
+                self.seq, self.status = int(s), int(st)
+        except (OSError, ValueError):
+            pass
+
+    def store(self, seq, status):
+        self.seq, self.status = seq, status
+        tmp = self.path + ".tmp"
+        with open(tmp, "w") as f:
+            f.write(f"{seq} {status}\n")
+        os.replace(tmp, self.path)
+
+
+def serve(args):
+    key = get_key(args)
+    mac = parse_mac(args.mac) if args.mac else local_mac(args.iface)
+    state = SeqState(os.path.expanduser(args.state))
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("0.0.0.0", args.port))
+    print(f"agent: port {args.port}, MAC {mac.hex(':')}, last seq {state.seq}", flush=True)
+
+    while True:
+        data, addr = sock.recvfrom(2048)
+        msg = unpack(key, data)
+        if not msg:
+            continue
+        ptype, _, attempt, seq, pmac = msg
+        if ptype not in (SHUTDOWN, WAKE) or pmac != mac:
+            continue
+
+        if seq < state.seq:
+            print(f"agent: replayed seq {seq} from {addr[0]} ignored", flush=True)
+            continue
+        fresh = seq > state.seq
+        status = (ST_SHUTTING_DOWN if ptype == SHUTDOWN else ST_AWAKE) if fresh else state.status
+        if fresh:
+            state.store(seq, status)
+
+        sock.sendto(pack(key, ACK | ptype, status, attempt, seq, mac), addr)
+        print(f"agent: {'shutdown' if ptype == SHUTDOWN else 'wake'} seq {seq} attempt {attempt} "
+              f"from {addr[0]} -> {STATUS[status]}{'' if fresh else ' (resend)'}", flush=True)
+
+        if fresh and ptype == SHUTDOWN and args.exec:
+            subprocess.Popen(args.exec, shell=True)
+
+
+# ---- send ----
+
+def send_one(sock, key, dst, ptype, seq, mac, tries):
+    """Firmware resend schedule; (status, attempts, rtt_ms of the acked attempt)"""
+    sent = {}
+    interval = RESEND_FIRST_MS
+    for attempt in range(1, tries + 1):
+        sent[attempt] = time.perf_counter()
+        sock.sendto(pack(key, ptype, 0, attempt, seq, mac), dst)
+        wait = (interval if attempt < tries else ACK_WAIT_MS) / 1000
+        interval = min(interval * 2, RESEND_MAX_MS)
+        deadline = sent[attempt] + wait
+        while (left := deadline - time.perf_counter()) > 0:
+            sock.settimeout(left)
+            try:
+                data, _ = sock.recvfrom(2048)
+            except socket.timeout:
+                break
+            now = time.perf_counter()
+            msg = unpack(key, data)
+            if not msg or msg[0] != ACK | ptype or msg[3] != seq or msg[4] != mac:
+                continue
+            acked = msg[2] if msg[2] in sent else attempt
+            return msg[1], attempt, (now - sent[acked]) * 1000
+    return ST_TIMEOUT, tries, None
+
+
+def send(args):
+    key = get_key(args)
+    mac = parse_mac(args.mac) if args.mac else local_mac(args.iface)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    dst = (args.host, args.port)
+
+    rtts, resends, lost = [], 0, 0
+    for _ in range(args.n):
+        seq = time.time_ns()   # grows across runs, like the firmware's NVS counter
+        status, attempts, rtt = send_one(sock, key, dst, TYPES[args.type], seq, mac, args.tries)
+        resends += attempts - 1
+        if rtt is None:
+            lost += 1
+        else:
+            rtts.append(rtt)
+        if args.n == 1:
+            print(f"{args.type} seq {seq}: {STATUS.get(status, 'timeout')} after {attempts} attempt(s)"
+                  + (f", {rtt:.2f} ms" if rtt is not None else ""))
+
+    if args.n > 1 and rtts:
+        s = sorted(rtts)
+        p95 = s[min(len(s) - 1, int(len(s) * 0.95))]
+        print(f"n={args.n} acked={len(s)} lost={lost} resends={resends}  min {s[0]:.2f}  "
+              f"median {statistics.median(s):.2f}  p95 {p95:.2f}  max {s[-1]:.2f} ms")
+    elif args.n > 1:
+        print(f"n={args.n}: no acks")
+    return 0 if not lost else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description="WOL host agent reference / tester")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    for name in ("serve", "send"):
+        p = sub.add_parser(name)
+        p.add_argument("--key", help="shared key (or env WOL_AGENT_KEY)")
+        p.add_argument("--port", type=int, default=9)
+        p.add_argument("--mac", help="target MAC (default: this machine)")
+        p.add_argument("--iface", help="interface whose MAC is used")
+        if name == "serve":
+            p.add_argument("--state", default="~/.wol_agent_seq", help="last sequence file")
+            p.add_argument("--exec", help='run on shutdown, e.g. "systemctl poweroff"; default: only ack')
+        else:
+            p.add_argument("--host", default="127.0.0.1", help="agent address (or broadcast)")
+            p.add_argument("--type", choices=TYPES, default="shutdown")
+            p.add_argument("--tries", type=int, default=10)
+            p.add_argument("-n", type=int, default=1, help="requests to time")
+
+    args = ap.parse_args()
+    sys.exit(serve(args) if args.cmd == "serve" else send(args))
+
+
+if __name__ == "__main__":
+    main()
@@ -9,6 +9,9 @@
  *  - Connects to WiFi and MQTT broker
  *  - Supports OTA firmware updates from GitHub
  *  - Configuration via web portal (SPIFFS)
+ *  - Cooperative scheduler: loop() never blocks on delays
+ *  - MQTT, packet transmit, probing, button/LED and OTA run in
+ *    their own FreeRTOS tasks (tasks.h)
  *
  * Compatible devices:
  *  - ESP32-C3 (e.g., Seeed Studio XIAO ESP32-C3, DevKitM-1)
@@ -22,7 +25,7 @@
  *    (Default 4Mb or >= 1.3Mb OTA_Partition)
  *  - GPIO pins for LED, button, and reset may need adjustment
  *    depending on your board
- *  - OTA updates preserve /config.json (portal configuration)
+ *  - OTA updates preserve /config.bin (portal configuration)
  */
 
 #include <Arduino.h>
@@ -35,6 +38,20 @@
 #include "wol_ping.h"
 #include "ota.h"
 #include "configPortal.h"
+#include "scheduler.h"
+#include "fleet.h"
+#include "netif.h"
+#include "relay.h"
+#include "probe.h"
+#include "wake_watch.h"
+#include "boot_profile.h"
+#include "metrics.h"
+#include "profiler.h"
+#include "commands.h"
+#include "ui.h"
+#include "agent.h"
+#include "presence.h"
+#include "mqtt_state.h"
 
 #define ETH_SCK_PIN D8    // SCK
 #define ETH_MISO_PIN D9   // MISO
@@ -44,11 +61,10 @@
 byte eth_mac[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };  // Static MAC for W5500
 IPAddress eth_ip(192, 168, 5, 200);                       // Static IP for W5500
 
-bool FirstBoot = true;
-bool ethernet_lan_present = false;
-
 void setup(){
   Serial.begin(115200);
+  bootMark("setup");
+  logMsg(LOGL_INFO, "----> WOL ESP32 v%s", FIRMWARE_VERSION);
   
   pinMode(RESET_OTA_BUTTON_PIN, INPUT_PULLUP);
   pinMode(BUTTON_GPIO, INPUT_PULLUP);
@@ -56,9 +72,11 @@ void setup(){
   pinMode(PIN2_GPIO, OUTPUT); digitalWrite(PIN2_GPIO, LOW);
   pinMode(LED_GPIO, OUTPUT); digitalWrite(LED_GPIO, HIGH);
 
+  storageBegin();
   if(digitalRead(RESET_OTA_BUTTON_PIN) == LOW) factoryReset();
 
   if(!loadConfig()){
+    configDefaults(config);
     startConfigPortal();
     while(true){ 
       server.handleClient(); 
@@ -66,46 +84,44 @@ void setup(){
     }
   }
   digitalWrite(LED_GPIO, LOW);
+  bootMark("config");
+  uiBegin();
 
+  // The slow parts start first and overlap from here on: WiFi
+  // association, W5500 init (own task) and the version blink
+  setupWiFi();
+  blinkVersion(FIRMWARE_VERSION);
   SPI.begin(ETH_SCK_PIN, ETH_MISO_PIN, ETH_MOSI_PIN, -1);
   Ethernet.init(ETH_CS_PIN);
-  Ethernet.begin(eth_mac, eth_ip);
-
-  if (Ethernet.hardwareStatus() != EthernetNoHardware) {
-    delay(200);
-    if (Ethernet.linkStatus() == LinkON) {
-      ethernet_lan_present = true;
-    }
-  }
+  netifStartEthernet(eth_mac, eth_ip);
 
-  setupWiFi();
+  loadFleet();
   setupMQTT();
-  udp.begin(config.udp_port);
-
-  blinkVersion(FIRMWARE_VERSION);
-
-  performOTA();
-  lastOTACheck = millis();
+  relayBegin();
+  netifBegin();
+  fleetBegin();
+  probeBegin();
+  wakeWatchBegin();
+  agentBegin();
+  presenceBegin();
+  mqttStateBegin();
+  metricsBegin();
+  startControlServer();
+
+  schedulerEvery(PING_POLL_MS, handleScheduledPing);
+
+  // OTA checks run in a background task, the first one 30 s after boot
+  otaBegin();
+  bootMark("setup_done");
 }
 
 void loop(){
-  if(!mqttConnected()) ensureMqtt();
-  mqttLoop();
-
-  if(FirstBoot){
-    mqttPublish(("----> WOL ESP32 v" + String(FIRMWARE_VERSION)).c_str());
-    FirstBoot = false;
-  }
-
-  handleButton();
-  handleScheduledPing();
-
-  if(millis() - lastOTACheck > OTA_CHECK_INTERVAL_MS || digitalRead(RESET_OTA_BUTTON_PIN) == LOW || chkUpdate){
-    lastOTACheck=millis();
-    performOTA();
-    chkUpdate = false;
-  }
-
-  server.handleClient();
+  unsigned long t0 = micros();
+  PROF_LOOP_BEGIN();
+  schedulerRun();
+  PROF_CALL("cmd", commandPump());
+  PROF_CALL("http", server.handleClient());
+  PROF_LOOP_END();
+  metricObserve(HIST_LOOP_US, micros() - t0);
   delay(1);
 }
@@ -0,0 +1,240 @@
+/*
+ * agent.cpp
+ * -------------------------------
+ * Implements the acknowledged host-agent protocol:
+ *  - Open requests live in a small table owned by the tx task;
+ *    the tx task hands it the datagrams it reads (agentInput) and
+ *    agentTick() resends due requests (interval doubles up to
+ *    AGENT_RESEND_MAX_MS)
+ *  - An ack must carry a valid HMAC, the request's type, sequence
+ *    and MAC; the round trip is measured from the acked attempt
+ *  - An "already awake" ack to a wake request drops the magic
+ *    packets still queued for that host
+ *  - Results are handed to the loop task, which logs them, closes
+ *    the wake watch / delayed ping and publishes on wol/agent
+ *  - Sequence numbers are reserved AGENT_SEQ_BLOCK at a time in NVS
+ */
+
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <mbedtls/md.h>
+#include "agent.h"
+#include "fleet.h"
+#include "helpers.h"
+#include "metrics.h"
+#include "mqtt.h"
+#include "scheduler.h"
+#include "wake_watch.h"
+#include "lockfree_queue.h"
+
+#define AGENT_MAX_TRIES 10
+
+struct AgentRequest {
+  uint64_t seq;
+  uint32_t sentUs[AGENT_MAX_TRIES];
+  uint32_t nextMs;
+  uint16_t interval;
+  uint16_t host;
+  uint8_t  type;
+  uint8_t  attempt;
+  uint8_t  tries;
+  bool     active;
+};
+
+struct AgentResult {
+  uint16_t host;
+  uint8_t  type;
+  uint8_t  status;
+  uint8_t  attempts;
+  uint8_t  ackedAttempt;
+  uint32_t rttUs;     // acked attempt to ack
+  uint32_t totalUs;   // first attempt to ack
+};
+
+static const char* const typeNames[]   = { "?", "shutdown", "wake" };
+static const char* const statusNames[] = { "timeout", "shutting_down", "awake", "refused" };
+
+// tx task only
+static AgentRequest pending[AGENT_MAX_PENDING];
+static uint8_t pendingCount = 0;
+static uint64_t nextSeq = 0;
+static uint64_t seqLimit = 0;
+
+static SpscQueue<AgentResult, AGENT_MAX_PENDING * 2> results;   // tx -> loop
+
+bool agentEnabled(){
+  return config.agent_key[0] != '\0';
+}
+
+static uint64_t allocSeq(){
+  if(nextSeq >= seqLimit){
+    Preferences prefs;
+    prefs.begin("agent", false);
+    if(!seqLimit) nextSeq = max(prefs.getULong64("seq", 1), (uint64_t)1);
+    seqLimit = nextSeq + AGENT_SEQ_BLOCK;
+    prefs.putULong64("seq", seqLimit);
+    prefs.end();
+  }
+  return nextSeq++;
+}
+
+static void agentHmac(const uint8_t* pkt, uint8_t out[32]){
+  char key[AGENT_KEY_LEN];
+  portENTER_CRITICAL(&configLock);
+  memcpy(key, config.agent_key, sizeof(key));
+  portEXIT_CRITICAL(&configLock);
+  mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                  (const uint8_t*)key, strnlen(key, sizeof(key)),
+                  pkt, AGENT_SIGNED_LEN, out);
+}
+
+static bool agentVerify(const uint8_t* pkt){
+  uint8_t mac[32];
+  agentHmac(pkt, mac);
+  uint8_t diff = 0;
+  for(int i = 0; i < AGENT_MAC_LEN; i++) diff |= mac[i] ^ pkt[AGENT_SIGNED_LEN + i];
+  return diff == 0;
+}
+
+static void buildPacket(uint8_t* p, const AgentRequest &r){
+  memcpy(p, "WOLA", 4);
+  p[4] = AGENT_VERSION;
+  p[5] = r.type;
+  p[6] = 0;
+  p[7] = r.attempt;
+  for(int i = 0; i < 8; i++) p[8 + i] = (uint8_t)(r.seq >> (56 - 8 * i));
+  memcpy(p + 16, fleetHostCopy(r.host).mac, 6);
+  p[22] = p[23] = 0;
+
+  uint8_t mac[32];
+  agentHmac(p, mac);
+  memcpy(p + AGENT_SIGNED_LEN, mac, AGENT_MAC_LEN);
+}
+
+static void sendAttempt(AgentRequest &r){
+  uint8_t pkt[AGENT_PKT_LEN];
+  r.attempt++;
+  buildPacket(pkt, r);
+
+  FleetHost h = fleetHostCopy(r.host);
+  r.sentUs[r.attempt - 1] = esp_timer_get_time();
+  uint8_t done = netifSend(h.iface, h.port, pkt, sizeof(pkt), nullptr, 0);
+  if(r.type == AGENT_SHUTDOWN){
+    if(done & NETIF_WIFI) metricInc(CNT_SHUTDOWN_WIFI);
+    if(done & NETIF_ETH)  metricInc(CNT_SHUTDOWN_ETH);
+  }
+
+  r.nextMs = millis() + (r.attempt < r.tries ? r.interval : AGENT_ACK_WAIT_MS);
+  r.interval = min(r.interval * 2, AGENT_RESEND_MAX_MS);
+}
+
+static void finish(AgentRequest &r, AgentStatus status, uint8_t ackedAttempt, uint32_t nowUs){
+  AgentResult res = { r.host, r.type, (uint8_t)status, r.attempt, ackedAttempt, 0, 0 };
+  if(ackedAttempt){
+    res.rttUs = nowUs - r.sentUs[ackedAttempt - 1];
+    res.totalUs = nowUs - r.sentUs[0];
+  }
+  if(!results.push(res)) logMsg(LOGL_WARN, "Agent: result queue full");
+  r.active = false;
+  pendingCount--;
+}
+
+void agentStart(int host, AgentType type, int tries){
+  if(!agentEnabled()) return;
+
+  AgentRequest* r = nullptr;
+  for(int i = 0; i < AGENT_MAX_PENDING; i++){
+    if(pending[i].active && pending[i].host == host && pending[i].type == type) return;   // already open
+    if(!pending[i].active && !r) r = &pending[i];
+  }
+  if(!r){
+    logMsg(LOGL_WARN, "Agent: too many open requests");
+    return;
+  }
+
+  r->seq = allocSeq();
+  r->host = host;
+  r->type = type;
+  r->attempt = 0;
+  r->tries = constrain(tries, 1, AGENT_MAX_TRIES);
+  r->interval = AGENT_RESEND_FIRST_MS;
+  r->active = true;
+  pendingCount++;
+  sendAttempt(*r);
+}
+
+// Tx task; true when the datagram belongs to the agent protocol
+bool agentInput(const uint8_t* p, size_t len){
+  if(len != AGENT_PKT_LEN || memcmp(p, "WOLA", 4)) return false;
+  if(p[4] != AGENT_VERSION || !(p[5] & AGENT_ACK)) return true;
+  uint32_t nowUs = esp_timer_get_time();
+
+  if(!agentVerify(p)){
+    logMsg(LOGL_WARN, "Agent: ack with bad signature ignored");
+    return true;
+  }
+
+  uint64_t seq = 0;
+  for(int i = 0; i < 8; i++) seq = (seq << 8) | p[8 + i];
+  uint8_t type = p[5] & ~AGENT_ACK;
+  uint8_t attempt = p[7];
+
+  for(int i = 0; i < AGENT_MAX_PENDING; i++){
+    AgentRequest &r = pending[i];
+    if(!r.active || r.seq != seq || r.type != type || memcmp(p + 16, fleetHostCopy(r.host).mac, 6)) continue;
+    if(attempt == 0 || attempt > r.attempt) attempt = r.attempt;
+    if(p[6] == AGENT_ST_AWAKE && type == AGENT_WAKE) fleetDropJobs(r.host, FLEET_PKT_WAKE);
+    finish(r, p[6] <= AGENT_ST_REFUSED ? (AgentStatus)p[6] : AGENT_ST_REFUSED, attempt, nowUs);
+    break;
+  }
+  return true;
+}
+
+// tx task, every iteration
+void agentTick(){
+  if(!pendingCount) return;
+  uint32_t now = millis();
+  for(int i = 0; i < AGENT_MAX_PENDING; i++){
+    AgentRequest &r = pending[i];
+    if(!r.active || (long)(now - r.nextMs) < 0) continue;
+    if(r.attempt < r.tries) sendAttempt(r);
+    else finish(r, AGENT_ST_TIMEOUT, 0, 0);
+  }
+}
+
+uint32_t agentNextMs(){
+  return pendingCount ? AGENT_POLL_MS : UINT32_MAX;
+}
+
+// Loop task
+static void agentDispatch(){
+  AgentResult r;
+  while(results.pop(r)){
+    const char* name = fleetHosts[r.host].name;
+    const char* type = typeNames[r.type <= AGENT_WAKE ? r.type : 0];
+
+    if(r.status == AGENT_ST_TIMEOUT){
+      // A sleeping host has no agent to answer a wake request
+      logMsg(r.type == AGENT_WAKE ? LOGL_DEBUG : LOGL_WARN, "Agent: %s %s not acked after %u attempts",
+             name, type, r.attempts);
+    } else {
+      metricObserve(HIST_AGENT_ACK_US, r.rttUs);
+      logMsg(LOGL_INFO, "Agent: %s %s -> %s in %lu us (attempt %u of %u, %lu us since the first)",
+             name, type, statusNames[r.status], (unsigned long)r.rttUs, r.ackedAttempt, r.attempts,
+             (unsigned long)r.totalUs);
+    }
+
+    if(r.type == AGENT_SHUTDOWN && r.status != AGENT_ST_TIMEOUT && r.host == 0) wolPendingPing = false;
+    if(r.type == AGENT_WAKE && r.status == AGENT_ST_AWAKE) wakeWatchCancel(r.host);
+
+    char json[160];
+    snprintf(json, sizeof(json),
+             "{\"host\":\"%s\",\"request\":\"%s\",\"status\":\"%s\",\"attempts\":%u,\"rtt_us\":%lu,\"total_us\":%lu}",
+             name, type, statusNames[r.status], r.attempts, (unsigned long)r.rttUs, (unsigned long)r.totalUs);
+    mqttPost("wol/agent", json, false);
+  }
+}
+
+void agentBegin(){
+  schedulerEvery(AGENT_DISPATCH_MS, agentDispatch);
+}
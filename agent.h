@@ -0,0 +1,56 @@
+/*
+ * agent.h
+ * -------------------------------
+ * Declares the acknowledged host-agent protocol (shutdown / wake):
+ *  - Versioned request/ack datagram, AGENT_PKT_LEN bytes:
+ *      0  "WOLA"             4  version (AGENT_VERSION)
+ *      5  type (AgentType)   6  status (acks)   7  attempt
+ *      8  sequence, 64-bit big endian (request nonce)
+ *      16 target MAC         22 reserved (0)
+ *      24 HMAC-SHA256(config.agent_key, bytes 0..23), first 16 bytes
+ *  - The sequence is kept in NVS and only grows, so the host agent
+ *    can refuse replays; resends reuse it, with the next attempt
+ *  - Requests go to the host's UDP port on the fleet interfaces,
+ *    the agent answers to the sender's address and port
+ *  - Resends back off from AGENT_RESEND_FIRST_MS and stop at the
+ *    first valid ack; results go to the loop task (wol/agent)
+ *  - Without config.agent_key the legacy 0xEE shutdown burst is sent
+ */
+
+#pragma once
+#include "config.h"
+
+#define AGENT_PKT_LEN          40
+#define AGENT_SIGNED_LEN       24
+#define AGENT_MAC_LEN          16
+#define AGENT_VERSION          1
+#define AGENT_MAX_PENDING      8
+#define AGENT_RESEND_FIRST_MS  100
+#define AGENT_RESEND_MAX_MS    1000
+#define AGENT_ACK_WAIT_MS      2000   // after the last attempt
+#define AGENT_POLL_MS          2      // tx task socket poll while requests are open
+#define AGENT_WAKE_TRIES       3
+#define AGENT_SEQ_BLOCK        256    // sequence numbers reserved per NVS write
+#define AGENT_DISPATCH_MS      20
+
+enum AgentType : uint8_t {
+  AGENT_SHUTDOWN = 1,
+  AGENT_WAKE     = 2,
+  AGENT_ACK      = 0x80   // | request type
+};
+
+enum AgentStatus : uint8_t {
+  AGENT_ST_TIMEOUT       = 0,   // no ack (firmware side only)
+  AGENT_ST_SHUTTING_DOWN = 1,
+  AGENT_ST_AWAKE         = 2,   // already awake
+  AGENT_ST_REFUSED       = 3
+};
+
+bool agentEnabled();
+void agentBegin();
+
+// tx task only
+void     agentStart(int host, AgentType type, int tries);
+bool     agentInput(const uint8_t* p, size_t len);
+void     agentTick();
+uint32_t agentNextMs();
@@ -0,0 +1,77 @@
+/*
+ * boot_profile.cpp
+ * -------------------------------
+ * Implements the boot profiler:
+ *  - Fixed table of (phase, ms) pairs; phase names are literals
+ *  - Timeline JSON: {"reset":"...","ready_ms":N,"phases":{"name":ms,...}}
+ *    where ready_ms is the time MQTT came up (first command possible)
+ *  - Marks come from several tasks (loop, tx, mqtt); the table is
+ *    guarded by a spinlock
+ */
+
+#include <ArduinoJson.h>
+#include <esp_system.h>
+#include "boot_profile.h"
+#include "mqtt.h"
+#include "logger.h"
+
+struct BootMark {
+  const char* phase;
+  uint32_t    ms;
+};
+
+static BootMark marks[BOOT_MAX_MARKS];
+static uint8_t markCount = 0;
+static bool published = false;
+static portMUX_TYPE markLock = portMUX_INITIALIZER_UNLOCKED;
+
+void bootMark(const char* phase){
+  uint32_t ms = millis();
+  portENTER_CRITICAL(&markLock);
+  if(markCount < BOOT_MAX_MARKS) marks[markCount++] = { phase, ms };
+  portEXIT_CRITICAL(&markLock);
+}
+
+void bootMarkOnce(const char* phase){
+  uint32_t ms = millis();
+  portENTER_CRITICAL(&markLock);
+  bool seen = false;
+  for(int i = 0; i < markCount && !seen; i++) seen = !strcmp(marks[i].phase, phase);
+  if(!seen && markCount < BOOT_MAX_MARKS) marks[markCount++] = { phase, ms };
+  portEXIT_CRITICAL(&markLock);
+}
+
+static const char* resetName(){
+  switch(esp_reset_reason()){
+    case ESP_RST_POWERON:  return "poweron";
+    case ESP_RST_SW:       return "software";
+    case ESP_RST_PANIC:    return "panic";
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:      return "watchdog";
+    case ESP_RST_BROWNOUT: return "brownout";
+    case ESP_RST_DEEPSLEEP: return "deepsleep";
+    default:               return "other";
+  }
+}
+
+void bootPublish(){
+  if(published || !mqttConnected()) return;
+
+  uint32_t ready = millis();
+  JsonDocument doc;
+  doc["reset"] = resetName();
+  doc["ready_ms"] = ready;
+  JsonObject phases = doc["phases"].to<JsonObject>();
+  BootMark snap[BOOT_MAX_MARKS];
+  portENTER_CRITICAL(&markLock);
+  int n = markCount;
+  memcpy(snap, marks, sizeof(BootMark) * n);
+  portEXIT_CRITICAL(&markLock);
+  for(int i = 0; i < n; i++) phases[snap[i].phase] = snap[i].ms;
+
+  char buf[384];
+  serializeJson(doc, buf, sizeof(buf));
+  published = mqttPost("wol/boot/timeline", buf, true);
+  logMsg(LOGL_INFO, "Boot: ready in %lu ms", (unsigned long)ready);
+}
@@ -0,0 +1,19 @@
+/*
+ * boot_profile.h
+ * -------------------------------
+ * Declares the boot profiler:
+ *  - bootMark() timestamps a boot phase (ms since reset)
+ *  - bootMarkOnce() for milestones reached asynchronously
+ *    (WiFi up, LAN link, MQTT up), recorded the first time only
+ *  - bootPublish() sends the timeline once, retained, on
+ *    "wol/boot/timeline" when MQTT first connects
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define BOOT_MAX_MARKS 16
+
+void bootMark(const char* phase);
+void bootMarkOnce(const char* phase);
+void bootPublish();
@@ -0,0 +1,157 @@
+/*
+ * buttons.cpp
+ * -------------------------------
+ * Implements interrupt-driven button input:
+ *  - buttonIsr() only pushes (button, esp_timer us) into an MPSC
+ *    queue and wakes the ui task; no GPIO read, nothing in flash
+ *  - Leading-edge debounce: the first edge after a quiet period is
+ *    the transition, edges within BUTTON_DEBOUNCE_US are bounce; once
+ *    quiet the pin is read back, so a lost trailing edge resyncs
+ *  - Gestures: clicks are counted until BUTTON_MULTI_GAP_US passes
+ *    without a new press (a third click fires at once); a press held
+ *    BUTTON_LONG_US fires "long" without waiting for the release
+ *  - Recognised gestures go through an SPSC queue to the loop task,
+ *    which looks up the action and runs it through commandExecute()
+ */
+
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include "buttons.h"
+#include "commands.h"
+#include "helpers.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "lockfree_queue.h"
+
+const char* const buttonNames[BUTTON_COUNT]   = { "wol", "ota" };
+const char* const gestureNames[GESTURE_COUNT] = { "short", "long", "double", "triple" };
+
+static const uint8_t buttonPins[BUTTON_COUNT] = { BUTTON_GPIO, RESET_OTA_BUTTON_PIN };
+
+struct ButtonEdge {
+  uint8_t  button;
+  uint32_t us;
+};
+
+struct ButtonGesture {
+  uint8_t  button;
+  uint8_t  gesture;
+  uint32_t pressUs;     // first press of the gesture
+  uint32_t decidedUs;   // gesture recognised
+};
+
+// ui task only
+struct ButtonState {
+  bool     pressed;
+  bool     longFired;
+  uint8_t  clicks;
+  uint32_t changeUs;    // last accepted transition
+  uint32_t pressUs;
+  uint32_t firstUs;
+};
+
+static MpscQueue<ButtonEdge, BUTTON_EDGE_QUEUE_LEN> edges;   // ISRs -> ui
+static SpscQueue<ButtonGesture, 8> gestures;                 // ui -> loop
+static ButtonState buttons[BUTTON_COUNT];
+static TaskHandle_t uiHandle = NULL;
+
+static void IRAM_ATTR buttonIsr(void* arg){
+  ButtonEdge e = { (uint8_t)(uintptr_t)arg, (uint32_t)esp_timer_get_time() };
+  edges.push(e);
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(uiHandle, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void emit(uint8_t button, Gesture g, uint32_t pressUs, uint32_t now){
+  if(!gestures.push({ button, (uint8_t)g, pressUs, now }))
+    logMsg(LOGL_WARN, "Button: gesture queue full");
+}
+
+static void setPressed(uint8_t i, bool pressed, uint32_t us){
+  ButtonState &b = buttons[i];
+  b.pressed = pressed;
+  b.changeUs = us;
+
+  if(pressed){
+    b.pressUs = us;
+    b.longFired = false;
+    if(b.clicks == 0) b.firstUs = us;
+  } else if(b.longFired){
+    b.clicks = 0;
+  } else if(++b.clicks >= 3){
+    emit(i, GESTURE_TRIPLE, b.firstUs, us);
+    b.clicks = 0;
+  }
+}
+
+// Runs on the ui task every wake-up (edge or BUTTON_POLL_MS tick)
+void buttonsPoll(){
+  ButtonEdge e;
+  while(edges.pop(e)){
+    ButtonState &b = buttons[e.button];
+    if(e.us - b.changeUs >= BUTTON_DEBOUNCE_US) setPressed(e.button, !b.pressed, e.us);
+  }
+
+  uint32_t now = esp_timer_get_time();
+  for(uint8_t i = 0; i < BUTTON_COUNT; i++){
+    ButtonState &b = buttons[i];
+    if(now - b.changeUs >= BUTTON_DEBOUNCE_US){
+      bool level = digitalRead(buttonPins[i]) == LOW;
+      if(level != b.pressed) setPressed(i, level, now);
+    }
+
+    if(b.pressed && !b.longFired && now - b.pressUs >= BUTTON_LONG_US){
+      b.longFired = true;
+      b.clicks = 0;
+      emit(i, GESTURE_LONG, b.pressUs, now);
+    } else if(!b.pressed && b.clicks > 0 && now - b.changeUs >= BUTTON_MULTI_GAP_US){
+      emit(i, b.clicks == 1 ? GESTURE_SHORT : GESTURE_DOUBLE, b.firstUs, now);
+      b.clicks = 0;
+    }
+  }
+}
+
+// Loop task: the action runs where every other command runs
+static void buttonDispatch(){
+  ButtonGesture g;
+  while(gestures.pop(g)){
+    const char* action = config.button_actions[g.button][g.gesture];
+    if(!action[0]){
+      logMsg(LOGL_DEBUG, "Button: %s %s (no action)", buttonNames[g.button], gestureNames[g.gesture]);
+      continue;
+    }
+
+    CommandStatus st = commandExecute(action, strlen(action), "Button");
+    bool ok = st == CMD_OK;
+    uint32_t now = esp_timer_get_time();
+    metricObserve(HIST_BUTTON_DISPATCH_US, now - g.decidedUs);
+    logMsg(ok ? LOGL_INFO : LOGL_WARN, "Button: %s %s -> %s%s, press-to-action %lu ms (dispatch %lu us)",
+           buttonNames[g.button], gestureNames[g.gesture], action, ok ? "" : st == CMD_UNKNOWN ? " (unknown command)" : st == CMD_FAILED ? " (failed)" : " (not run)",
+           (unsigned long)((now - g.pressUs) / 1000), (unsigned long)(now - g.decidedUs));
+  }
+}
+
+void buttonDefaults(Config &cfg){
+  strlcpy(cfg.button_actions[BUTTON_WOL][GESTURE_LONG], "TurnOn", BUTTON_ACTION_LEN);
+  strlcpy(cfg.button_actions[BUTTON_WOL][GESTURE_DOUBLE], "PingPC", BUTTON_ACTION_LEN);
+  strlcpy(cfg.button_actions[BUTTON_OTA][GESTURE_SHORT], "CheckUpdate", BUTTON_ACTION_LEN);
+}
+
+// Before the ui task starts: it polls buttons[] from its first run
+void buttonsBegin(){
+  uint32_t now = esp_timer_get_time();
+  for(uint8_t i = 0; i < BUTTON_COUNT; i++){
+    buttons[i].pressed = digitalRead(buttonPins[i]) == LOW;
+    buttons[i].longFired = buttons[i].pressed;   // held since boot: not a gesture
+    buttons[i].changeUs = now;
+  }
+  schedulerEvery(BUTTON_DISPATCH_MS, buttonDispatch);
+}
+
+// Once the ui task exists: the ISRs notify it
+void buttonsAttach(TaskHandle_t uiTask){
+  uiHandle = uiTask;
+  for(uint8_t i = 0; i < BUTTON_COUNT; i++)
+    attachInterruptArg(buttonPins[i], buttonIsr, (void*)(uintptr_t)i, CHANGE);
+}
@@ -0,0 +1,42 @@
+/*
+ * buttons.h
+ * -------------------------------
+ * Declares interrupt-driven button input:
+ *  - Both buttons (WOL on BUTTON_GPIO, OTA on RESET_OTA_BUTTON_PIN)
+ *    timestamp every edge in a GPIO ISR
+ *  - The ui task debounces the edges and recognises short, long,
+ *    double and triple presses
+ *  - Each (button, gesture) runs the command in
+ *    config.button_actions on the loop task, e.g. "TurnOn", "TurnOff",
+ *    "PingPC", "CheckUpdate"; empty = no action
+ *  - Press-to-action latency is logged and kept in a histogram
+ */
+
+#pragma once
+#include "config.h"
+
+#define BUTTON_DEBOUNCE_US    30000UL
+#define BUTTON_LONG_US        1000000UL   // held this long = long press (fires while held)
+#define BUTTON_MULTI_GAP_US   300000UL    // max release-to-press gap inside a double/triple
+#define BUTTON_EDGE_QUEUE_LEN 32
+#define BUTTON_DISPATCH_MS    2
+
+enum ButtonId : uint8_t {
+  BUTTON_WOL = 0,
+  BUTTON_OTA = 1
+};
+
+enum Gesture : uint8_t {
+  GESTURE_SHORT  = 0,
+  GESTURE_LONG   = 1,
+  GESTURE_DOUBLE = 2,
+  GESTURE_TRIPLE = 3
+};
+
+extern const char* const buttonNames[BUTTON_COUNT];
+extern const char* const gestureNames[GESTURE_COUNT];
+
+void buttonsBegin();
+void buttonsAttach(TaskHandle_t uiTask);
+void buttonsPoll();
+void buttonDefaults(Config &cfg);
@@ -0,0 +1,105 @@
+/*
+ * command_admit.h
+ * -------------------------------
+ * Command admission (idempotency and ordering), shared by the
+ * firmware (commands.cpp) and the Linux test
+ * (Tools/command_admit_test.cpp):
+ *  - CmdWindow: ring of the FNV-1a hashes of the last CMD_DEDUP_IDS
+ *    ids run, and the newest ts run per output/target key
+ *    ("PinOut1", "Turn:pc"); the stalest key gives way when all
+ *    CMD_ORDER_KEYS are taken. The firmware keeps it in RTC memory
+ *  - cmdAdmit(): duplicate id, then a ts further than CMD_MAX_AGE_MS
+ *    from the clock (skipped while it is not synced), then a ts
+ *    older than the last one run for the key; a command that passes
+ *    is recorded as run
+ *  - Plain C++17, no Arduino headers
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CMD_DEDUP_IDS     32
+#define CMD_ORDER_KEYS    16
+#define CMD_MAX_AGE_MS    30000
+#define CMD_WINDOW_MAGIC  0x434D4457   // "CMDW"
+
+enum CommandStatus : uint8_t {
+  CMD_OK = 0,
+  CMD_DUPLICATE,
+  CMD_STALE,
+  CMD_SUPERSEDED,
+  CMD_UNKNOWN,
+  CMD_FAILED,        // admitted, but the handler could not act (e.g. TX queue full)
+  CMD_STATUS_COUNT
+};
+
+static const char* const commandStatusNames[CMD_STATUS_COUNT] = {
+  "ok", "duplicate", "stale", "superseded", "unknown", "failed"
+};
+
+struct CmdOrderKey {
+  uint32_t key;      // 0 = free
+  uint64_t ts;
+};
+
+struct CmdWindow {
+  uint32_t    magic;
+  uint32_t    head;
+  uint32_t    ids[CMD_DEDUP_IDS];   // 0 = free
+  CmdOrderKey order[CMD_ORDER_KEYS];
+};
+
+constexpr uint32_t cmdFnv1a(uint32_t seed, const char* s, size_t n){
+  uint32_t h = 2166136261u ^ seed;
+  for(size_t i = 0; i < n; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+  return h;
+}
+
+inline uint32_t cmdHash(const char* s, size_t n, uint32_t h = 0){
+  h = cmdFnv1a(h, s, n);
+  return h ? h : 1;
+}
+
+// Commands that undo each other share a key: "PinOut1On"/"PinOut1Off" -> "PinOut1"
+inline uint32_t cmdOrderKey(const char* name, size_t n, const char* target){
+  if(n > 3 && !memcmp(name + n - 3, "Off", 3)) n -= 3;
+  else if(n > 2 && !memcmp(name + n - 2, "On", 2)) n -= 2;
+  return cmdHash(target, strlen(target), cmdHash(name, n));
+}
+
+// id "" = none, ts 0 = none, nowMs 0 = clock not synced
+inline CommandStatus cmdAdmit(CmdWindow &w, const char* id, const char* name, size_t nameLen,
+                              const char* target, uint64_t ts, uint64_t nowMs){
+  if(w.magic != CMD_WINDOW_MAGIC || w.head >= CMD_DEDUP_IDS){
+    memset(&w, 0, sizeof(w));
+    w.magic = CMD_WINDOW_MAGIC;
+  }
+
+  uint32_t h = id[0] ? cmdHash(id, strlen(id)) : 0;
+  if(h){
+    for(int i = 0; i < CMD_DEDUP_IDS; i++) if(w.ids[i] == h) return CMD_DUPLICATE;
+  }
+
+  if(ts){
+    if(nowMs && (nowMs > ts ? nowMs - ts : ts - nowMs) > CMD_MAX_AGE_MS) return CMD_STALE;
+
+    uint32_t key = cmdOrderKey(name, nameLen, target);
+    CmdOrderKey* slot = nullptr;
+    for(int i = 0; i < CMD_ORDER_KEYS; i++){
+      CmdOrderKey &k = w.order[i];
+      if(k.key == key){ slot = &k; break; }
+      if(!slot || !k.key || (slot->key && k.ts < slot->ts)) slot = &k;   // free or stalest
+    }
+    if(slot->key == key && ts < slot->ts) return CMD_SUPERSEDED;
+    slot->key = key;
+    slot->ts = ts;
+  }
+
+  if(h){
+    w.ids[w.head] = h;
+    w.head = (w.head + 1) % CMD_DEDUP_IDS;
+  }
+  return CMD_OK;
+}
@@ -0,0 +1,191 @@
+/*
+ * command_parse.h
+ * -------------------------------
+ * Command parsing and lookup, shared by the firmware (commands.cpp)
+ * and the Linux benchmark (Tools/command_bench.cpp):
+ *  - commandParse(): trims and parses the payload where it lies;
+ *    the only copies are the target and id into fixed buffers in
+ *    Command. The JSON form is scanned with a minimal flat-object
+ *    parser (string / number values, no nesting)
+ *  - CmdPerfectHash<Entry, N>: a table of entries with a .name
+ *    hashed with FNV-1a at compile time; the seed is searched by the
+ *    compiler so every name gets its own slot, and find() is one
+ *    hash and one compare
+ *  - Plain C++17, no Arduino headers
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "command_admit.h"
+
+#define CMD_DEFAULT_COUNT 10
+#define CMD_ARG_LEN       32
+#define CMD_ID_LEN        40
+
+struct Command {
+  const char* name;          // points into the payload, not terminated
+  size_t      nameLen;
+  char        target[CMD_ARG_LEN];
+  int         count;
+  char        id[CMD_ID_LEN];   // "" = no id
+  uint64_t    ts;               // sender's Unix time in ms, 0 = none
+  const char* source;        // "MQTT", "HTTP", ... (string literal)
+};
+
+// ---- Compile-time perfect hash ----
+
+template<typename Entry, size_t N, size_t Size = 64>   // Size: power of two, sparse enough for a quick seed search
+class CmdPerfectHash {
+  static_assert(N < Size, "grow Size");
+  static constexpr uint8_t NONE = 0xFF;
+
+public:
+  constexpr explicit CmdPerfectHash(const Entry (&table)[N]) : table(table), seed(findSeed(table)), idx() {
+    for(size_t i = 0; i < Size; i++) idx[i] = NONE;
+    for(size_t i = 0; i < N; i++) idx[slotOf(seed, table[i].name, len(table[i].name))] = i;
+  }
+
+  const Entry* find(const char* name, size_t n) const {
+    uint8_t i = idx[slotOf(seed, name, n)];
+    if(i == NONE) return nullptr;
+    const Entry &e = table[i];
+    // length first: the payload is not NUL-terminated and may hold a NUL
+    if(strlen(e.name) != n || memcmp(e.name, name, n) != 0) return nullptr;
+    return &e;
+  }
+
+private:
+  static constexpr size_t len(const char* s){
+    size_t n = 0;
+    while(s[n]) n++;
+    return n;
+  }
+
+  static constexpr size_t slotOf(uint32_t seed, const char* s, size_t n){
+    return cmdFnv1a(seed, s, n) & (Size - 1);
+  }
+
+  static constexpr bool isPerfect(const Entry (&table)[N], uint32_t seed){
+    bool used[Size] = {};
+    for(size_t i = 0; i < N; i++){
+      size_t slot = slotOf(seed, table[i].name, len(table[i].name));
+      if(used[slot]) return false;
+      used[slot] = true;
+    }
+    return true;
+  }
+
+  static constexpr uint32_t findSeed(const Entry (&table)[N]){
+    uint32_t seed = 0;
+    while(!isPerfect(table, seed)) seed++;
+    return seed;
+  }
+
+  const Entry* table;
+  uint32_t     seed;
+  uint8_t      idx[Size];
+};
+
+// ---- Parser ----
+
+inline bool cmdIsWs(char c){
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline const char* cmdSkipWs(const char* p, const char* end){
+  while(p < end && cmdIsWs(*p)) p++;
+  return p;
+}
+
+inline uint64_t cmdParseNumber(const char* p, size_t len){
+  uint64_t n = 0;
+  for(size_t i = 0; i < len && p[i] >= '0' && p[i] <= '9'; i++) n = n * 10 + (p[i] - '0');
+  return n;
+}
+
+inline void cmdCopyArg(char* dst, const char* src, size_t len, size_t size = CMD_ARG_LEN){
+  if(len >= size) len = size - 1;
+  memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+inline bool cmdKeyIs(const char* key, size_t len, const char* want){
+  return strlen(want) == len && !memcmp(key, want, len);
+}
+
+inline bool cmdParseJson(const char* p, const char* end, Command &cmd){
+  p = cmdSkipWs(p + 1, end);
+
+  while(p < end && *p != '}'){
+    if(*p != '"') return false;
+    const char* key = ++p;
+    while(p < end && *p != '"') p++;
+    if(p >= end) return false;
+    size_t keyLen = p - key;
+
+    p = cmdSkipWs(p + 1, end);
+    if(p >= end || *p != ':') return false;
+    p = cmdSkipWs(p + 1, end);
+    if(p >= end) return false;
+
+    const char* val;
+    size_t valLen;
+    if(*p == '"'){
+      val = ++p;
+      while(p < end && *p != '"'){
+        if(*p == '\\') p++;
+        p++;
+      }
+      if(p >= end) return false;
+      valLen = p - val;
+      p++;
+    } else {
+      val = p;
+      while(p < end && *p != ',' && *p != '}' && !cmdIsWs(*p)) p++;
+      valLen = p - val;
+    }
+
+    if(cmdKeyIs(key, keyLen, "cmd"))         { cmd.name = val; cmd.nameLen = valLen; }
+    else if(cmdKeyIs(key, keyLen, "target")) cmdCopyArg(cmd.target, val, valLen);
+    else if(cmdKeyIs(key, keyLen, "count")){
+      uint64_t n = cmdParseNumber(val, valLen);
+      cmd.count = (int)(n < 0xFFFF ? n : 0xFFFF);
+    }
+    else if(cmdKeyIs(key, keyLen, "id"))     cmdCopyArg(cmd.id, val, valLen, sizeof(cmd.id));
+    else if(cmdKeyIs(key, keyLen, "ts"))     cmd.ts = cmdParseNumber(val, valLen);
+
+    p = cmdSkipWs(p, end);
+    if(p < end && *p == ',') p = cmdSkipWs(p + 1, end);
+  }
+
+  return p < end && cmd.nameLen > 0;
+}
+
+inline bool commandParse(const char* payload, size_t len, Command &cmd){
+  const char* p = payload;
+  const char* end = payload + len;
+  while(p < end && cmdIsWs(*p)) p++;
+  while(end > p && cmdIsWs(end[-1])) end--;
+
+  cmd.name = nullptr;
+  cmd.nameLen = 0;
+  cmd.target[0] = '\0';
+  cmd.count = CMD_DEFAULT_COUNT;
+  cmd.id[0] = '\0';
+  cmd.ts = 0;
+
+  if(p == end) return false;
+  if(*p == '{'){
+    if(!cmdParseJson(p, end, cmd)) return false;
+  } else {
+    const char* colon = (const char*)memchr(p, ':', end - p);
+    cmd.name = p;
+    cmd.nameLen = (colon ? colon : end) - p;
+    if(colon) cmdCopyArg(cmd.target, colon + 1, end - colon - 1);
+  }
+
+  if(cmd.count <= 0) cmd.count = CMD_DEFAULT_COUNT;
+  return true;
+}
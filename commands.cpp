@@ -0,0 +1,286 @@
+/*
+ * commands.cpp
+ * -------------------------------
+ * Implements the command dispatcher:
+ *  - Parsing and the compile-time perfect hash of cmdTable[] are in
+ *    command_parse.h
+ *  - Commands from other tasks (mqtt, ui) are copied into an MPSC
+ *    queue, stamped with their receipt time, and executed by
+ *    commandPump() on the loop task
+ *  - Admission (id window, ts checks) is cmdAdmit() in
+ *    command_admit.h; its window lives in RTC memory so a soft
+ *    reset does not run a redelivered command again
+ */
+
+#include <esp_timer.h>
+#include <ArduinoJson.h>
+#include "commands.h"
+#include "helpers.h"
+#include "wol_ping.h"
+#include "fleet.h"
+#include "probe.h"
+#include "presence.h"
+#include "mqtt.h"
+#include "metrics.h"
+#include "profiler.h"
+#include "wifi_utils.h"
+#include "lockfree_queue.h"
+
+typedef bool (*CmdHandler)(const Command &cmd);   // false: nothing was done
+
+struct CmdEntry {
+  const char* name;
+  CmdHandler  fn;
+};
+
+// ---- Handlers ----
+
+static bool cmdTurnOn(const Command &c){
+  if(!c.target[0]) return sendWOL(c.source, c.count);
+  int host = fleetFind(c.target);
+  if(host >= 0) return fleetQueue(host, FLEET_PKT_WAKE, c.count);
+  if(fleetWakeGroup(c.target, c.count)) return true;
+  logMsg(LOGL_WARN, "Fleet: unknown host");
+  return false;
+}
+
+static bool cmdTurnOff(const Command &c){
+  if(!c.target[0]) return sendShutdownPacket(c.source, c.count);
+  if(fleetQueue(fleetFind(c.target), FLEET_PKT_SHUTDOWN, c.count)) return true;
+  logMsg(LOGL_WARN, "Fleet: unknown host");
+  return false;
+}
+
+static bool cmdCheckUpdate(const Command &c){
+  chkUpdate = true;
+  return true;
+}
+
+static bool cmdFactoryReset(const Command &c){
+  factoryReset();
+  return true;
+}
+
+static bool cmdPingPC(const Command &c){
+  if(!c.target[0]){
+    doPing();
+    return true;
+  }
+  if(probeHost(fleetFind(c.target), true, true)) return true;
+  logMsg(LOGL_WARN, "Fleet: unknown host");
+  return false;
+}
+
+static bool cmdWakeHost(const Command &c){
+  if(fleetWakeHost(c.target, c.count)) return true;
+  logMsg(LOGL_WARN, "Fleet: unknown host");
+  return false;
+}
+
+static bool cmdWakeGroup(const Command &c){
+  int n = fleetWakeGroup(c.target, c.count);
+  logMsg(LOGL_INFO, "Fleet: waking %d hosts", n);
+  return n > 0;
+}
+
+static bool cmdWakeAll(const Command &c){
+  int n = fleetWakeAll(c.count);
+  logMsg(LOGL_INFO, "Fleet: waking %d hosts", n);
+  return n > 0;
+}
+
+static bool cmdPingHost(const Command &c){
+  if(probeHost(fleetFind(c.target), true, true)) return true;
+  logMsg(LOGL_WARN, "Fleet: unknown host");
+  return false;
+}
+
+static bool cmdPingAll(const Command &c){
+  probeAll(true);
+  return true;
+}
+
+static bool cmdLogLevel(const Command &c){
+  LogLevel level;
+  if(!logParseLevel(c.target, level)){
+    logMsg(LOGL_WARN, "Log: unknown level '%s'", c.target);
+    return false;
+  }
+  logSetLevel(level);
+  logMsg(LOGL_INFO, "Log: level set to %s", c.target);
+  return true;
+}
+
+static bool cmdPinOut1On(const Command &c){
+  digitalWrite(PIN1_GPIO, HIGH);
+  mqttPublish("PinOut 1 -> ON");
+  return true;
+}
+
+static bool cmdPinOut1Off(const Command &c){
+  digitalWrite(PIN1_GPIO, LOW);
+  mqttPublish("PinOut 1 -> OFF");
+  return true;
+}
+
+static bool cmdPinOut2On(const Command &c){
+  digitalWrite(PIN2_GPIO, HIGH);
+  mqttPublish("PinOut 2 -> ON");
+  return true;
+}
+
+static bool cmdPinOut2Off(const Command &c){
+  digitalWrite(PIN2_GPIO, LOW);
+  mqttPublish("PinOut 2 -> OFF");
+  return true;
+}
+
+static bool cmdPresenceDump(const Command &c){
+  String r = presenceReport();
+  mqttPost("wol/presence", r.c_str(), r.length(), false);
+  return true;
+}
+
+#ifdef LOOP_PROFILER
+static bool cmdProfDump(const Command &c){
+  profPublish();
+  return true;
+}
+
+static bool cmdProfLoad(const Command &c){
+  profSetLoad(atoi(c.target));
+  return true;
+}
+#endif
+
+static constexpr CmdEntry cmdTable[] = {
+  { "TurnOn",       cmdTurnOn },
+  { "TurnOff",      cmdTurnOff },
+  { "CheckUpdate",  cmdCheckUpdate },
+  { "FactoryReset", cmdFactoryReset },
+  { "PingPC",       cmdPingPC },
+  { "WakeHost",     cmdWakeHost },
+  { "WakeGroup",    cmdWakeGroup },
+  { "WakeAll",      cmdWakeAll },
+  { "PingHost",     cmdPingHost },
+  { "PingAll",      cmdPingAll },
+  { "LogLevel",     cmdLogLevel },
+  { "PinOut1On",    cmdPinOut1On },
+  { "PinOut1Off",   cmdPinOut1Off },
+  { "PinOut2On",    cmdPinOut2On },
+  { "PinOut2Off",   cmdPinOut2Off },
+  { "PresenceDump", cmdPresenceDump },
+#ifdef LOOP_PROFILER
+  { "ProfDump",     cmdProfDump },
+  { "ProfLoad",     cmdProfLoad },
+#endif
+};
+
+// ---- Lookup ----
+
+static constexpr CmdPerfectHash<CmdEntry, sizeof(cmdTable) / sizeof(cmdTable[0])> cmdIndex(cmdTable);
+
+// ---- Idempotency ----
+
+RTC_NOINIT_ATTR static CmdWindow window;
+
+// Loop task only; a command that passes is recorded as run
+static CommandStatus admit(const Command &c){
+  return cmdAdmit(window, c.id, c.name, c.nameLen, c.target, c.ts, c.ts ? wallClockMs() : 0);
+}
+
+// id and name come from the client, ArduinoJson escapes them
+static void reply(const Command &c, const char* name, CommandStatus st, uint32_t rxUs, uint32_t actUs, uint32_t doneUs){
+  if(!c.id[0]) return;
+  JsonDocument doc;
+  doc["id"] = c.id;
+  doc["cmd"] = name;
+  doc["status"] = commandStatusNames[st];
+  doc["us"] = actUs - rxUs;
+  doc["exec_us"] = doneUs - actUs;
+  uint64_t now = c.ts ? wallClockMs() : 0;
+  if(now) doc["age_ms"] = (int64_t)(now - c.ts);
+
+  char json[256];
+  size_t n = serializeJson(doc, json, sizeof(json));
+  if(n && n < sizeof(json) - 1) mqttPost(CMD_RESPONSE_TOPIC, json, n, false);
+}
+
+static CommandListener listener = nullptr;
+
+void commandSetListener(CommandListener fn){
+  listener = fn;
+}
+
+CommandStatus commandExecute(const char* payload, size_t len, const char* source, uint32_t rxUs){
+  if(!rxUs) rxUs = (uint32_t)esp_timer_get_time();
+  Command cmd;
+  if(!commandParse(payload, len, cmd)) return CMD_UNKNOWN;
+  cmd.source = source;
+
+  const CmdEntry* e = cmdIndex.find(cmd.name, cmd.nameLen);
+  CommandStatus st = e ? admit(cmd) : CMD_UNKNOWN;
+  if(st != CMD_OK){
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    char name[CMD_ARG_LEN];
+    cmdCopyArg(name, cmd.name, cmd.nameLen);
+    if(st != CMD_UNKNOWN){
+      metricInc((CounterId)(CNT_CMD_DUPLICATE + st - CMD_DUPLICATE));
+      logMsg(LOGL_DEBUG, "Command: %s %s from %s not run (%s)", name, cmd.id, source, commandStatusNames[st]);
+    }
+    reply(cmd, name, st, rxUs, now, now);
+    return st;
+  }
+
+  static bool first = true;
+  if(first){
+    first = false;
+    char ms[12];
+    snprintf(ms, sizeof(ms), "%lu", millis());
+    logMsg(LOGL_INFO, "Boot: first command (%s) after %s ms", e->name, ms);
+    mqttPost("wol/boot/ttfc", ms, true);
+  }
+
+  metricInc(CNT_COMMANDS);
+  uint32_t actUs = (uint32_t)esp_timer_get_time();
+  metricObserve(HIST_CMD_LATENCY_US, actUs - rxUs);
+  blinkDigit(2);
+  st = e->fn(cmd) ? CMD_OK : CMD_FAILED;
+  reply(cmd, e->name, st, rxUs, actUs, (uint32_t)esp_timer_get_time());
+  if(listener && st == CMD_OK) listener(cmd, e->name);
+  return st;
+}
+
+// ---- Cross-task queue ----
+
+struct CmdMsg {
+  char        payload[CMD_MSG_LEN];
+  uint16_t    len;
+  uint32_t    rxUs;
+  const char* source;
+};
+
+static MpscQueue<CmdMsg, CMD_QUEUE_LEN> cmdQueue;
+
+bool commandPost(const char* payload, size_t len, const char* source){
+  if(len > CMD_MSG_LEN){
+    logMsg(LOGL_WARN, "Command: %s payload too long (%u bytes)", source, (unsigned)len);
+    return false;
+  }
+  CmdMsg m;
+  memcpy(m.payload, payload, len);
+  m.len = len;
+  m.rxUs = (uint32_t)esp_timer_get_time();
+  if(!m.rxUs) m.rxUs = 1;
+  m.source = source;
+  if(!cmdQueue.push(m)){
+    logMsg(LOGL_WARN, "Command: queue full, %s command dropped", source);
+    return false;
+  }
+  return true;
+}
+
+void commandPump(){
+  CmdMsg m;
+  while(cmdQueue.pop(m)) commandExecute(m.payload, m.len, m.source, m.rxUs);
+}
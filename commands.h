@@ -0,0 +1,35 @@
+/*
+ * commands.h
+ * -------------------------------
+ * Declares the command dispatcher shared by all transports:
+ *  - Parses a payload in place, without heap allocation
+ *  - Text form:  "TurnOn", "WakeHost:rack3-01"
+ *  - JSON form:  {"cmd":"TurnOn","target":"rack3","count":5}
+ *  - Optional "id" and "ts" (sender's Unix time, ms): an id already
+ *    executed is not run again (last CMD_DEDUP_IDS, kept in RTC
+ *    memory), a ts further than CMD_MAX_AGE_MS from the device clock
+ *    is stale, and a ts older than the last one run for the same
+ *    output/target (On and Off share it) is superseded
+ *  - Commands with an id get a reply on CMD_RESPONSE_TOPIC: status
+ *    and receipt-to-action time; a handler that could not act (TX
+ *    queue full, unknown host) reports CMD_FAILED
+ *  - Looks commands up through a compile-time perfect-hash table
+ *  - An optional listener sees every executed command (local API push)
+ *  - commandPost() hands a command from another task (mqtt, ui) to
+ *    the loop task, which runs it in commandPump()
+ */
+
+#pragma once
+#include "config.h"
+#include "command_parse.h"
+
+#define CMD_MSG_LEN       128    // longest payload accepted from another task
+#define CMD_QUEUE_LEN     8
+#define CMD_RESPONSE_TOPIC "wol/response"
+
+typedef void (*CommandListener)(const Command &cmd, const char* name);
+
+CommandStatus commandExecute(const char* payload, size_t len, const char* source, uint32_t rxUs = 0);
+void commandSetListener(CommandListener fn);
+bool commandPost(const char* payload, size_t len, const char* source);
+void commandPump();
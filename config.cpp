@@ -2,71 +2,223 @@
  * config.cpp
  * -------------------------------
  * Implements configuration management:
- *  - Saves and loads configuration to/from SPIFFS as JSON
+ *  - SPIFFS is mounted once by storageBegin()
+ *  - Config is stored in /config.bin: header (magic, schema version,
+ *    record size, CRC32) + the raw Config struct
+ *  - Older, shorter records are migrated by loading them over the
+ *    defaults (fields are only ever appended) and saving them back
+ *  - A legacy /config.json is imported once and removed
+ *  - JSON is kept as import/export format for the portal
  *  - Provides factoryReset() to delete config and restart ESP32
- *  - Publishes success messages via MQTT
  */
 
 
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
+#include <esp_rom_crc.h>
+#include <esp_random.h>
 #include "config.h"
 #include "mqtt.h"
 #include "helpers.h"
+#include "netif.h"
+#include "wake_watch.h"
+#include "buttons.h"
+#include "wifi_utils.h"
+
+#define CONFIG_FILE      "/config.bin"
+#define CONFIG_TMP_FILE  "/config.tmp"
+#define CONFIG_JSON_FILE "/config.json"
+#define CONFIG_MAGIC     0x47464357   // "WCFG"
+
+struct ConfigHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t crc;
+};
+
+// End of the last field of each schema version: sizeof(Config) of an
+// older firmware also counts the padding after its last field, which
+// must not be copied over the fields appended since
+static const size_t configVersionEnd[] = {
+    0,
+    offsetof(Config, api_token),         // v1
+    offsetof(Config, button_actions),    // v2
+    offsetof(Config, agent_key),         // v3
+    offsetof(Config, wifi_ap_after_s),   // v4
+    offsetof(Config, wol_relay),         // v5
+    sizeof(Config),                      // v6
+};
+static_assert(sizeof(configVersionEnd) / sizeof(configVersionEnd[0]) == CONFIG_VERSION + 1,
+              "add the previous version's end to configVersionEnd when bumping CONFIG_VERSION");
 
 Config config;
+portMUX_TYPE configLock = portMUX_INITIALIZER_UNLOCKED;
 unsigned long lastOTACheck = 0;
 unsigned long wolSentAt = 0;
 bool wolPendingPing = false;
-bool buttonTriggered = false;
 
-bool saveConfig(const Config &cfg) {
-    if (!SPIFFS.begin(true)) return false;
-    File f = SPIFFS.open("/config.json", "w");
-    if (!f) return false;
+static bool storageMounted = false;
 
-    JsonDocument doc;
+bool storageBegin() {
+    if (!storageMounted) storageMounted = SPIFFS.begin(true);
+    return storageMounted;
+}
+
+void configDefaults(Config &cfg) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mqtt_port = 8883;
+    cfg.udp_port = 9;
+    cfg.tx_mode = TX_MODE_BOTH;
+    cfg.tx_gap_ms = TX_GAP_MS_DEFAULT;
+    cfg.wake_deadline_s = WAKE_DEADLINE_S_DEFAULT;
+    cfg.wake_retries = WAKE_RETRIES_DEFAULT;
+    cfg.wifi_ap_after_s = WIFI_AP_AFTER_S_DEFAULT;
+    buttonDefaults(cfg);
+}
+
+void configToJson(const Config &cfg, JsonDocument &doc, bool secrets) {
     doc["ssid"]          = cfg.ssid;
-    doc["password"]      = cfg.password;
+    if (secrets) doc["password"] = cfg.password;
     doc["mqtt_server"]   = cfg.mqtt_server;
     doc["mqtt_port"]     = cfg.mqtt_port;
     doc["mqtt_user"]     = cfg.mqtt_user;
-    doc["mqtt_password"] = cfg.mqtt_password;
+    if (secrets) doc["mqtt_password"] = cfg.mqtt_password;
+    if (secrets) doc["api_token"] = cfg.api_token;
+    if (secrets) doc["agent_key"] = cfg.agent_key;
     doc["target_ip"]     = cfg.target_ip;
     doc["broadcastIP"]   = cfg.broadcastIPStr;
     doc["udp_port"]      = cfg.udp_port;
+    doc["tx_mode"]       = cfg.tx_mode == TX_MODE_FAILOVER ? "failover" : "both";
+    doc["tx_gap_ms"]     = cfg.tx_gap_ms;
+    doc["probe_port"]    = cfg.probe_port;
+    doc["wake_deadline_s"] = cfg.wake_deadline_s;
+    doc["wake_retries"]  = cfg.wake_retries;
+    doc["wifi_ap_after_s"] = cfg.wifi_ap_after_s;
+    doc["wifi_reuse_ip"] = cfg.wifi_reuse_ip;
+    doc["wol_relay"]     = cfg.wol_relay;
+
+    JsonObject buttons = doc["buttons"].to<JsonObject>();
+    for (int b = 0; b < BUTTON_COUNT; b++) {
+        JsonObject g = buttons[buttonNames[b]].to<JsonObject>();
+        for (int i = 0; i < GESTURE_COUNT; i++) g[gestureNames[i]] = cfg.button_actions[b][i];
+    }
 
     char macStr[18];
-    sprintf(macStr, "%02X:%02X:%02X:%02X:%02X:%02X",
-            cfg.mac_address[0], cfg.mac_address[1], cfg.mac_address[2],
-            cfg.mac_address[3], cfg.mac_address[4], cfg.mac_address[5]);
-    
+    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             cfg.mac_address[0], cfg.mac_address[1], cfg.mac_address[2],
+             cfg.mac_address[3], cfg.mac_address[4], cfg.mac_address[5]);
     doc["mac_address"] = macStr;
+}
 
-    // Save the json
-    serializeJsonPretty(doc, f);
-    f.close();
+static void clampInt(int &v, int lo, int hi) {
+    v = v < lo ? lo : v > hi ? hi : v;
+}
+
+// The ranges the setup page declares (portal/setup.html)
+void configClamp(Config &cfg) {
+    clampInt(cfg.mqtt_port, 1, 65535);
+    clampInt(cfg.udp_port, 1, 65535);
+    clampInt(cfg.tx_gap_ms, 1, 1000);
+    clampInt(cfg.probe_port, 0, 65535);
+    clampInt(cfg.wake_deadline_s, 10, 3600);
+    clampInt(cfg.wake_retries, 0, 10);
+    clampInt(cfg.wifi_ap_after_s, 0, 86400);
+}
+
+static void jsonStr(JsonDocument &doc, const char* key, char* dst, size_t size) {
+    if (doc[key].is<const char*>()) strlcpy(dst, doc[key].as<const char*>(), size);
+}
+
+static void jsonInt(JsonDocument &doc, const char* key, int &dst) {
+    if (doc[key].is<int>()) dst = doc[key].as<int>();
+}
 
-    Serial.println();
-    File f2 = SPIFFS.open("/config.json", "r");
-    if (f2) {
-        Serial.println("Config JSON (saved in /config.json):");
-        while (f2.available()) {
-            Serial.write(f2.read());
+// Fields missing from the document keep their current value in cfg
+bool configFromJson(JsonDocument &doc, Config &cfg) {
+    jsonStr(doc, "ssid", cfg.ssid, sizeof(cfg.ssid));
+    jsonStr(doc, "password", cfg.password, sizeof(cfg.password));
+    jsonStr(doc, "mqtt_server", cfg.mqtt_server, sizeof(cfg.mqtt_server));
+    jsonInt(doc, "mqtt_port", cfg.mqtt_port);
+    jsonStr(doc, "mqtt_user", cfg.mqtt_user, sizeof(cfg.mqtt_user));
+    jsonStr(doc, "mqtt_password", cfg.mqtt_password, sizeof(cfg.mqtt_password));
+    jsonStr(doc, "api_token", cfg.api_token, sizeof(cfg.api_token));
+    jsonStr(doc, "agent_key", cfg.agent_key, sizeof(cfg.agent_key));
+    jsonStr(doc, "target_ip", cfg.target_ip, sizeof(cfg.target_ip));
+    jsonStr(doc, "broadcastIP", cfg.broadcastIPStr, sizeof(cfg.broadcastIPStr));
+    jsonInt(doc, "udp_port", cfg.udp_port);
+    if (doc["tx_mode"].is<const char*>())
+        cfg.tx_mode = strcmp(doc["tx_mode"].as<const char*>(), "failover") == 0 ? TX_MODE_FAILOVER : TX_MODE_BOTH;
+    jsonInt(doc, "tx_gap_ms", cfg.tx_gap_ms);
+    jsonInt(doc, "probe_port", cfg.probe_port);
+    jsonInt(doc, "wake_deadline_s", cfg.wake_deadline_s);
+    jsonInt(doc, "wake_retries", cfg.wake_retries);
+    jsonInt(doc, "wifi_ap_after_s", cfg.wifi_ap_after_s);
+    if (doc["wifi_reuse_ip"].is<int>()) cfg.wifi_reuse_ip = doc["wifi_reuse_ip"].as<int>() != 0;
+    if (doc["wol_relay"].is<int>()) cfg.wol_relay = doc["wol_relay"].as<int>() != 0;
+
+    for (int b = 0; b < BUTTON_COUNT; b++) {
+        for (int i = 0; i < GESTURE_COUNT; i++) {
+            JsonVariant v = doc["buttons"][buttonNames[b]][gestureNames[i]];
+            if (v.is<const char*>()) strlcpy(cfg.button_actions[b][i], v.as<const char*>(), BUTTON_ACTION_LEN);
         }
-        f2.close();
-        Serial.println();
-    } else {
-        Serial.println("Error reopening /config.json");
     }
-    Serial.println();
 
+    configClamp(cfg);
+    if (doc["mac_address"].is<const char*>() && !parseMac(doc["mac_address"].as<const char*>(), cfg.mac_address))
+        return false;
     return true;
 }
 
-bool loadConfig() {
-    if (!SPIFFS.begin(true)) return false;
-    File f = SPIFFS.open("/config.json", "r");
+// Written to a temp file and renamed, so a power cut never leaves half a
+// record; one between remove() and rename() leaves only the temp file,
+// which loadConfig() takes over
+bool saveConfig(const Config &cfg) {
+    if (!storageBegin()) return false;
+    File f = SPIFFS.open(CONFIG_TMP_FILE, "w");
+    if (!f) return false;
+
+    ConfigHeader h = { CONFIG_MAGIC, CONFIG_VERSION, sizeof(Config),
+                       esp_rom_crc32_le(0, (const uint8_t*)&cfg, sizeof(Config)) };
+    bool ok = f.write((const uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+              f.write((const uint8_t*)&cfg, sizeof(cfg)) == sizeof(cfg);
+    f.close();
+
+    if (!ok) {
+        SPIFFS.remove(CONFIG_TMP_FILE);
+        return false;
+    }
+    SPIFFS.remove(CONFIG_FILE);
+    return SPIFFS.rename(CONFIG_TMP_FILE, CONFIG_FILE);
+}
+
+static bool loadBinary(const char* path, Config &cfg, bool &migrated) {
+    File f = SPIFFS.open(path, "r");
+    if (!f) return false;
+
+    ConfigHeader h;
+    uint8_t raw[sizeof(Config)];
+    bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+              h.magic == CONFIG_MAGIC && h.version >= 1 && h.version <= CONFIG_VERSION &&
+              h.size <= sizeof(Config) &&
+              f.read(raw, h.size) == h.size &&
+              h.crc == esp_rom_crc32_le(0, raw, h.size);
+    f.close();
+
+    if (!ok) {
+        logMsg(LOGL_ERROR, "Config: %s is corrupt or from a newer firmware", path);
+        return false;
+    }
+
+    configDefaults(cfg);
+    memcpy(&cfg, raw, std::min<size_t>(h.size, configVersionEnd[h.version]));
+    migrated = h.version != CONFIG_VERSION || h.size != sizeof(Config);
+    if (migrated) logMsg(LOGL_INFO, "Config: Migrated schema v%u (%u bytes) to v%u", h.version, h.size, CONFIG_VERSION);
+    return true;
+}
+
+static bool loadLegacyJson(Config &cfg) {
+    File f = SPIFFS.open(CONFIG_JSON_FILE, "r");
     if (!f) return false;
 
     JsonDocument doc;
@@ -74,33 +226,36 @@ bool loadConfig() {
     f.close();
     if (err) return false;
 
-    strlcpy(config.ssid, doc["ssid"] | "", sizeof(config.ssid));
-    strlcpy(config.password, doc["password"] | "", sizeof(config.password));
-    strlcpy(config.mqtt_server, doc["mqtt_server"] | "", sizeof(config.mqtt_server));
-    config.mqtt_port = doc["mqtt_port"] | 8883;
-    strlcpy(config.mqtt_user, doc["mqtt_user"] | "", sizeof(config.mqtt_user));
-    strlcpy(config.mqtt_password, doc["mqtt_password"] | "", sizeof(config.mqtt_password));
-    strlcpy(config.target_ip, doc["target_ip"] | "", sizeof(config.target_ip));
-    strlcpy(config.broadcastIPStr, doc["broadcastIP"] | "", sizeof(config.broadcastIPStr));
-    config.udp_port = doc["udp_port"] | 9;
-    
-    const char* macStr = doc["mac_address"];
-    for (int i = 0; i < 6; i++) {
-      char byteStr[3] = { macStr[i*3], macStr[i*3 + 1], '\0' };
-      config.mac_address[i] = (uint8_t) strtoul(byteStr, nullptr, 16);
-    }
+    configDefaults(cfg);
+    return configFromJson(doc, cfg);
+}
 
-    Serial.println();
-    File f2 = SPIFFS.open("/config.json", "r");
-    if (f2) {
-        Serial.println("Config JSON (load from /config.json):");
-        while (f2.available()) {
-            Serial.write(f2.read());
-        }
-        f2.close();
-        Serial.println();
+bool loadConfig() {
+    if (!storageBegin()) return false;
+
+    unsigned long t0 = micros();
+    bool migrated = false;
+    if (loadBinary(CONFIG_FILE, config, migrated)) {
+        logMsg(LOGL_INFO, "Config: Loaded %s in %lu us", CONFIG_FILE, micros() - t0);
+        if (migrated) saveConfig(config);
+    } else if (!SPIFFS.exists(CONFIG_FILE) && loadBinary(CONFIG_TMP_FILE, config, migrated)) {
+        // saveConfig() was cut between remove() and rename()
+        logMsg(LOGL_WARN, "Config: Recovered %s from %s", CONFIG_FILE, CONFIG_TMP_FILE);
+        if (migrated) saveConfig(config);
+        else SPIFFS.rename(CONFIG_TMP_FILE, CONFIG_FILE);
+    } else if (loadLegacyJson(config)) {
+        logMsg(LOGL_INFO, "Config: Imported %s in %lu us", CONFIG_JSON_FILE, micros() - t0);
+        if (saveConfig(config)) SPIFFS.remove(CONFIG_JSON_FILE);
     } else {
-        Serial.println("Error reopening /config.json");
+        return false;
+    }
+
+    if (!config.api_token[0]) {
+        for (int i = 0; i < 4; i++) snprintf(config.api_token + i * 8, 9, "%08lx", (unsigned long)esp_random());
+        saveConfig(config);
+        // Serial only: wol/log goes to the broker and the log ring
+        Serial.printf("Config: Local API token generated: %s\n", config.api_token);
+        logMsg(LOGL_INFO, "Config: Local API token generated (printed on Serial)");
     }
 
     mqttPublish("Configuration loaded successfully!");
@@ -109,8 +264,11 @@ bool loadConfig() {
 
 void factoryReset() {
     mqttPublish("--- FACTORY RESET ---");
-    if (!SPIFFS.begin(true)) return;
-    if (SPIFFS.exists("/config.json")) SPIFFS.remove("/config.json");
+    logFlush();
+    if (!storageBegin()) return;
+    SPIFFS.remove(CONFIG_FILE);
+    SPIFFS.remove(CONFIG_TMP_FILE);
+    SPIFFS.remove(CONFIG_JSON_FILE);
     delay(2000);
     ESP.restart();
 }
@@ -4,13 +4,19 @@
  * Declares the configuration structure and global variables:
  *  - WiFi and MQTT credentials
  *  - Target PC IP and MAC for WOL
- *  - GPIO pins for button and LED
+ *  - Transmit mode (both interfaces / failover) and packet spacing
+ *  - Shared key of the acknowledged host agent protocol
+ *  - WiFi outage before the config AP opens, DHCP lease reuse
+ *  - WOL relay between WiFi and the W5500
+ *  - GPIO pins for button and LED, button gesture actions
  *  - OTA check interval and ping delay
  *  - Functions for saving, loading, and resetting configuration
+ *  - JSON import/export of the record (portal)
  */
 
 #pragma once
 #include <Arduino.h>
+#include <ArduinoJson.h>
 
 #define FIRMWARE_VERSION      "6.1"
 #define RESET_OTA_BUTTON_PIN  D2
@@ -19,7 +25,18 @@
 #define PIN1_GPIO             D4
 #define PIN2_GPIO             D5
 #define OTA_CHECK_INTERVAL_MS 43200000UL  // 12h
-#define PING_DELAY_AFTER_WOL  60000UL    // 1min
+#define PING_DELAY_AFTER_WOL  60000UL    // 1min, after shutdown
+#define TX_GAP_MS_DEFAULT     5
+#define CONFIG_VERSION        6     // bump when Config changes
+#define API_TOKEN_LEN         33
+#define AGENT_KEY_LEN         33
+#define BUTTON_COUNT          2     // ButtonId (buttons.h)
+#define GESTURE_COUNT         4     // Gesture (buttons.h)
+#define BUTTON_ACTION_LEN     32
+
+// Stored as-is in /config.bin: only append fields at the end, older
+// (shorter) records are loaded over configDefaults() up to the end
+// of their last field (configVersionEnd in config.cpp)
 
 struct Config {
   char ssid[32];
@@ -32,14 +49,33 @@ struct Config {
   char broadcastIPStr[16];
   uint8_t mac_address[6];
   int  udp_port;
+  uint8_t tx_mode;     // TxMode (netif.h)
+  int  tx_gap_ms;
+  int  probe_port;     // TCP port for connect probes, 0 = ICMP only
+  int  wake_deadline_s;
+  int  wake_retries;
+  char api_token[API_TOKEN_LEN];   // v2: local HTTP/WebSocket API
+  char button_actions[BUTTON_COUNT][GESTURE_COUNT][BUTTON_ACTION_LEN];   // v3: command per gesture
+  char agent_key[AGENT_KEY_LEN];   // v4: host agent HMAC key, empty = legacy shutdown packet
+  int  wifi_ap_after_s;            // v5: outage before the config AP opens, 0 = never
+  uint8_t wifi_reuse_ip;           // v5: fast reconnect reuses the last DHCP lease
+  uint8_t wol_relay;               // v6: relay magic packets between WiFi and LAN (relay.h)
 };
 
 extern Config config;
+// Held while the portal replaces config and fleetHosts[0] live; the
+// tx, probe and presence tasks hold it to copy the strings, MACs and
+// IPs they read from either (single ints are read as they are)
+extern portMUX_TYPE configLock;
 extern unsigned long lastOTACheck;
 extern unsigned long wolSentAt;
 extern bool wolPendingPing;
-extern bool buttonTriggered;
 
+bool storageBegin();
+void configDefaults(Config &cfg);
+void configClamp(Config &cfg);
+void configToJson(const Config &cfg, JsonDocument &doc, bool secrets);
+bool configFromJson(JsonDocument &doc, Config &cfg);
 bool saveConfig(const Config &cfg);
 bool loadConfig();
 void factoryReset();
@@ -2,43 +2,55 @@
  * configPortal.cpp
  * -------------------------------
  * Implements the WiFi/MQTT configuration portal:
- *  - Serves HTML form to input SSID, MQTT server, and WOL target
- *  - Parses POST requests to save config
- *  - Stores configuration to SPIFFS using saveConfig()
- *  - Restarts ESP32 after saving
+ *  - Serves the setup page from flash (portal_assets.h), gzipped,
+ *    with ETag / Cache-Control; no SPIFFS image needed
+ *  - /api/config: GET returns the config as JSON (no passwords),
+ *    POST/PUT applies a partial JSON update; only WiFi, MQTT, UDP
+ *    port or WOL relay changes restart the ESP32, the rest applies
+ *    live under configLock
+ *  - /config.json: the same JSON as a download / import
+ *  - /save keeps the plain form POST (saves and restarts)
+ *  - /wake?host=<name> | ?group=<group> | ?all=1 queues fleet WOL
+ *  - /metrics serves the metrics registry (Prometheus text)
+ *  - In STA mode everything but / and /metrics needs the API token
+ *    (local_api.h)
  */
 
 #include "configPortal.h"
-#include <SPIFFS.h>
 #include <ArduinoJson.h>
 #include <WiFi.h>
+#include "fleet.h"
+#include "netif.h"
+#include "wake_watch.h"
+#include "wifi_utils.h"
+#include "helpers.h"
+#include "metrics.h"
+#include "profiler.h"
+#include "portal_assets.h"
+#include "local_api.h"
 
 WebServer server(80);
 
+static const char* requestHeaders[] = { "If-None-Match", "Authorization" };
+
 void handleRoot(){
-  if(!SPIFFS.begin(true)){ 
-    server.send(500,"text/plain","SPIFFS error");
-    return;
-  }
-  
-  File f = SPIFFS.open("/setup.html","r");
-  
-  if(!f){ 
-    server.send(404,"text/plain","File not found");
-    return;
+  unsigned long t0 = micros();
+  server.sendHeader("ETag", setupHtmlEtag);
+  server.sendHeader("Cache-Control", "no-cache");   // always revalidate, a 304 is cheap
+
+  if(server.header("If-None-Match") == setupHtmlEtag){
+    server.send(304, "text/html", "");
+  } else {
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, "text/html", (const char*)setupHtmlGz, sizeof(setupHtmlGz));
   }
-  
-  server.streamFile(f,"text/html");
-  f.close();
+  logMsg(LOGL_DEBUG, "HTTP: / served in %lu us", micros() - t0);
 }
 
+// Starts from the running config (defaults when none was loaded), so
+// api_token, agent_key and the button actions the form lacks survive
 void handleSave(){
-  if(!SPIFFS.begin(true)){ 
-    server.send(500,"text/plain","SPIFFS error");
-    return;
-  }
-
-  Config newCfg;
+  Config newCfg = config;
 
   strlcpy(newCfg.ssid, server.arg("ssid").c_str(), sizeof(newCfg.ssid));
   strlcpy(newCfg.password, server.arg("password").c_str(), sizeof(newCfg.password));
@@ -49,12 +61,21 @@ void handleSave(){
   strlcpy(newCfg.target_ip, server.arg("target_ip").c_str(), sizeof(newCfg.target_ip));
   strlcpy(newCfg.broadcastIPStr, server.arg("broadcastIP").c_str(), sizeof(newCfg.broadcastIPStr));
 
-  String macStr = server.arg("mac_address");
-  sscanf(macStr.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-         &newCfg.mac_address[0], &newCfg.mac_address[1], &newCfg.mac_address[2],
-         &newCfg.mac_address[3], &newCfg.mac_address[4], &newCfg.mac_address[5]);
+  if(!parseMac(server.arg("mac_address").c_str(), newCfg.mac_address)){
+    server.send(400,"text/html","<h3>Invalid MAC address</h3>");
+    return;
+  }
 
   newCfg.udp_port = server.arg("udp_port").toInt();
+  newCfg.tx_mode = server.arg("tx_mode") == "failover" ? TX_MODE_FAILOVER : TX_MODE_BOTH;
+  newCfg.tx_gap_ms = server.hasArg("tx_gap_ms") ? server.arg("tx_gap_ms").toInt() : TX_GAP_MS_DEFAULT;
+  newCfg.probe_port = server.arg("probe_port").toInt();
+  newCfg.wake_deadline_s = server.hasArg("wake_deadline_s") ? server.arg("wake_deadline_s").toInt() : WAKE_DEADLINE_S_DEFAULT;
+  newCfg.wake_retries = server.hasArg("wake_retries") ? server.arg("wake_retries").toInt() : WAKE_RETRIES_DEFAULT;
+  newCfg.wifi_ap_after_s = server.hasArg("wifi_ap_after_s") ? server.arg("wifi_ap_after_s").toInt() : WIFI_AP_AFTER_S_DEFAULT;
+  newCfg.wifi_reuse_ip = server.arg("wifi_reuse_ip").toInt() != 0;
+  newCfg.wol_relay = server.arg("wol_relay").toInt() != 0;
+  configClamp(newCfg);
 
   if(saveConfig(newCfg)){
     server.send(200,"text/html","<h3>Config saved! Rebooting...</h3>");
@@ -65,6 +86,84 @@ void handleSave(){
   }
 }
 
+static void sendJsonError(int code, const char* msg){
+  String out = "{\"error\":\"";
+  out += msg;
+  out += "\"}";
+  server.send(code, "application/json", out);
+}
+
+// Settings read only at boot (WiFi, MQTT, sockets)
+static bool needsRestart(const Config &a, const Config &b){
+  return strcmp(a.ssid, b.ssid) || strcmp(a.password, b.password) ||
+         strcmp(a.mqtt_server, b.mqtt_server) || a.mqtt_port != b.mqtt_port ||
+         strcmp(a.mqtt_user, b.mqtt_user) || strcmp(a.mqtt_password, b.mqtt_password) ||
+         a.udp_port != b.udp_port || a.wol_relay != b.wol_relay;
+}
+
+void handleApiConfigGet(){
+  if(!httpAuthorized()) return;
+  JsonDocument doc;
+  configToJson(config, doc, false);
+  String out;
+  serializeJson(doc, out);
+  server.send(200, "application/json", out);
+}
+
+// Fields the document leaves out keep their current value
+void handleApiConfigSet(){
+  if(!httpAuthorized()) return;
+  JsonDocument doc;
+  if(deserializeJson(doc, server.arg("plain"))){
+    sendJsonError(400, "invalid JSON");
+    return;
+  }
+
+  Config newCfg = config;
+  if(!configFromJson(doc, newCfg)){
+    sendJsonError(400, "invalid mac_address");
+    return;
+  }
+  if(!saveConfig(newCfg)){
+    sendJsonError(500, "save failed");
+    return;
+  }
+
+  bool restart = needsRestart(config, newCfg);
+  portENTER_CRITICAL(&configLock);
+  config = newCfg;
+  fleetRefreshDefault();
+  portEXIT_CRITICAL(&configLock);
+  server.send(200, "application/json", restart ? "{\"saved\":true,\"restart\":true}" : "{\"saved\":true,\"restart\":false}");
+  logMsg(LOGL_INFO, "Config: updated over HTTP%s", restart ? ", restarting" : "");
+
+  if(restart){
+    logFlush();
+    delay(1000);
+    ESP.restart();
+  }
+}
+
+void handleConfigExport(){
+  if(!httpAuthorized()) return;
+  JsonDocument doc;
+  configToJson(config, doc, false);
+  String out;
+  serializeJsonPretty(doc, out);
+  server.sendHeader("Content-Disposition", "attachment; filename=config.json");
+  server.send(200,"application/json",out);
+}
+
+static void registerConfigRoutes(){
+  server.collectHeaders(requestHeaders, 2);
+  server.on("/", HTTP_GET, handleRoot);
+  server.on("/api/config", HTTP_GET, handleApiConfigGet);
+  server.on("/api/config", HTTP_POST, handleApiConfigSet);
+  server.on("/api/config", HTTP_PUT, handleApiConfigSet);
+  server.on("/config.json", HTTP_GET, handleConfigExport);
+  server.on("/config.json", HTTP_POST, handleApiConfigSet);
+}
+
 void startConfigPortal(){
   WiFi.mode(WIFI_AP);
   WiFi.softAP("WOL_ESP32C3_Setup");
@@ -72,7 +171,37 @@ void startConfigPortal(){
   Serial.println("Connect to WiFi AP: WOL_ESP32C3_Setup");
   Serial.println("Open http://192.168.4.1 in browser");
 
-  server.on("/", HTTP_GET, handleRoot);
+  registerConfigRoutes();
   server.on("/save", HTTP_POST, handleSave);
   server.begin();
 }
+
+
+void handleWake(){
+  if(!httpAuthorized()) return;
+  int n = 0;
+  if(server.hasArg("host"))       n = fleetWakeHost(server.arg("host").c_str(), 10);
+  else if(server.hasArg("group")) n = fleetWakeGroup(server.arg("group").c_str(), 10);
+  else if(server.hasArg("all"))   n = fleetWakeAll(10);
+  else {
+    server.send(400,"text/plain","Use host=, group= or all=1");
+    return;
+  }
+
+  if(n == 0){
+    server.send(404,"text/plain","No matching hosts");
+    return;
+  }
+  server.send(200,"text/plain","Waking " + String(n) + " hosts");
+}
+
+void startControlServer(){
+  server.on("/wake", HTTP_GET, handleWake);
+  server.on("/metrics", HTTP_GET, handleMetrics);
+#ifdef LOOP_PROFILER
+  server.on("/profile", HTTP_GET, handleProfile);
+#endif
+  registerConfigRoutes();
+  localApiBegin();
+  server.begin();
+}
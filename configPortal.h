@@ -3,8 +3,10 @@
  * -------------------------------
  * Declares functions for the WiFi/MQTT configuration portal:
  *  - startConfigPortal() starts a web server for user configuration
- *  - handleRoot() serves the setup HTML page
+ *  - handleRoot() serves the embedded, gzipped setup page
  *  - handleSave() saves posted configuration and restarts ESP32
+ *  - /api/config JSON read / partial update, /config.json download
+ *  - startControlServer() serves fleet wake commands in STA mode
  */
 
 #pragma once
@@ -15,4 +17,9 @@ extern WebServer server;
 
 void startConfigPortal();
 void handleRoot();
-void handleSave();
\ No newline at end of file
+void handleSave();
+void handleWake();
+void handleApiConfigGet();
+void handleApiConfigSet();
+void handleConfigExport();
+void startControlServer();
\ No newline at end of file
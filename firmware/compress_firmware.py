@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+"""
+compress_firmware.py
+-------------------------------
+Prepares the OTA files for a new build
+ - WOL_ESP32.bin.gz     : gzip -9, fixed mtime so the output is reproducible
+ - WOL_ESP32.bin.sha256 : digest of the raw image (what ends up in flash)
+Usage: python3 compress_firmware.py [WOL_ESP32.bin]
+"""
+import gzip
+import hashlib
+import os
+import sys
+
+src = sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), "WOL_ESP32.bin")
+name = os.path.basename(src)
+
+with open(src, "rb") as f:
+    raw = f.read()
+
+with open(src + ".gz", "wb") as f:
+    with gzip.GzipFile(filename="", mode="wb", compresslevel=9, fileobj=f, mtime=0) as gz:
+        gz.write(raw)
+
+digest = hashlib.sha256(raw).hexdigest()
+with open(src + ".sha256", "w") as f:
+    f.write(f"{digest}  {name}\n")
+
+packed = os.path.getsize(src + ".gz")
+print(f"{name}: {len(raw)} bytes -> {packed} bytes gzip ({100.0 * packed / len(raw):.1f}%)")
+print(f"sha256 {digest}")
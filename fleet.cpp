@@ -0,0 +1,253 @@
+/*
+ * fleet.cpp
+ * -------------------------------
+ * Implements the multi-target WOL fleet table:
+ *  - Loads /targets.json from SPIFFS after config.json
+ *  - Keeps the 16x MAC body of every host in one contiguous array;
+ *    the 6-byte header (0xFF wake / 0xEE shutdown) is shared
+ *    (fleet_batch.h)
+ *  - fleetQueue() (loop task) hands (host, packet, repeats) jobs to
+ *    the "tx" task through an SPSC queue and wakes it
+ *  - The tx task sends FLEET_TX_PER_TICK frames every
+ *    config.tx_gap_ms through netif, round-robin across hosts so
+ *    repeats are spread out, and polls the W5500 link while idle
+ *  - Publishes a summary (per-interface sent/failed, duration,
+ *    free heap) per batch
+ *  - Agent jobs bypass the batch and go to agentStart(); the task
+ *    runs agentTick() every pass and polls faster while requests
+ *    wait for an ack or the relay is on
+ *  - Reads the UDP sockets each pass: agent acks go to
+ *    agentInput(), everything else to the WOL relay (relay.h)
+ *  - Also drains the W5500 DHCP socket for presence.cpp
+ */
+
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include "fleet.h"
+#include "helpers.h"
+#include "tasks.h"
+#include "lockfree_queue.h"
+#include "wake_watch.h"
+#include "metrics.h"
+#include "agent.h"
+#include "presence.h"
+#include "relay.h"
+
+FleetHost fleetHosts[FLEET_MAX_HOSTS];
+int fleetSize = 0;
+
+static uint8_t fleetBodies[FLEET_MAX_HOSTS][FLEET_BODY_LEN];
+
+static SpscQueue<FleetJob, FLEET_QUEUE_LEN> txQueue;   // loop -> tx
+static TaskHandle_t txTask = NULL;
+
+// tx task only
+static FleetBatch<FLEET_QUEUE_LEN> batch;
+static volatile bool inBatch = false;
+static unsigned long batchStart = 0;
+static NetifStats wifiAtStart;
+static NetifStats ethAtStart;
+
+static uint8_t parseIface(const char* s){
+  if(!strcmp(s, "wifi")) return NETIF_WIFI;
+  if(!strcmp(s, "eth"))  return NETIF_ETH;
+  return NETIF_BOTH;
+}
+
+// Host 0 mirrors the config target; called again after live config changes
+void fleetRefreshDefault(){
+  FleetHost &h = fleetHosts[0];
+  strlcpy(h.name, "pc", sizeof(h.name));
+  strlcpy(h.group, "default", sizeof(h.group));
+  memcpy(h.mac, config.mac_address, 6);
+  IPAddress ip;
+  ip.fromString(config.target_ip);
+  for(int k = 0; k < 4; k++) h.ip[k] = ip[k];
+  h.port = config.udp_port;
+  h.iface = NETIF_BOTH;
+  fleetBuildBody(fleetBodies[0], h.mac);
+}
+
+// Other tasks read hosts through a copy: host 0 changes with the config
+FleetHost fleetHostCopy(int host){
+  portENTER_CRITICAL(&configLock);
+  FleetHost h = fleetHosts[host];
+  portEXIT_CRITICAL(&configLock);
+  return h;
+}
+
+bool loadFleet(){
+  fleetRefreshDefault();
+  fleetSize = 1;
+
+  File f = SPIFFS.open("/targets.json", "r");
+  if(!f) return true;
+
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, f);
+  f.close();
+  if(err){
+    logMsg(LOGL_ERROR, "Fleet: /targets.json parse error");
+    return false;
+  }
+
+  for(JsonObject t : doc.as<JsonArray>()){
+    if(fleetSize >= FLEET_MAX_HOSTS){
+      logMsg(LOGL_WARN, "Fleet: table full, extra hosts ignored");
+      break;
+    }
+
+    FleetHost &h = fleetHosts[fleetSize];
+    if(!parseMac(t["mac"] | "", h.mac)) continue;
+
+    strlcpy(h.name, t["name"] | "", sizeof(h.name));
+    strlcpy(h.group, t["group"] | "", sizeof(h.group));
+    IPAddress ip;
+    ip.fromString(t["ip"] | "0.0.0.0");
+    for(int k = 0; k < 4; k++) h.ip[k] = ip[k];
+    h.port = t["port"] | config.udp_port;
+    h.iface = parseIface(t["iface"] | "both");
+
+    fleetBuildBody(fleetBodies[fleetSize], h.mac);
+    fleetSize++;
+  }
+
+  logMsg(LOGL_INFO, "Fleet: %d hosts loaded", fleetSize);
+  return true;
+}
+
+int fleetFind(const char* name){
+  for(int i = 0; i < fleetSize; i++){
+    if(!strcmp(fleetHosts[i].name, name)) return i;
+  }
+  return -1;
+}
+
+static void fleetSendOne(const FleetJob &job){
+  uint8_t body[FLEET_BODY_LEN];
+  portENTER_CRITICAL(&configLock);
+  uint8_t iface = fleetHosts[job.host].iface;
+  uint16_t port = fleetHosts[job.host].port;
+  memcpy(body, fleetBodies[job.host], FLEET_BODY_LEN);
+  portEXIT_CRITICAL(&configLock);
+
+  const uint8_t* header = job.kind == FLEET_PKT_SHUTDOWN ? fleetShutdownHeader : fleetWakeHeader;
+  uint8_t done = netifSend(iface, port, header, sizeof(fleetWakeHeader), body, FLEET_BODY_LEN);
+
+  bool shutdown = job.kind == FLEET_PKT_SHUTDOWN;
+  if(done & NETIF_WIFI) metricInc(shutdown ? CNT_SHUTDOWN_WIFI : CNT_WOL_WIFI);
+  if(done & NETIF_ETH)  metricInc(shutdown ? CNT_SHUTDOWN_ETH : CNT_WOL_ETH);
+}
+
+static void fleetSendTick(){
+  batch.tick(FLEET_TX_PER_TICK, fleetSendOne);
+
+  if(batch.empty()){
+    inBatch = false;
+    unsigned long ms = millis() - batchStart;
+    logMsg(LOGL_INFO, "Fleet: batch done in %lu ms, Wi-Fi %lu sent/%lu failed, LAN %lu sent/%lu failed, free heap %lu",
+           ms, wifiStats.sent - wifiAtStart.sent, wifiStats.failed - wifiAtStart.failed,
+           ethStats.sent - ethAtStart.sent, ethStats.failed - ethAtStart.failed, (unsigned long)ESP.getFreeHeap());
+  }
+}
+
+void fleetDropJobs(int host, FleetPacket kind){
+  batch.drop(host, kind);
+}
+
+static void rxPoll(){
+  uint8_t buf[RELAY_RX_LEN];
+  NetifRx rx;
+  size_t n;
+  while((n = netifReceive(buf, sizeof(buf), rx)) > 0){
+    if(!agentInput(buf, n)) relayInput(buf, n, rx);
+  }
+}
+
+static void fleetTxTask(void*){
+  unsigned long lastPoll = millis();
+  unsigned long lastTick = 0;
+  for(;;){
+    FleetJob job;
+    while(!batch.full() && txQueue.pop(job)){
+      if(job.kind == FLEET_PKT_AGENT_SHUTDOWN || job.kind == FLEET_PKT_AGENT_WAKE){
+        agentStart(job.host, job.kind == FLEET_PKT_AGENT_SHUTDOWN ? AGENT_SHUTDOWN : AGENT_WAKE, job.left);
+        continue;
+      }
+      if(!inBatch){
+        inBatch = true;
+        batchStart = millis();
+        wifiAtStart = wifiStats;
+        ethAtStart = ethStats;
+      }
+      batch.add(job);
+    }
+    uint32_t gap = max(config.tx_gap_ms, 1);
+    if(!batch.empty() && millis() - lastTick >= gap){
+      lastTick = millis();
+      fleetSendTick();
+    }
+    rxPoll();
+    agentTick();
+    presenceEthPoll();
+
+    if(millis() - lastPoll >= NETIF_LINK_POLL_MS){
+      lastPoll = millis();
+      netifPoll();
+    }
+
+    uint32_t wait = min(min(!batch.empty() ? gap : (uint32_t)NETIF_LINK_POLL_MS, agentNextMs()), relayNextMs());
+    if(!batch.empty()) vTaskDelay(pdMS_TO_TICKS(wait));
+    else ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+  }
+}
+
+void fleetBegin(){
+  if(!taskStart(fleetTxTask, "tx", TASK_STACK_TX, TASK_PRIO_TX, TASK_CORE_APP, &txTask))
+    logMsg(LOGL_ERROR, "Fleet: Could not start tx task");
+}
+
+// Loop task only (single producer)
+int fleetQueue(int host, FleetPacket kind, int n){
+  if(host < 0 || host >= fleetSize || n <= 0) return 0;
+
+  if(kind == FLEET_PKT_SHUTDOWN){
+    presenceForget(host);
+    if(agentEnabled()) kind = FLEET_PKT_AGENT_SHUTDOWN;
+  }
+
+  FleetJob job = { (uint16_t)host, (uint8_t)kind, (uint8_t)min(n, 255) };
+  if(!txQueue.push(job)){
+    logMsg(LOGL_WARN, "Fleet: TX queue full");
+    return 0;
+  }
+  if(kind == FLEET_PKT_WAKE){
+    wakeWatchStart(host);
+    if(agentEnabled() && !txQueue.push({ (uint16_t)host, FLEET_PKT_AGENT_WAKE, AGENT_WAKE_TRIES }))
+      logMsg(LOGL_WARN, "Fleet: TX queue full");
+  }
+  if(txTask) xTaskNotifyGive(txTask);
+  return 1;
+}
+
+int fleetWakeHost(const char* name, int n){
+  return fleetQueue(fleetFind(name), FLEET_PKT_WAKE, n);
+}
+
+int fleetWakeGroup(const char* group, int n){
+  int queued = 0;
+  for(int i = 0; i < fleetSize; i++){
+    if(!strcmp(fleetHosts[i].group, group)) queued += fleetQueue(i, FLEET_PKT_WAKE, n);
+  }
+  return queued;
+}
+
+int fleetWakeAll(int n){
+  int queued = 0;
+  for(int i = 0; i < fleetSize; i++) queued += fleetQueue(i, FLEET_PKT_WAKE, n);
+  return queued;
+}
+
+bool fleetBusy(){
+  return inBatch || !txQueue.empty();
+}
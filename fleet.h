@@ -0,0 +1,32 @@
+/*
+ * fleet.h
+ * -------------------------------
+ * Declares the multi-target WOL fleet table:
+ *  - Named hosts with MAC, IP, UDP port, interface and group
+ *  - Host 0 is always the single target from config.json
+ *  - Extra hosts are loaded from /targets.json
+ *  - Packet bodies are built once at load time
+ *  - Batched, paced sending of wake/shutdown packets on the "tx" task
+ *  - With config.agent_key set, shutdowns become acknowledged agent
+ *    requests and wakes add one (agent.h)
+ */
+
+#pragma once
+#include "config.h"
+#include "netif.h"
+#include "fleet_batch.h"
+
+extern FleetHost fleetHosts[FLEET_MAX_HOSTS];
+extern int fleetSize;
+
+bool loadFleet();
+void fleetBegin();
+void fleetRefreshDefault();   // caller holds configLock once other tasks run
+FleetHost fleetHostCopy(int host);
+int  fleetFind(const char* name);
+int  fleetQueue(int host, FleetPacket kind, int n);
+int  fleetWakeHost(const char* name, int n);
+int  fleetWakeGroup(const char* group, int n);
+int  fleetWakeAll(int n);
+bool fleetBusy();
+void fleetDropJobs(int host, FleetPacket kind);   // tx task only
@@ -0,0 +1,102 @@
+/*
+ * fleet_batch.h
+ * -------------------------------
+ * The fleet table rows and the paced batch, shared by the firmware
+ * (fleet.cpp) and the Linux benchmark (Tools/fleet_bench.cpp):
+ *  - FleetHost: one named host; fleetBuildBody() writes its 16x MAC
+ *    body once, the 6-byte header is shared by all hosts
+ *  - FleetBatch<N>: ring of (host, packet, repeats) jobs; tick()
+ *    sends up to a given number of frames and puts a job with
+ *    repeats left at the back, so the repeats of one host are
+ *    spread across the batch
+ *  - Plain C++17, no Arduino headers
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FLEET_MAX_HOSTS      256
+#define FLEET_NAME_LEN       16
+#define FLEET_BODY_LEN       96
+#define FLEET_QUEUE_LEN      (FLEET_MAX_HOSTS * 2)   // power of two
+#define FLEET_TX_PER_TICK    4    // frames per tick, every config.tx_gap_ms (keeps lwIP pbuf pool free)
+
+enum FleetPacket : uint8_t {
+  FLEET_PKT_WAKE     = 0,
+  FLEET_PKT_SHUTDOWN = 1,
+  FLEET_PKT_AGENT_SHUTDOWN = 2,   // tx task: handed to agent.cpp
+  FLEET_PKT_AGENT_WAKE     = 3
+};
+
+struct FleetHost {
+  char     name[FLEET_NAME_LEN];
+  char     group[FLEET_NAME_LEN];
+  uint8_t  mac[6];
+  uint8_t  ip[4];
+  uint16_t port;
+  uint8_t  iface;   // NetIface mask
+};
+
+struct FleetJob {
+  uint16_t host;
+  uint8_t  kind;
+  uint8_t  left;
+};
+
+static const uint8_t fleetWakeHeader[6]     = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+static const uint8_t fleetShutdownHeader[6] = { 0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE };
+
+inline void fleetBuildBody(uint8_t body[FLEET_BODY_LEN], const uint8_t mac[6]){
+  for(int j = 0; j < 16; j++) memcpy(&body[j * 6], mac, 6);
+}
+
+template<size_t N>
+class FleetBatch {
+public:
+  bool add(const FleetJob &job){
+    if(count >= (int)N) return false;
+    jobs[(head + count) % N] = job;
+    count++;
+    return true;
+  }
+
+  bool empty() const { return count == 0; }
+  bool full() const { return count >= (int)N; }
+  int  size() const { return count; }
+
+  // Sends up to max frames; returns how many
+  template<typename Send>
+  int tick(int max, Send send){
+    int sent = 0;
+    for(; sent < max && count > 0; sent++){
+      FleetJob job = jobs[head];
+      head = (head + 1) % N;
+      count--;
+
+      send(job);
+
+      if(--job.left > 0){
+        jobs[(head + count) % N] = job;
+        count++;
+      }
+    }
+    return sent;
+  }
+
+  void drop(int host, uint8_t kind){
+    int kept = 0;
+    for(int i = 0; i < count; i++){
+      FleetJob job = jobs[(head + i) % N];
+      if(job.host == host && job.kind == kind) continue;
+      jobs[(head + kept++) % N] = job;
+    }
+    count = kept;
+  }
+
+private:
+  FleetJob jobs[N] = {};
+  int      head = 0;
+  int      count = 0;
+};
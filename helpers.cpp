@@ -2,37 +2,24 @@
  * helpers.cpp
  * -------------------------------
  * Implements helper functions:
- *  - mqttPublish() sends a message on "wol/log" topic
- *  - blinkDigit() blinks LED n times
- *  - blinkVersion() blinks firmware version digits
- *  - Provides a global UDP object for WOL packets
+ *  - mqttPublish() queues a message for "wol/log" (logger.cpp)
+ *  - parseMac() validates and parses a colon/dash separated MAC
  */
 
 #include "helpers.h"
 #include "mqtt.h"
 #include "config.h"
 
-WiFiUDP udp;
-
 void mqttPublish(const char* msg){
-  if(mqtt.connected()) mqtt.publish("wol/log",msg);
-}
-
-void blinkDigit(int n){
-  for(int i = 0; i < n; i++){
-    digitalWrite(LED_GPIO,HIGH); 
-    delay(150);
-    digitalWrite(LED_GPIO,LOW); 
-    delay(150);
-  }
+  logMsg(LOGL_INFO, "%s", msg);
 }
 
-void blinkVersion(const char* version){
-  int len = strlen(version);
-  for(int i = 0; i < len; i++){
-    if(version[i] >= '0' && version[i] <= '9'){
-      blinkDigit(version[i] - '0');
-      delay(500);
-    }
-  }
+bool parseMac(const char* str, uint8_t mac[6]){
+  if(!str) return false;
+  unsigned int b[6];
+  char extra;
+  if(sscanf(str, "%2x%*1[:-]%2x%*1[:-]%2x%*1[:-]%2x%*1[:-]%2x%*1[:-]%2x%c",
+            &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &extra) != 6) return false;
+  for(int i = 0; i < 6; i++) mac[i] = (uint8_t)b[i];
+  return true;
 }
@@ -2,17 +2,15 @@
  * helpers.h
  * -------------------------------
  * Declares helper functions used across the project:
- *  - mqttPublish(): send log messages via MQTT
- *  - blinkDigit(): blink LED a number of times
- *  - blinkVersion(): blink LED to display firmware version
+ *  - mqttPublish(): queue an INFO log message for "wol/log"
+ *  - blinkDigit() / blinkVersion(): LED blinks (ui.h)
+ *  - parseMac(): parse "AA:BB:CC:DD:EE:FF" into 6 bytes
  */
 
 #pragma once
 #include "config.h"
-#include <WiFiUdp.h>
-
-extern WiFiUDP udp;
+#include "logger.h"
+#include "ui.h"
 
 void mqttPublish(const char* msg);
-void blinkDigit(int n);
-void blinkVersion(const char* version);
+bool parseMac(const char* str, uint8_t mac[6]);
@@ -0,0 +1,443 @@
+/*
+ * local_api.cpp
+ * -------------------------------
+ * Implements the local control API:
+ *  - REST routes on the control WebServer, behind httpAuthorized()
+ *  - A small RFC 6455 server on a non-blocking lwIP socket, polled
+ *    by wsTask() every WS_TASK_MS; no extra FreeRTOS task
+ *  - Only single-frame (FIN) masked text frames up to WS_RX_BUF;
+ *    ping is answered, binary or fragmented frames close the socket
+ *  - Commands go through commandExecute(), the same path as MQTT
+ *  - Events: "cmd" for every executed command (any transport),
+ *    "host" for every probe result, "state" when pins / MQTT change
+ */
+
+#include <lwip/sockets.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ArduinoJson.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+#include "local_api.h"
+#include "configPortal.h"
+#include "commands.h"
+#include "fleet.h"
+#include "probe.h"
+#include "presence.h"
+#include "mqtt.h"
+#include "helpers.h"
+#include "scheduler.h"
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+enum WsState : uint8_t {
+  WS_FREE      = 0,
+  WS_HANDSHAKE = 1,
+  WS_OPEN      = 2
+};
+
+struct WsClient {
+  int      fd;
+  uint8_t  state;
+  unsigned long since;
+  uint16_t rxLen;
+  uint8_t  rx[WS_RX_BUF];
+};
+
+static WsClient clients[WS_MAX_CLIENTS];
+static int  listenFd = -1;
+static int  openCount = 0;
+static bool authRequired = false;
+static uint8_t lastState = 0xFF;
+
+// ---- Auth ----
+
+// Compares the whole token whatever the input, so timing leaks nothing
+static bool tokenMatches(const char* s, size_t n){
+  size_t want = strlen(config.api_token);
+  uint8_t diff = n != want;
+  for(size_t i = 0; i < want; i++) diff |= config.api_token[i] ^ (i < n ? s[i] : 0);
+  return want && !diff;
+}
+
+bool httpAuthorized(){
+  if(!authRequired) return true;   // setup portal (AP mode)
+
+  String h = server.header("Authorization");
+  if(h.startsWith("Bearer ") && tokenMatches(h.c_str() + 7, h.length() - 7)) return true;
+  if(server.hasArg("token")){
+    String t = server.arg("token");
+    if(tokenMatches(t.c_str(), t.length())) return true;
+  }
+
+  server.sendHeader("WWW-Authenticate", "Bearer");
+  server.send(401, "application/json", "{\"error\":\"unauthorized\"}");
+  return false;
+}
+
+// ---- State ----
+
+static uint8_t stateBits(){
+  return (digitalRead(PIN1_GPIO) ? 1 : 0) | (digitalRead(PIN2_GPIO) ? 2 : 0) | (mqttConnected() ? 4 : 0);
+}
+
+static int hostsUp(){
+  int n = 0;
+  for(int i = 0; i < fleetSize; i++) if(probeStats(i).state == PROBE_UP) n++;
+  return n;
+}
+
+static void stateToJson(JsonDocument &doc){
+  uint8_t s = stateBits();
+  doc["pin1"] = (bool)(s & 1);
+  doc["pin2"] = (bool)(s & 2);
+  doc["mqtt"] = (bool)(s & 4);
+  doc["hosts"] = fleetSize;
+  doc["hosts_up"] = hostsUp();
+  doc["uptime_s"] = millis() / 1000;
+}
+
+// ---- REST ----
+
+static void handleApiCmd(){
+  if(!httpAuthorized()) return;
+
+  String payload = server.hasArg("plain") ? server.arg("plain") : server.arg("c");
+  unsigned long t0 = micros();
+  CommandStatus st = payload.length() ? commandExecute(payload.c_str(), payload.length(), "HTTP") : CMD_UNKNOWN;
+  unsigned long us = micros() - t0;
+
+  char out[64];
+  if(st == CMD_OK) snprintf(out, sizeof(out), "{\"ok\":true,\"us\":%lu}", us);
+  else snprintf(out, sizeof(out), "{\"ok\":false,\"error\":\"%s\"}", commandStatusNames[st]);
+  server.send(st == CMD_OK ? 200 : st == CMD_UNKNOWN ? 400 : st == CMD_FAILED ? 503 : 409, "application/json", out);
+}
+
+static void handleApiState(){
+  if(!httpAuthorized()) return;
+
+  JsonDocument doc;
+  stateToJson(doc);
+  JsonArray hosts = doc["targets"].to<JsonArray>();
+  for(int i = 0; i < fleetSize; i++){
+    const ProbeStats &s = probeStats(i);
+    JsonObject h = hosts.add<JsonObject>();
+    h["name"] = fleetHosts[i].name;
+    h["state"] = s.state == PROBE_UP ? "up" : s.state == PROBE_DOWN ? "down" : "unknown";
+    if(s.replies) h["rtt_ms"] = s.rttSum / s.replies;
+    uint32_t seen = presenceLastSeen(i);
+    if(seen) h["seen_s"] = (millis() - seen) / 1000;
+  }
+  String out;
+  serializeJson(doc, out);
+  server.send(200, "application/json", out);
+}
+
+// ---- WebSocket ----
+
+static void wsClose(WsClient &c){
+  close(c.fd);
+  if(c.state == WS_OPEN) openCount--;
+  c.fd = -1;
+  c.state = WS_FREE;
+  c.rxLen = 0;
+}
+
+// Server frames are unmasked; a client that cannot take a whole frame is dropped
+static bool wsSend(WsClient &c, uint8_t opcode, const void* data, size_t len){
+  if(len > WS_TX_BUF) return false;
+  uint8_t frame[WS_TX_BUF + 4];
+  size_t hdr = 2;
+  frame[0] = 0x80 | opcode;
+  if(len < 126){
+    frame[1] = len;
+  } else {
+    frame[1] = 126;
+    frame[2] = len >> 8;
+    frame[3] = len & 0xFF;
+    hdr = 4;
+  }
+  memcpy(frame + hdr, data, len);
+
+  if(send(c.fd, frame, hdr + len, 0) != (int)(hdr + len)){
+    logMsg(LOGL_DEBUG, "WS: client %d too slow, dropped", c.fd);
+    wsClose(c);
+    return false;
+  }
+  return true;
+}
+
+static void wsCloseWith(WsClient &c, uint16_t code){
+  uint8_t body[2] = { (uint8_t)(code >> 8), (uint8_t)(code & 0xFF) };
+  if(wsSend(c, 0x8, body, 2)) wsClose(c);
+}
+
+static void wsBroadcast(const char* json, size_t len){
+  for(int i = 0; i < WS_MAX_CLIENTS; i++)
+    if(clients[i].state == WS_OPEN) wsSend(clients[i], 0x1, json, len);
+}
+
+static void wsSendJson(WsClient &c, JsonDocument &doc){
+  char out[WS_TX_BUF];
+  size_t n = serializeJson(doc, out, sizeof(out));
+  wsSend(c, 0x1, out, n);
+}
+
+static void wsBroadcastJson(JsonDocument &doc){
+  if(!openCount) return;
+  char out[WS_TX_BUF];
+  size_t n = serializeJson(doc, out, sizeof(out));
+  wsBroadcast(out, n);
+}
+
+static void onCommand(const Command &cmd, const char* name){
+  if(!openCount) return;
+  JsonDocument doc;
+  doc["type"] = "cmd";
+  doc["cmd"] = name;
+  if(cmd.target[0]) doc["target"] = cmd.target;
+  doc["source"] = cmd.source;
+  wsBroadcastJson(doc);
+}
+
+static void onProbe(int host, bool up){
+  if(!openCount) return;
+  const ProbeStats &s = probeStats(host);
+  JsonDocument doc;
+  doc["type"] = "host";
+  doc["name"] = fleetHosts[host].name;
+  doc["up"] = up;
+  if(s.replies) doc["rtt_ms"] = s.rttSum / s.replies;
+  wsBroadcastJson(doc);
+}
+
+// Returns the value of a request header, trimmed, or nullptr
+static const char* headerValue(char* req, const char* name, size_t &len){
+  size_t n = strlen(name);
+  for(char* line = strstr(req, "\r\n"); line; line = strstr(line, "\r\n")){
+    line += 2;
+    if(strncasecmp(line, name, n) || line[n] != ':') continue;
+    char* v = line + n + 1;
+    while(*v == ' ') v++;
+    char* end = strstr(v, "\r\n");
+    len = end ? end - v : strlen(v);
+    return v;
+  }
+  return nullptr;
+}
+
+static bool wsAuthorized(char* req){
+  const char* q = strstr(req, "token=");
+  char* lineEnd = strstr(req, "\r\n");
+  if(q && q < lineEnd){
+    q += 6;
+    size_t n = strcspn(q, "& \r");
+    if(tokenMatches(q, n)) return true;
+  }
+  size_t len;
+  const char* h = headerValue(req, "Authorization", len);
+  return h && len > 7 && !strncmp(h, "Bearer ", 7) && tokenMatches(h + 7, len - 7);
+}
+
+static void wsReject(WsClient &c, const char* status){
+  send(c.fd, status, strlen(status), 0);
+  wsClose(c);
+}
+
+static void wsHandshake(WsClient &c){
+  c.rx[c.rxLen] = 0;
+  char* req = (char*)c.rx;
+  char* end = strstr(req, "\r\n\r\n");
+  if(!end){
+    if(c.rxLen >= WS_RX_BUF - 1) wsClose(c);
+    return;
+  }
+
+  size_t keyLen;
+  const char* key = headerValue(req, "Sec-WebSocket-Key", keyLen);
+  if(strncmp(req, "GET ", 4) || !key || keyLen > 32){
+    wsReject(c, "HTTP/1.1 400 Bad Request\r\n\r\n");
+    return;
+  }
+  if(!wsAuthorized(req)){
+    logMsg(LOGL_WARN, "WS: unauthorized client rejected");
+    wsReject(c, "HTTP/1.1 401 Unauthorized\r\n\r\n");
+    return;
+  }
+
+  char buf[80];
+  memcpy(buf, key, keyLen);
+  memcpy(buf + keyLen, WS_GUID, sizeof(WS_GUID) - 1);
+  uint8_t digest[20];
+  mbedtls_sha1((const uint8_t*)buf, keyLen + sizeof(WS_GUID) - 1, digest);
+  uint8_t accept[32];
+  size_t acceptLen;
+  mbedtls_base64_encode(accept, sizeof(accept), &acceptLen, digest, sizeof(digest));
+
+  char resp[160];
+  int n = snprintf(resp, sizeof(resp),
+                   "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                   "Connection: Upgrade\r\nSec-WebSocket-Accept: %.*s\r\n\r\n",
+                   (int)acceptLen, accept);
+  if(send(c.fd, resp, n, 0) != n){
+    wsClose(c);
+    return;
+  }
+
+  size_t used = end + 4 - req;
+  c.rxLen -= used;
+  memmove(c.rx, c.rx + used, c.rxLen);
+  c.state = WS_OPEN;
+  openCount++;
+
+  JsonDocument doc;
+  doc["type"] = "state";
+  stateToJson(doc);
+  wsSendJson(c, doc);
+}
+
+static void wsText(WsClient &c, const uint8_t* p, size_t len){
+  CommandStatus st = commandExecute((const char*)p, len, "WS");
+  if(c.state != WS_OPEN) return;   // dropped by a broadcast
+  char ack[64];
+  if(st == CMD_OK) strlcpy(ack, "{\"type\":\"ack\",\"ok\":true}", sizeof(ack));
+  else snprintf(ack, sizeof(ack), "{\"type\":\"ack\",\"ok\":false,\"error\":\"%s\"}", commandStatusNames[st]);
+  wsSend(c, 0x1, ack, strlen(ack));
+}
+
+static void wsFrames(WsClient &c){
+  while(c.state == WS_OPEN && c.rxLen >= 2){
+    uint8_t* rx = c.rx;
+    bool fin = rx[0] & 0x80;
+    uint8_t opcode = rx[0] & 0x0F;
+    if(!(rx[1] & 0x80)){ wsCloseWith(c, 1002); return; }   // clients must mask
+
+    size_t len = rx[1] & 0x7F;
+    size_t hdr = 2;
+    if(len == 126){
+      if(c.rxLen < 4) return;
+      len = (rx[2] << 8) | rx[3];
+      hdr = 4;
+    } else if(len == 127){
+      wsCloseWith(c, 1009);
+      return;
+    }
+    if(hdr + 4 + len > WS_RX_BUF - 1){ wsCloseWith(c, 1009); return; }
+    if(c.rxLen < hdr + 4 + len) return;   // wait for the rest
+
+    uint8_t* mask = rx + hdr;
+    uint8_t* p = mask + 4;
+    for(size_t i = 0; i < len; i++) p[i] ^= mask[i & 3];
+
+    if(!fin || opcode == 0x0){ wsCloseWith(c, 1003); return; }
+    switch(opcode){
+      case 0x1: wsText(c, p, len); break;
+      case 0x8: if(wsSend(c, 0x8, p, min(len, (size_t)2))) wsClose(c); return;
+      case 0x9: wsSend(c, 0xA, p, len); break;
+      case 0xA: break;
+      default:  wsCloseWith(c, 1003); return;
+    }
+    if(c.state != WS_OPEN) return;
+
+    size_t used = hdr + 4 + len;
+    c.rxLen -= used;
+    memmove(c.rx, c.rx + used, c.rxLen);
+  }
+}
+
+static void wsAccept(){
+  for(;;){
+    int fd = accept(listenFd, nullptr, nullptr);
+    if(fd < 0) return;
+
+    WsClient* c = nullptr;
+    for(int i = 0; i < WS_MAX_CLIENTS && !c; i++) if(clients[i].state == WS_FREE) c = &clients[i];
+    if(!c){
+      close(fd);
+      logMsg(LOGL_WARN, "WS: client limit (%d) reached", WS_MAX_CLIENTS);
+      continue;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    c->fd = fd;
+    c->state = WS_HANDSHAKE;
+    c->since = millis();
+    c->rxLen = 0;
+  }
+}
+
+static void wsTask(){
+  if(listenFd < 0) return;
+  wsAccept();
+
+  for(int i = 0; i < WS_MAX_CLIENTS; i++){
+    WsClient &c = clients[i];
+    if(c.state == WS_FREE) continue;
+
+    int n = recv(c.fd, c.rx + c.rxLen, WS_RX_BUF - 1 - c.rxLen, 0);
+    if(n == 0 || (n < 0 && errno != EWOULDBLOCK && errno != EAGAIN)){
+      wsClose(c);
+      continue;
+    }
+    if(n > 0) c.rxLen += n;
+
+    if(c.state == WS_HANDSHAKE){
+      if(millis() - c.since > WS_HANDSHAKE_MS){ wsClose(c); continue; }
+      if(n > 0) wsHandshake(c);
+    }
+    if(c.state == WS_OPEN) wsFrames(c);
+  }
+
+  uint8_t s = stateBits();
+  if(s != lastState){
+    lastState = s;
+    JsonDocument doc;
+    doc["type"] = "state";
+    stateToJson(doc);
+    wsBroadcastJson(doc);
+  }
+}
+
+static bool wsListen(){
+  listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if(listenFd < 0) return false;
+
+  int one = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons(LOCAL_API_WS_PORT);
+  a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if(bind(listenFd, (sockaddr*)&a, sizeof(a)) < 0 || listen(listenFd, WS_MAX_CLIENTS) < 0){
+    close(listenFd);
+    listenFd = -1;
+    return false;
+  }
+  fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
+  return true;
+}
+
+void localApiBegin(){
+  authRequired = true;
+  server.on("/api/cmd", HTTP_POST, handleApiCmd);
+  server.on("/api/cmd", HTTP_GET, handleApiCmd);
+  server.on("/api/state", HTTP_GET, handleApiState);
+
+  for(int i = 0; i < WS_MAX_CLIENTS; i++){
+    clients[i].fd = -1;
+    clients[i].state = WS_FREE;
+  }
+  if(!wsListen()){
+    logMsg(LOGL_ERROR, "WS: cannot listen on port %d", LOCAL_API_WS_PORT);
+    return;
+  }
+
+  commandSetListener(onCommand);
+  probeAddListener(onProbe);
+  schedulerEvery(WS_TASK_MS, wsTask);
+  logMsg(LOGL_INFO, "Local API: REST on :80, WebSocket on :%d", LOCAL_API_WS_PORT);
+}
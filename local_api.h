@@ -0,0 +1,24 @@
+/*
+ * local_api.h
+ * -------------------------------
+ * Declares the local control API (STA mode), served next to MQTT:
+ *  - POST/GET /api/cmd runs a command through the shared dispatcher
+ *  - GET /api/state returns pins, MQTT link and host reachability
+ *  - WebSocket on port LOCAL_API_WS_PORT: text frames are commands,
+ *    the device pushes command, host and state events as JSON
+ *  - Every request carries config.api_token, as
+ *    "Authorization: Bearer <token>" or "?token=<token>"
+ */
+
+#pragma once
+#include "config.h"
+
+#define LOCAL_API_WS_PORT    81
+#define WS_MAX_CLIENTS       4
+#define WS_RX_BUF            512      // largest frame / handshake accepted
+#define WS_TX_BUF            256
+#define WS_HANDSHAKE_MS      5000
+#define WS_TASK_MS           10
+
+void localApiBegin();
+bool httpAuthorized();
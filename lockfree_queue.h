@@ -0,0 +1,120 @@
+/*
+ * lockfree_queue.h
+ * -------------------------------
+ * Bounded lock-free queues used between the FreeRTOS tasks:
+ *  - SpscQueue<T, N>: one producer task, one consumer task
+ *  - MpscQueue<T, N>: any number of producers (tasks or ISRs),
+ *    one consumer; per-cell sequence numbers (D. Vyukov's bounded
+ *    queue), so a producer never waits on another one
+ *  - N is a power of two; push() fails instead of blocking when full
+ *  - Plain C++17 and std::atomic only: the same header builds on a
+ *    Linux host (g++ -std=c++17 -pthread) for std::thread stress runs
+ *  - MpscQueue::push() is placed in IRAM on the ESP32, so GPIO ISRs
+ *    can push while the flash cache is off
+ *
+ * ESP32-C3 has no atomic instructions; there the toolchain implements
+ * the compare-and-swap with a short interrupt-masked section, which
+ * is still safe from ISRs and never blocks on another task.
+ */
+
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+#define LFQ_ISR_SAFE IRAM_ATTR
+#else
+#define LFQ_ISR_SAFE
+#endif
+
+#ifndef LFQ_CACHE_LINE
+#define LFQ_CACHE_LINE 32
+#endif
+
+template<typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  bool push(const T &v){
+    size_t t = tail.load(std::memory_order_relaxed);
+    if(t - head.load(std::memory_order_acquire) == N) return false;
+    buf[t & (N - 1)] = v;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &v){
+    size_t h = head.load(std::memory_order_relaxed);
+    if(h == tail.load(std::memory_order_acquire)) return false;
+    v = buf[h & (N - 1)];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+private:
+  alignas(LFQ_CACHE_LINE) std::atomic<size_t> head{0};   // consumer side
+  alignas(LFQ_CACHE_LINE) std::atomic<size_t> tail{0};   // producer side
+  T buf[N];
+};
+
+template<typename T, size_t N>
+class MpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+public:
+  MpscQueue(){
+    for(size_t i = 0; i < N; i++) cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  // A cell is free for position pos when seq == pos, full when seq == pos + 1
+  LFQ_ISR_SAFE bool push(const T &v){
+    size_t pos = tail.load(std::memory_order_relaxed);
+    for(;;){
+      Cell &c = cells[pos & (N - 1)];
+      intptr_t dif = (intptr_t)c.seq.load(std::memory_order_acquire) - (intptr_t)pos;
+      if(dif == 0){
+        if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+          c.value = v;
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if(dif < 0){
+        return false;   // full
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool pop(T &v){
+    Cell &c = cells[head & (N - 1)];
+    if((intptr_t)c.seq.load(std::memory_order_acquire) - (intptr_t)(head + 1) < 0) return false;
+    v = c.value;
+    c.seq.store(head + N, std::memory_order_release);
+    head++;
+    return true;
+  }
+
+  bool empty() const {
+    return (intptr_t)cells[head & (N - 1)].seq.load(std::memory_order_acquire) - (intptr_t)(head + 1) < 0;
+  }
+
+private:
+  alignas(LFQ_CACHE_LINE) std::atomic<size_t> tail{0};   // shared by producers
+  alignas(LFQ_CACHE_LINE) size_t head = 0;               // consumer only
+  Cell cells[N];
+};
@@ -0,0 +1,130 @@
+/*
+ * logger.cpp
+ * -------------------------------
+ * Implements the buffered log pipeline:
+ *  - LOG_SLOTS fixed slots of LOG_MSG_LEN bytes, no heap use
+ *  - INFO messages are published as-is (same text as before);
+ *    other levels get a "DEBUG: " / "WARN: " / "ERROR: " prefix
+ *  - logPump() runs on the mqtt task and publishes up to
+ *    LOG_FLUSH_BATCH messages per call while MQTT is connected
+ *  - logMsg() may be called from any task; the ring is guarded by
+ *    a spinlock, formatting happens outside it, and only the mqtt
+ *    task publishes
+ */
+
+#include "logger.h"
+#include "mqtt.h"
+#include "metrics.h"
+
+struct LogSlot {
+  uint8_t level;
+  char    msg[LOG_MSG_LEN];
+};
+
+static LogSlot  ring[LOG_SLOTS];
+static uint16_t ringHead = 0;
+static uint16_t ringCount = 0;
+static uint32_t headSeq = 0;     // bumped whenever ringHead moves
+static uint32_t dropped = 0;
+static portMUX_TYPE ringLock = portMUX_INITIALIZER_UNLOCKED;
+static LogLevel minLevel = LOGL_INFO;
+
+static const char* const levelPrefix[] = { "DEBUG: ", "", "WARN: ", "ERROR: " };
+static const char* const levelNames[]  = { "debug", "info", "warn", "error" };
+
+void logMsg(LogLevel level, const char* fmt, ...){
+  if(level < minLevel) return;
+
+  char msg[LOG_MSG_LEN];
+  int n = strlen(levelPrefix[level]);
+  memcpy(msg, levelPrefix[level], n);
+
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg + n, sizeof(msg) - n, fmt, args);
+  va_end(args);
+
+  portENTER_CRITICAL(&ringLock);
+  if(ringCount == LOG_SLOTS){
+    ringHead = (ringHead + 1) % LOG_SLOTS;
+    ringCount--;
+    headSeq++;
+    dropped++;
+  }
+  LogSlot &s = ring[(ringHead + ringCount) % LOG_SLOTS];
+  s.level = level;
+  memcpy(s.msg, msg, sizeof(msg));
+  ringCount++;
+  portEXIT_CRITICAL(&ringLock);
+
+  Serial.println(msg);
+}
+
+static void flushBatch(int max){
+  if(!mqtt.connected()) return;
+
+  portENTER_CRITICAL(&ringLock);
+  uint32_t lost = dropped;
+  portEXIT_CRITICAL(&ringLock);
+  if(lost){
+    char note[48];
+    snprintf(note, sizeof(note), "WARN: Log: %lu messages dropped", (unsigned long)lost);
+    if(!mqtt.publish("wol/log", note)) return;
+    metricInc(CNT_MQTT_PUBLISHED);
+    portENTER_CRITICAL(&ringLock);
+    dropped -= lost;
+    portEXIT_CRITICAL(&ringLock);
+  }
+
+  // Copy the head out, publish without the lock, pop only if no
+  // writer overran it meanwhile
+  char msg[LOG_MSG_LEN];
+  for(int i = 0; i < max; i++){
+    portENTER_CRITICAL(&ringLock);
+    bool empty = ringCount == 0;
+    uint32_t seq = headSeq;
+    if(!empty) memcpy(msg, ring[ringHead].msg, sizeof(msg));
+    portEXIT_CRITICAL(&ringLock);
+    if(empty || !mqtt.publish("wol/log", msg)) return;
+    metricInc(CNT_MQTT_PUBLISHED);
+
+    portENTER_CRITICAL(&ringLock);
+    if(seq == headSeq){
+      ringHead = (ringHead + 1) % LOG_SLOTS;
+      ringCount--;
+      headSeq++;
+    }
+    portEXIT_CRITICAL(&ringLock);
+  }
+}
+
+void logPump(){
+  flushBatch(LOG_FLUSH_BATCH);
+}
+
+static bool ringEmpty(){
+  portENTER_CRITICAL(&ringLock);
+  bool empty = ringCount == 0;
+  portEXIT_CRITICAL(&ringLock);
+  return empty;
+}
+
+// Used right before a restart: gives the mqtt task time to drain the ring
+void logFlush(){
+  unsigned long t0 = millis();
+  while(!ringEmpty() && mqttConnected() && millis() - t0 < LOG_FLUSH_WAIT_MS) delay(10);
+}
+
+void logSetLevel(LogLevel level){
+  minLevel = level;
+}
+
+bool logParseLevel(const char* name, LogLevel &level){
+  for(int i = 0; i < 4; i++){
+    if(!strcasecmp(name, levelNames[i])){
+      level = (LogLevel)i;
+      return true;
+    }
+  }
+  return false;
+}
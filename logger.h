@@ -0,0 +1,31 @@
+/*
+ * logger.h
+ * -------------------------------
+ * Declares the buffered log pipeline:
+ *  - logMsg() formats printf-style into a preallocated ring slot
+ *  - Messages are echoed to Serial and kept until MQTT is up
+ *  - logPump() (mqtt task) flushes the ring to "wol/log" in batches
+ *  - Overflow drops the oldest entry and is reported once flushed
+ *  - Runtime level filter (LogLevel command)
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define LOG_SLOTS       32
+#define LOG_MSG_LEN     128
+#define LOG_FLUSH_BATCH 8
+#define LOG_FLUSH_WAIT_MS 2000
+
+enum LogLevel : uint8_t {
+  LOGL_DEBUG = 0,
+  LOGL_INFO  = 1,
+  LOGL_WARN  = 2,
+  LOGL_ERROR = 3
+};
+
+void logMsg(LogLevel level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+void logPump();
+void logFlush();
+void logSetLevel(LogLevel level);
+bool logParseLevel(const char* name, LogLevel &level);
@@ -0,0 +1,202 @@
+/*
+ * metrics.cpp
+ * -------------------------------
+ * Implements the metrics registry:
+ *  - Static tables give each id its Prometheus name, labels, help
+ *    text and short JSON key; series sharing a name are adjacent
+ *  - metricsTask() samples heap, uptime, RSSI and MQTT state every
+ *    METRICS_SAMPLE_MS and publishes the snapshot every
+ *    METRICS_PUBLISH_MS while MQTT is connected
+ *  - /metrics is streamed in ~1 KB chunks, never built in one String
+ */
+
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include "metrics.h"
+#include "mqtt.h"
+#include "scheduler.h"
+#include "configPortal.h"
+
+struct MetricInfo {
+  const char* key;      // JSON snapshot
+  const char* name;     // Prometheus
+  const char* labels;
+  const char* help;
+};
+
+static const MetricInfo counterInfo[] = {
+  { "wol_wifi",      "wol_packets_sent_total", "kind=\"wol\",iface=\"wifi\"",      "Magic packets sent" },
+  { "wol_eth",       "wol_packets_sent_total", "kind=\"wol\",iface=\"eth\"",       "Magic packets sent" },
+  { "shutdown_wifi", "wol_packets_sent_total", "kind=\"shutdown\",iface=\"wifi\"", "Magic packets sent" },
+  { "shutdown_eth",  "wol_packets_sent_total", "kind=\"shutdown\",iface=\"eth\"",  "Magic packets sent" },
+  { "txfail_wifi",   "wol_tx_failures_total",  "iface=\"wifi\"", "Frames the interface failed to send" },
+  { "txfail_eth",    "wol_tx_failures_total",  "iface=\"eth\"",  "Frames the interface failed to send" },
+  { "probe_ok",      "wol_probe_replies_total",  "", "Probe attempts answered" },
+  { "probe_lost",    "wol_probe_timeouts_total", "", "Probe attempts timed out" },
+  { "mqtt_connects", "wol_mqtt_connects_total",  "", "Successful MQTT connects" },
+  { "mqtt_fails",    "wol_mqtt_connect_failures_total", "", "Failed MQTT connect attempts" },
+  { "mqtt_up_s",     "wol_mqtt_connected_seconds_total", "", "Time connected to the broker" },
+  { "ota_checks",    "wol_ota_checks_total",     "", "OTA version checks" },
+  { "commands",      "wol_commands_total",       "", "Commands executed" },
+  { "presence",      "wol_presence_sightings_total", "", "ARP/DHCP packets noted by presence tracking" },
+  { "presence_drop", "wol_presence_drops_total",     "", "Sightings lost to a full queue" },
+  { "probe_passive", "wol_probe_passive_total",      "", "Probe requests answered from presence" },
+  { "mqtt_pub",      "wol_mqtt_published_total",     "", "Messages published to the broker" },
+  { "mqtt_dedup",    "wol_mqtt_deduped_total",       "", "Retained publishes dropped as unchanged" },
+  { "cmd_dup",       "wol_commands_rejected_total",  "reason=\"duplicate\"", "Commands not run" },
+  { "cmd_stale",     "wol_commands_rejected_total",  "reason=\"stale\"",     "Commands not run" },
+  { "cmd_old",       "wol_commands_rejected_total",  "reason=\"superseded\"", "Commands not run" },
+  { "wifi_drops",    "wol_wifi_drops_total",         "", "WiFi links lost after being up" },
+  { "wifi_rescans",  "wol_wifi_scan_fallbacks_total", "", "Cached BSSID/channel attempts that fell back to a scan" },
+  { "relay_fwd",     "wol_relay_packets_total",      "result=\"forwarded\"",    "Datagrams seen by the WOL relay" },
+  { "relay_invalid", "wol_relay_packets_total",      "result=\"invalid\"",      "Datagrams seen by the WOL relay" },
+  { "relay_denied",  "wol_relay_packets_total",      "result=\"not_allowed\"",  "Datagrams seen by the WOL relay" },
+  { "relay_limited", "wol_relay_packets_total",      "result=\"rate_limited\"", "Datagrams seen by the WOL relay" },
+  { "relay_nosend",  "wol_relay_packets_total",      "result=\"send_failed\"",  "Datagrams seen by the WOL relay" },
+};
+
+static const MetricInfo gaugeInfo[] = {
+  { "uptime_s",    "wol_uptime_seconds",           "", "Seconds since boot" },
+  { "heap",        "wol_heap_free_bytes",          "", "Free heap" },
+  { "heap_min",    "wol_heap_min_free_bytes",      "", "Lowest free heap since boot" },
+  { "heap_block",  "wol_heap_largest_block_bytes", "", "Largest allocatable block" },
+  { "mqtt",        "wol_mqtt_connected",           "", "1 while connected to the broker" },
+  { "rssi",        "wol_wifi_rssi_dbm",            "", "WiFi signal strength" },
+};
+
+static const MetricInfo histInfo[] = {
+  { "rtt_ms",  "wol_ping_rtt_ms",           "", "Probe round-trip time" },
+  { "loop_us", "wol_loop_duration_us",      "", "loop() iteration time" },
+  { "ota_ms",  "wol_ota_check_duration_ms", "", "OTA check duration (failed or up to date)" },
+  { "btn_us",  "wol_button_dispatch_us",    "", "Button gesture recognised to action run" },
+  { "agent_us", "wol_agent_ack_us",         "", "Host agent request to ack round trip" },
+  { "cmd_us",   "wol_command_latency_us",   "", "Command received to handler started" },
+  { "assoc_ms", "wol_wifi_assoc_ms",        "", "WiFi association attempt to link up" },
+  { "outage_ms", "wol_wifi_outage_ms",      "", "WiFi link lost to link up again" },
+};
+
+static_assert(sizeof(counterInfo) / sizeof(counterInfo[0]) == CNT_COUNT, "counterInfo out of sync");
+static_assert(sizeof(gaugeInfo) / sizeof(gaugeInfo[0]) == GAUGE_COUNT, "gaugeInfo out of sync");
+static_assert(sizeof(histInfo) / sizeof(histInfo[0]) == HIST_COUNT, "histInfo out of sync");
+
+static const uint32_t rttBounds[]  = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+static const uint32_t loopBounds[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000, 100000 };
+static const uint32_t otaBounds[]  = { 500, 1000, 2000, 5000, 10000, 30000, 60000, 120000, 300000 };
+static const uint32_t btnBounds[]  = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+static const uint32_t agentBounds[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000, 250000, 500000, 1000000 };
+static const uint32_t cmdBounds[]  = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000, 100000 };
+static const uint32_t assocBounds[] = { 250, 500, 1000, 2000, 3000, 5000, 8000, 12000, 20000, 30000 };
+static const uint32_t outageBounds[] = { 1000, 2000, 5000, 10000, 30000, 60000, 120000, 300000, 900000, 3600000 };
+
+const uint32_t* const histBounds[HIST_COUNT] = { rttBounds, loopBounds, otaBounds, btnBounds, agentBounds, cmdBounds,
+                                                  assocBounds, outageBounds };
+const uint8_t histBucketCount[HIST_COUNT] = {
+  sizeof(rttBounds) / 4, sizeof(loopBounds) / 4, sizeof(otaBounds) / 4, sizeof(btnBounds) / 4,
+  sizeof(agentBounds) / 4, sizeof(cmdBounds) / 4, sizeof(assocBounds) / 4, sizeof(outageBounds) / 4
+};
+
+std::atomic<uint32_t> metricCounters[CNT_COUNT];
+std::atomic<int32_t>  metricGauges[GAUGE_COUNT];
+Histogram             metricHists[HIST_COUNT];
+
+static uint16_t samplesSincePublish = 0;
+
+static void metricsPublish(){
+  JsonDocument doc;
+  JsonObject c = doc["counters"].to<JsonObject>();
+  for(int i = 0; i < CNT_COUNT; i++) c[counterInfo[i].key] = metricCounters[i].load(std::memory_order_relaxed);
+  JsonObject g = doc["gauges"].to<JsonObject>();
+  for(int i = 0; i < GAUGE_COUNT; i++) g[gaugeInfo[i].key] = metricGauges[i].load(std::memory_order_relaxed);
+  JsonObject h = doc["hist"].to<JsonObject>();
+  for(int i = 0; i < HIST_COUNT; i++){
+    JsonObject e = h[histInfo[i].key].to<JsonObject>();
+    e["count"] = metricHists[i].count.load(std::memory_order_relaxed);
+    e["sum"]   = metricHists[i].sum.load(std::memory_order_relaxed);
+  }
+
+  char buf[MQTT_BUFFER_SIZE - 64];
+  size_t n = serializeJson(doc, buf, sizeof(buf));
+  mqttPost("wol/metrics", buf, n, false);
+}
+
+static void metricsTask(){
+  bool up = mqttConnected();
+  metricSet(GAUGE_UPTIME_S, millis() / 1000);
+  metricSet(GAUGE_HEAP_FREE, ESP.getFreeHeap());
+  metricSet(GAUGE_HEAP_MIN, ESP.getMinFreeHeap());
+  metricSet(GAUGE_HEAP_MAX_BLOCK, ESP.getMaxAllocHeap());
+  metricSet(GAUGE_MQTT_CONNECTED, up);
+  metricSet(GAUGE_WIFI_RSSI, WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0);
+  if(up) metricInc(CNT_MQTT_CONNECTED_S);
+
+  if(++samplesSincePublish >= METRICS_PUBLISH_MS / METRICS_SAMPLE_MS && up){
+    samplesSincePublish = 0;
+    metricsPublish();
+  }
+}
+
+void metricsBegin(){
+  metricsTask();
+  schedulerEvery(METRICS_SAMPLE_MS, metricsTask);
+}
+
+// ---- Prometheus text format ----
+
+static char chunk[1024];
+static size_t chunkLen = 0;
+
+static void out(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static void out(const char* fmt, ...){
+  if(sizeof(chunk) - chunkLen < 192){
+    server.sendContent(chunk, chunkLen);
+    chunkLen = 0;
+  }
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(chunk + chunkLen, sizeof(chunk) - chunkLen, fmt, args);
+  va_end(args);
+  if(n > 0) chunkLen += min((size_t)n, sizeof(chunk) - chunkLen - 1);
+}
+
+static void outHeader(const MetricInfo &m, const MetricInfo* prev, const char* type){
+  if(prev && !strcmp(prev->name, m.name)) return;
+  out("# HELP %s %s\n# TYPE %s %s\n", m.name, m.help, m.name, type);
+}
+
+static void outSeries(const MetricInfo &m, long long v){
+  if(m.labels[0]) out("%s{%s} %lld\n", m.name, m.labels, v);
+  else            out("%s %lld\n", m.name, v);
+}
+
+void handleMetrics(){
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+  chunkLen = 0;
+
+  for(int i = 0; i < CNT_COUNT; i++){
+    outHeader(counterInfo[i], i ? &counterInfo[i - 1] : nullptr, "counter");
+    outSeries(counterInfo[i], metricCounters[i].load(std::memory_order_relaxed));
+  }
+  for(int i = 0; i < GAUGE_COUNT; i++){
+    outHeader(gaugeInfo[i], nullptr, "gauge");
+    outSeries(gaugeInfo[i], metricGauges[i].load(std::memory_order_relaxed));
+  }
+  for(int i = 0; i < HIST_COUNT; i++){
+    const MetricInfo &m = histInfo[i];
+    Histogram &h = metricHists[i];
+    outHeader(m, nullptr, "histogram");
+
+    uint32_t cum = 0;
+    for(int b = 0; b < histBucketCount[i]; b++){
+      cum += h.buckets[b].load(std::memory_order_relaxed);
+      out("%s_bucket{le=\"%lu\"} %lu\n", m.name, (unsigned long)histBounds[i][b], (unsigned long)cum);
+    }
+    cum += h.buckets[histBucketCount[i]].load(std::memory_order_relaxed);
+    out("%s_bucket{le=\"+Inf\"} %lu\n", m.name, (unsigned long)cum);
+    out("%s_sum %lu\n%s_count %lu\n", m.name, (unsigned long)h.sum.load(std::memory_order_relaxed),
+        m.name, (unsigned long)h.count.load(std::memory_order_relaxed));
+  }
+
+  if(chunkLen) server.sendContent(chunk, chunkLen);
+  server.sendContent("");
+}
@@ -0,0 +1,106 @@
+/*
+ * metrics.h
+ * -------------------------------
+ * Declares the runtime metrics registry:
+ *  - Counters, gauges and fixed-bucket histograms, each addressed by
+ *    an enum id so updates are a single relaxed atomic operation
+ *  - Safe from any task (OTA, probe, loop); no locks, no heap
+ *  - Exposed as Prometheus text on GET /metrics and as a periodic
+ *    JSON snapshot on "wol/metrics"
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+#define METRICS_SAMPLE_MS   1000
+#define METRICS_PUBLISH_MS  60000UL
+#define METRICS_MAX_BUCKETS 10
+
+enum CounterId : uint8_t {
+  CNT_WOL_WIFI,
+  CNT_WOL_ETH,
+  CNT_SHUTDOWN_WIFI,
+  CNT_SHUTDOWN_ETH,
+  CNT_TX_FAIL_WIFI,
+  CNT_TX_FAIL_ETH,
+  CNT_PROBE_REPLIES,
+  CNT_PROBE_TIMEOUTS,
+  CNT_MQTT_CONNECTS,
+  CNT_MQTT_CONNECT_FAILS,
+  CNT_MQTT_CONNECTED_S,
+  CNT_OTA_CHECKS,
+  CNT_COMMANDS,
+  CNT_PRESENCE_SIGHTINGS,
+  CNT_PRESENCE_DROPS,
+  CNT_PROBE_PASSIVE,
+  CNT_MQTT_PUBLISHED,
+  CNT_MQTT_DEDUPED,
+  CNT_CMD_DUPLICATE,    // same order as CommandStatus (commands.h)
+  CNT_CMD_STALE,
+  CNT_CMD_SUPERSEDED,
+  CNT_WIFI_DROPS,
+  CNT_WIFI_SCAN_FALLBACKS,
+  CNT_RELAY_FORWARDED,  // same order as RelayVerdict (relay_parse.h)
+  CNT_RELAY_INVALID,
+  CNT_RELAY_NOT_ALLOWED,
+  CNT_RELAY_RATE_LIMITED,
+  CNT_RELAY_SEND_FAILED,
+  CNT_COUNT
+};
+
+enum GaugeId : uint8_t {
+  GAUGE_UPTIME_S,
+  GAUGE_HEAP_FREE,
+  GAUGE_HEAP_MIN,
+  GAUGE_HEAP_MAX_BLOCK,
+  GAUGE_MQTT_CONNECTED,
+  GAUGE_WIFI_RSSI,
+  GAUGE_COUNT
+};
+
+enum HistId : uint8_t {
+  HIST_PING_RTT_MS,
+  HIST_LOOP_US,
+  HIST_OTA_CHECK_MS,
+  HIST_BUTTON_DISPATCH_US,
+  HIST_AGENT_ACK_US,
+  HIST_CMD_LATENCY_US,
+  HIST_WIFI_ASSOC_MS,
+  HIST_WIFI_OUTAGE_MS,
+  HIST_COUNT
+};
+
+struct Histogram {
+  std::atomic<uint32_t> buckets[METRICS_MAX_BUCKETS + 1];   // last = +Inf
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> sum;
+};
+
+extern std::atomic<uint32_t> metricCounters[CNT_COUNT];
+extern std::atomic<int32_t>  metricGauges[GAUGE_COUNT];
+extern Histogram             metricHists[HIST_COUNT];
+extern const uint32_t* const histBounds[HIST_COUNT];
+extern const uint8_t         histBucketCount[HIST_COUNT];
+
+inline void metricInc(CounterId id, uint32_t n = 1){
+  metricCounters[id].fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void metricSet(GaugeId id, int32_t v){
+  metricGauges[id].store(v, std::memory_order_relaxed);
+}
+
+inline void metricObserve(HistId id, uint32_t v){
+  const uint32_t* b = histBounds[id];
+  uint8_t n = histBucketCount[id];
+  uint8_t i = 0;
+  while(i < n && v > b[i]) i++;
+  Histogram &h = metricHists[id];
+  h.buckets[i].fetch_add(1, std::memory_order_relaxed);
+  h.count.fetch_add(1, std::memory_order_relaxed);
+  h.sum.fetch_add(v, std::memory_order_relaxed);
+}
+
+void metricsBegin();
+void handleMetrics();
@@ -2,96 +2,212 @@
  * mqtt.cpp
  * -------------------------------
  * Implements MQTT communication:
- *  - Connects to the MQTT server using credentials from config
+ *  - Connects to the MQTT server using credentials from config,
+ *    over TlsClient (resumed sessions, CA from /mqtt_ca.pem if any)
  *  - Publishes status and log messages
  *  - Subscribes to WOL commands
- *  - Processes incoming messages to trigger WOL or ping
+ *  - Hands incoming messages to the command dispatcher (commands.cpp)
+ *  - mqttTask() owns the client: reconnect, loop(), log flushing and
+ *    the MPSC queue of posts from the other tasks
+ *  - Last will "offline" on wol/availability, "online" once connected
+ *  - wol/event is cleared once per connect; its empty echo marks the
+ *    end of the retained delivery, and nothing received on wol/event
+ *    before it is run (MQTT_EVENT_SYNC_MS if the echo never comes)
+ *  - Retained posts go through a dedup table: topic hash -> payload
+ *    hash of the last publish, reset on every connect
  */
 
+#include <SPIFFS.h>
+#include <atomic>
 #include "mqtt.h"
 #include "config.h"
-#include "wol_ping.h"
 #include "helpers.h"
-
-WiFiClientSecure espClient;
+#include "wifi_utils.h"
+#include "commands.h"
+#include "boot_profile.h"
+#include "metrics.h"
+#include "tasks.h"
+#include "lockfree_queue.h"
+
+#define MQTT_HA_STATUS MQTT_HA_PREFIX "/status"
+
+struct MqttPost {
+  char     topic[MQTT_TOPIC_LEN];
+  char*    payload;      // heap copy, freed by the mqtt task
+  uint16_t len;
+  bool     retained;
+};
+
+struct DedupSlot {
+  uint32_t topic;      // 0 = free
+  uint32_t payload;
+};
+
+static TlsClient espClient;
 PubSubClient mqtt(espClient);
 
 bool chkUpdate = false;
 
-void setupMQTT() {
-  espClient.setInsecure();
-  mqtt.setServer(config.mqtt_server, config.mqtt_port);
-  mqtt.setCallback(mqttCallback);
+static unsigned long mqttBackoff = MQTT_BACKOFF_MIN_MS;
+static unsigned long mqttNextAttempt = 0;
+static std::atomic<bool> linkUp{false};
+static MpscQueue<MqttPost, MQTT_POST_QUEUE_LEN> posts;
+static std::atomic<uint32_t> session{0};
+static std::atomic<bool> haBirth{false};
+
+// mqtt task only
+static DedupSlot dedup[MQTT_DEDUP_SLOTS];
+static bool eventSynced = false;
+static unsigned long eventSyncBy = 0;
+
+static uint32_t fnv1a(const void* data, size_t len, uint32_t h = 2166136261u){
+  const uint8_t* p = (const uint8_t*)data;
+  for(size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+  return h ? h : 1;
 }
 
 bool mqttConnected() { 
-  return mqtt.connected();
+  return linkUp.load(std::memory_order_relaxed);
+}
+
+uint32_t mqttSession() {
+  return session.load(std::memory_order_relaxed);
+}
+
+bool mqttTakeHaBirth() {
+  return haBirth.exchange(false, std::memory_order_relaxed);
 }
 
-void ensureMqtt() {
-  while(!mqtt.connected()){
-    if(mqtt.connect("ESP32C3-WOL", config.mqtt_user, config.mqtt_password)){
-      mqtt.publish("wol/status","MQTT Ready",true);
-      mqtt.subscribe("wol/event");
-      mqtt.publish("wol/event", "", true);
 
-    } else {
-      delay(2000);
-    } 
+// One connection attempt per call, with exponential backoff between failures
+static void ensureMqtt() {
+  if(mqtt.connected() || !wifiConnected()) return;
+  if((long)(millis() - mqttNextAttempt) < 0) return;
+
+  unsigned long t0 = millis();
+  if(mqtt.connect("ESP32C3-WOL", config.mqtt_user, config.mqtt_password,
+                  MQTT_AVAIL_TOPIC, 0, true, "offline")){
+    logMsg(LOGL_INFO, "MQTT: Connected in %lu ms", millis() - t0);
+    memset(dedup, 0, sizeof(dedup));
+    eventSynced = false;
+    eventSyncBy = millis() + MQTT_EVENT_SYNC_MS;
+    mqtt.publish(MQTT_AVAIL_TOPIC, "online", true);
+    mqtt.publish("wol/status","MQTT Ready",true);
+    mqtt.subscribe("wol/event");
+    mqtt.subscribe(MQTT_HA_STATUS);
+    mqtt.publish("wol/event", "", true);
+    metricInc(CNT_MQTT_PUBLISHED, 3);
+    mqttBackoff = MQTT_BACKOFF_MIN_MS;
+    session.fetch_add(1, std::memory_order_relaxed);
+    linkUp.store(true, std::memory_order_relaxed);
+    metricInc(CNT_MQTT_CONNECTS);
+    bootMarkOnce("mqtt_up");
+    bootPublish();
+
+  } else {
+    metricInc(CNT_MQTT_CONNECT_FAILS);
+    mqttNextAttempt = millis() + mqttBackoff;
+    mqttBackoff = min(mqttBackoff * 2, MQTT_BACKOFF_MAX_MS);
   }
 }
 
-void mqttLoop() { 
-  mqtt.loop();
+static bool publishPost(const MqttPost &p) {
+  if(p.len + strlen(p.topic) + 8 <= MQTT_BUFFER_SIZE)
+    return mqtt.publish(p.topic, (const uint8_t*)p.payload, p.len, p.retained);
+  if(!mqtt.beginPublish(p.topic, p.len, p.retained)) return false;
+  mqtt.write((const uint8_t*)p.payload, p.len);
+  return mqtt.endPublish();
 }
 
-void mqttCallback(char* topic, byte* payload, unsigned int len) {
-  String msg; 
-  for(unsigned int i = 0;i < len; i++) {
-    msg += (char)payload[i];
-    msg.trim();
+// Posts made while the broker is down are dropped, like a failed publish().
+// A retained post equal to what the broker already holds is not sent.
+static void drainPosts() {
+  MqttPost p;
+  while(posts.pop(p)){
+    uint32_t t = p.retained ? fnv1a(p.topic, strlen(p.topic)) : 0;
+    uint32_t v = p.retained ? fnv1a(p.payload, p.len) : 0;
+    DedupSlot &d = dedup[t & (MQTT_DEDUP_SLOTS - 1)];
+
+    if(!mqtt.connected()){
+      // dropped
+    } else if(p.retained && d.topic == t && d.payload == v){
+      metricInc(CNT_MQTT_DEDUPED);
+    } else if(publishPost(p)){
+      metricInc(CNT_MQTT_PUBLISHED);
+      if(p.retained){
+        d.topic = t;      // a colliding topic just takes the slot over
+        d.payload = v;
+      }
+    }
+    free(p.payload);
   }
+}
 
-  if(msg == "TurnOn"){
-    blinkDigit(2);
-    sendWOL("MQTT", 10);
-
-  } else if(msg == "TurnOff"){
-    blinkDigit(2);
-    sendShutdownPacket("MQTT", 10);
-
-  } else if(msg == "CheckUpdate"){
-    blinkDigit(2);
-    chkUpdate = true;
-
-  } else if(msg == "FactoryReset"){
-    blinkDigit(2);
-    factoryReset();
-
-  } else if(msg == "PingPC"){
-    blinkDigit(2);
-    doPing();
-
-  } else if(msg == "PinOut1On"){
-    blinkDigit(2);
-    digitalWrite(PIN1_GPIO, HIGH);
-    mqttPublish("PinOut 1 -> ON");
-
-  } else if(msg == "PinOut1Off"){
-    blinkDigit(2);
-    digitalWrite(PIN1_GPIO, LOW);
-    mqttPublish("PinOut 1 -> OFF");
-
-  } else if(msg == "PinOut2On"){
-    blinkDigit(2);
-    digitalWrite(PIN2_GPIO, HIGH);
-    mqttPublish("PinOut 2 -> ON");
-
-  } else if(msg == "PinOut2Off"){
-    blinkDigit(2);
-    digitalWrite(PIN2_GPIO, LOW);
-    mqttPublish("PinOut 2 -> OFF");
+static void mqttTask(void*) {
+  for(;;){
+    ensureMqtt();
+    mqtt.loop();
+    linkUp.store(mqtt.connected(), std::memory_order_relaxed);
+    drainPosts();
+    logPump();
+    vTaskDelay(pdMS_TO_TICKS(MQTT_TASK_MS));
   }
+}
 
-  mqtt.publish("wol/event", "", true);
+void setupMQTT() {
+  // Optional broker CA; without it the broker is not verified
+  File f = SPIFFS.open(MQTT_CA_FILE, "r");
+  if(f){
+    String pem = f.readString();
+    f.close();
+    if(espClient.setCA(pem.c_str())) logMsg(LOGL_INFO, "MQTT: Broker CA pinned");
+  }
+  mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+  mqtt.setServer(config.mqtt_server, config.mqtt_port);
+  mqtt.setCallback(mqttCallback);
+  if(!taskStart(mqttTask, "mqtt", TASK_STACK_MQTT, TASK_PRIO_MQTT, TASK_CORE_NET))
+    logMsg(LOGL_ERROR, "MQTT: Could not start task");
+}
+
+// Any task; the payload is copied, the mqtt task publishes it
+bool mqttPost(const char* topic, const void* payload, size_t len, bool retained) {
+  if(!mqttConnected() || len > 0xFFFF) return false;
+
+  MqttPost p;
+  strlcpy(p.topic, topic, sizeof(p.topic));
+  p.payload = (char*)malloc(len ? len : 1);
+  if(!p.payload) return false;
+  memcpy(p.payload, payload, len);
+  p.len = len;
+  p.retained = retained;
+
+  if(!posts.push(p)){
+    free(p.payload);
+    return false;
+  }
+  return true;
+}
+
+bool mqttPost(const char* topic, const char* payload, bool retained) {
+  return mqttPost(topic, payload, strlen(payload), retained);
+}
+
+// Runs on the mqtt task; the command itself runs on the loop task
+void mqttCallback(char* topic, byte* payload, unsigned int len) {
+  if(!strcmp(topic, MQTT_HA_STATUS)){
+    if(len == 6 && !memcmp(payload, "online", 6)) haBirth.store(true, std::memory_order_relaxed);
+    return;
+  }
+  if(!len){
+    eventSynced = true;   // our own clear: the retained command, if any, came before it
+    return;
+  }
+
+  // A command left retained by a client is delivered again on every
+  // connect, before the echo of our clear; it ran when it was sent
+  if(!eventSynced && (long)(millis() - eventSyncBy) < 0){
+    logMsg(LOGL_DEBUG, "MQTT: Retained command skipped");
+    return;
+  }
+  commandPost((const char*)payload, len, "MQTT");
 }
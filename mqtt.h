@@ -4,19 +4,41 @@
  * Declares functions and objects for MQTT communication.
  * Handles connection, reconnection, subscribing, publishing,
  * and processing incoming MQTT messages for WOL events.
+ * The transport is TlsClient (session resumption, optional CA pin).
+ *
+ * The client lives in its own "mqtt" task (tasks.h): other tasks
+ * publish through mqttPost(), incoming commands are handed to the
+ * loop task with commandPost().
+ *
+ * Retained hygiene: wol/event is cleared once per connect, not per
+ * command; a retained post whose payload equals the last one sent on
+ * that topic in this session is dropped (MQTT_DEDUP_SLOTS topics).
  */
 
 #pragma once
 #include <PubSubClient.h>
-#include <WiFiClientSecure.h>
+#include "tls_client.h"
 
-extern WiFiClientSecure espClient;
-extern PubSubClient mqtt;
+#define MQTT_TASK_MS          5
+#define MQTT_BACKOFF_MIN_MS   2000UL
+#define MQTT_BACKOFF_MAX_MS   60000UL
+#define MQTT_BUFFER_SIZE      1536   // metrics snapshot, boot timeline
+#define MQTT_CA_FILE          "/mqtt_ca.pem"
+#define MQTT_TOPIC_LEN        96
+#define MQTT_POST_QUEUE_LEN   16
+#define MQTT_DEDUP_SLOTS      64     // power of two
+#define MQTT_EVENT_SYNC_MS    3000   // wol/event counts as synced without the echo of our clear
+#define MQTT_AVAIL_TOPIC      "wol/availability"   // "online" / "offline" (will)
+#define MQTT_HA_PREFIX        "homeassistant"
+
+extern PubSubClient mqtt;     // mqtt task only (mqtt.cpp, logger.cpp)
 
 extern bool chkUpdate;
 
 void setupMQTT();
-void ensureMqtt();
 bool mqttConnected();
-void mqttLoop();
+uint32_t mqttSession();       // +1 per broker connect; any task
+bool mqttTakeHaBirth();       // Home Assistant announced "online" since the last call
+bool mqttPost(const char* topic, const void* payload, size_t len, bool retained);
+bool mqttPost(const char* topic, const char* payload, bool retained);
 void mqttCallback(char* topic, byte* payload, unsigned int len);
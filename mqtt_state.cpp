@@ -0,0 +1,155 @@
+/*
+ * mqtt_state.cpp
+ * -------------------------------
+ * Implements the retained state topics and Home Assistant discovery:
+ *  - pinSent[] / hostSent[] hold the value last handed to the broker
+ *    (STATE_UNSET after a connect), a topic is posted only when the
+ *    current value differs from it
+ *  - Host state comes from the probe engine (probeStats), pins are
+ *    read back from the GPIOs, so every command path is covered
+ *  - A failed mqttPost() (queue full) is retried on the next tick
+ *  - Discovery walks a cursor over 2 + 2 * fleetSize entities; the
+ *    device is identified by the WiFi MAC
+ */
+
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include "mqtt_state.h"
+#include "mqtt.h"
+#include "fleet.h"
+#include "probe.h"
+#include "scheduler.h"
+
+#define STATE_UNSET 0xFF
+#define STATE_PINS  2
+
+static const uint8_t pinGpio[STATE_PINS] = { PIN1_GPIO, PIN2_GPIO };
+
+// loop task only
+static uint8_t  pinSent[STATE_PINS];
+static uint8_t  hostSent[FLEET_MAX_HOSTS];
+static uint32_t lastSession = 0;
+static int      discoveryNext = -1;   // next entity to announce, -1 = none
+static char     deviceId[20];
+
+// Discovery object ids allow [a-zA-Z0-9_-] only
+static void objectId(char* out, size_t n, const char* name){
+  size_t i = 0;
+  for(; name[i] && i + 1 < n; i++) out[i] = isalnum((unsigned char)name[i]) || name[i] == '-' ? name[i] : '_';
+  out[i] = 0;
+}
+
+static bool postDiscovery(int i){
+  JsonDocument doc;
+  char topic[MQTT_TOPIC_LEN], uid[48], name[40], state[MQTT_TOPIC_LEN], on[16], off[16];
+  char press[48];
+
+  if(i < STATE_PINS){
+    snprintf(topic, sizeof(topic), MQTT_HA_PREFIX "/switch/%s/pin%d/config", deviceId, i + 1);
+    snprintf(uid, sizeof(uid), "%s_pin%d", deviceId, i + 1);
+    snprintf(name, sizeof(name), "PinOut %d", i + 1);
+    snprintf(state, sizeof(state), "wol/state/pin%d", i + 1);
+    snprintf(on, sizeof(on), "PinOut%dOn", i + 1);
+    snprintf(off, sizeof(off), "PinOut%dOff", i + 1);
+    doc["command_topic"] = "wol/event";
+    doc["state_topic"] = state;
+    doc["payload_on"] = on;
+    doc["payload_off"] = off;
+    doc["state_on"] = "ON";
+    doc["state_off"] = "OFF";
+    doc["retain"] = false;
+  } else {
+    int host = (i - STATE_PINS) / 2;
+    bool button = (i - STATE_PINS) & 1;
+    char obj[FLEET_NAME_LEN];
+    objectId(obj, sizeof(obj), fleetHosts[host].name);
+    if(!button){
+      snprintf(topic, sizeof(topic), MQTT_HA_PREFIX "/binary_sensor/%s/%s/config", deviceId, obj);
+      snprintf(uid, sizeof(uid), "%s_host_%s", deviceId, obj);
+      snprintf(name, sizeof(name), "%s", fleetHosts[host].name);
+      snprintf(state, sizeof(state), "wol/state/host/%s", fleetHosts[host].name);
+      doc["state_topic"] = state;
+      doc["device_class"] = "connectivity";
+      doc["payload_on"] = "online";
+      doc["payload_off"] = "offline";
+    } else {
+      snprintf(topic, sizeof(topic), MQTT_HA_PREFIX "/button/%s/%s/config", deviceId, obj);
+      snprintf(uid, sizeof(uid), "%s_wake_%s", deviceId, obj);
+      snprintf(name, sizeof(name), "Wake %s", fleetHosts[host].name);
+      // Host 0 goes through TurnOn so the wake watch follows it
+      if(host == 0) strlcpy(press, "TurnOn", sizeof(press));
+      else snprintf(press, sizeof(press), "WakeHost:%s", fleetHosts[host].name);
+      doc["command_topic"] = "wol/event";
+      doc["payload_press"] = press;
+      doc["retain"] = false;
+    }
+  }
+  doc["name"] = name;
+  doc["unique_id"] = uid;
+  doc["availability_topic"] = MQTT_AVAIL_TOPIC;
+  JsonObject dev = doc["device"].to<JsonObject>();
+  dev["identifiers"].to<JsonArray>().add(deviceId);
+  dev["name"] = "WOL ESP32";
+  dev["sw_version"] = FIRMWARE_VERSION;
+
+  char buf[640];
+  size_t n = serializeJson(doc, buf, sizeof(buf));
+  return n && mqttPost(topic, buf, n, true);
+}
+
+static bool postHost(int host, uint8_t state){
+  char topic[MQTT_TOPIC_LEN];
+  snprintf(topic, sizeof(topic), "wol/state/host/%s", fleetHosts[host].name);
+  return mqttPost(topic, state == PROBE_UP ? "online" : "offline", true);
+}
+
+static void stateTask(){
+  if(!mqttConnected()) return;
+
+  // New session: the broker may have lost what we sent, assert it all again
+  uint32_t s = mqttSession();
+  if(s != lastSession){
+    if(!lastSession) discoveryNext = 0;
+    lastSession = s;
+    memset(pinSent, STATE_UNSET, sizeof(pinSent));
+    memset(hostSent, STATE_UNSET, sizeof(hostSent));
+  }
+  if(mqttTakeHaBirth() && discoveryNext < 0) discoveryNext = 0;
+
+  int budget = STATE_POSTS_PER_TICK;
+  while(discoveryNext >= 0 && budget > 0){
+    if(discoveryNext >= STATE_PINS + 2 * fleetSize){
+      discoveryNext = -1;
+      break;
+    }
+    if(!postDiscovery(discoveryNext)) return;
+    discoveryNext++;
+    budget--;
+  }
+
+  for(int i = 0; i < STATE_PINS && budget > 0; i++){
+    uint8_t v = digitalRead(pinGpio[i]) ? 1 : 0;
+    if(v == pinSent[i]) continue;
+    char topic[24];
+    snprintf(topic, sizeof(topic), "wol/state/pin%d", i + 1);
+    if(!mqttPost(topic, v ? "ON" : "OFF", true)) return;
+    pinSent[i] = v;
+    budget--;
+  }
+
+  for(int h = 0; h < fleetSize && budget > 0; h++){
+    uint8_t v = probeStats(h).state;
+    if(v == PROBE_UNKNOWN || v == hostSent[h]) continue;
+    if(!postHost(h, v)) return;
+    hostSent[h] = v;
+    budget--;
+  }
+}
+
+void mqttStateBegin(){
+  String mac = WiFi.macAddress();
+  mac.replace(":", "");
+  mac.toLowerCase();
+  snprintf(deviceId, sizeof(deviceId), "wol_%s", mac.c_str());
+  schedulerEvery(STATE_TASK_MS, stateTask);
+}
@@ -0,0 +1,21 @@
+/*
+ * mqtt_state.h
+ * -------------------------------
+ * Declares the retained MQTT state topics and Home Assistant discovery:
+ *  - wol/state/pin1, wol/state/pin2: "ON" / "OFF"
+ *  - wol/state/host/<name>: "online" / "offline" per fleet host
+ *  - Published only when a value changes, and once more after every
+ *    broker connect; paced, the post queue is short
+ *  - Discovery configs under MQTT_HA_PREFIX: a switch per output, a
+ *    connectivity binary_sensor and a wake button per host; sent on
+ *    the first connect after boot and when Home Assistant comes online
+ *  - Runs on the loop task
+ */
+
+#pragma once
+#include "config.h"
+
+#define STATE_TASK_MS        100
+#define STATE_POSTS_PER_TICK 6      // of MQTT_POST_QUEUE_LEN, leaves room for logs and metrics
+
+void mqttStateBegin();
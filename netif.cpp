@@ -0,0 +1,192 @@
+/*
+ * netif.cpp
+ * -------------------------------
+ * Implements the network-interface transmit layer:
+ *  - Opens the WiFi UDP sockets at boot, the Ethernet ones as soon
+ *    as the background W5500 init has finished
+ *  - netifPoll() checks the W5500 link and refreshes the cached
+ *    broadcast and local addresses (config broadcastIP overrides
+ *    WiFi); the tx task calls it every NETIF_LINK_POLL_MS and is
+ *    the only task that touches the sockets and the W5500 after boot
+ *  - Routes each frame according to config.tx_mode
+ *  - Counts endPacket() successes and failures per interface
+ */
+
+#include <WiFi.h>
+#include <Ethernet.h>
+#include "netif.h"
+#include "helpers.h"
+#include "boot_profile.h"
+#include "metrics.h"
+
+bool ethernet_lan_present = false;
+NetifStats wifiStats = { 0, 0 };
+NetifStats ethStats  = { 0, 0 };
+
+static WiFiUDP wifiUdp;
+static EthernetUDP ethUdp;
+static EthernetUDP ethDhcp;   // broadcasts to :67, for presence
+static WiFiUDP wifiExtra[NETIF_EXTRA_PORTS];
+static EthernetUDP ethExtra[NETIF_EXTRA_PORTS];
+static uint16_t extraPorts[NETIF_EXTRA_PORTS];
+static int extraCount = 0;
+static bool ethHardware = false;
+static bool ethChecked = false;
+static volatile bool ethInitDone = false;
+static uint8_t ethMac[6];
+static IPAddress ethIp;
+static IPAddress wifiBcast;
+static IPAddress ethBcast;
+static IPAddress wifiLocal;
+static IPAddress ethLocal;
+
+static IPAddress broadcastOf(IPAddress ip, IPAddress mask){
+  IPAddress b;
+  for(int k = 0; k < 4; k++) b[k] = ip[k] | (uint8_t)~mask[k];
+  return b;
+}
+
+void netifPoll(){
+  IPAddress o;
+  char bcast[sizeof(config.broadcastIPStr)];
+  portENTER_CRITICAL(&configLock);
+  memcpy(bcast, config.broadcastIPStr, sizeof(bcast));
+  portEXIT_CRITICAL(&configLock);
+  if(bcast[0] && o.fromString(bcast)) wifiBcast = o;
+  else wifiBcast = broadcastOf(WiFi.localIP(), WiFi.subnetMask());
+  wifiLocal = WiFi.localIP();
+
+  if(ethInitDone && !ethChecked){
+    ethChecked = true;
+    ethHardware = Ethernet.hardwareStatus() != EthernetNoHardware;
+    if(ethHardware){
+      ethUdp.begin(config.udp_port);
+      ethDhcp.begin(67);
+      for(int i = 0; i < extraCount; i++) ethExtra[i].begin(extraPorts[i]);
+    }
+    else logMsg(LOGL_WARN, "LAN (SPI): no W5500 found");
+    bootMark("lan_init");
+  }
+
+  if(!ethHardware) return;
+  ethLocal = Ethernet.localIP();
+  ethBcast = broadcastOf(ethLocal, Ethernet.subnetMask());
+
+  bool up = Ethernet.linkStatus() == LinkON;
+  if(up != ethernet_lan_present){
+    ethernet_lan_present = up;
+    if(up) bootMarkOnce("lan_link");
+    logMsg(up ? LOGL_INFO : LOGL_WARN, up ? "LAN (SPI) link up" : "LAN (SPI) link down");
+  }
+}
+
+static void ethInitTask(void*){
+  Ethernet.begin(ethMac, ethIp);
+  ethInitDone = true;
+  vTaskDelete(NULL);
+}
+
+// SPI.begin() and Ethernet.init() must already have run
+void netifStartEthernet(const uint8_t mac[6], IPAddress ip){
+  memcpy(ethMac, mac, sizeof(ethMac));
+  ethIp = ip;
+  if(xTaskCreate(ethInitTask, "eth_init", NETIF_ETH_INIT_STACK, NULL, 1, NULL) != pdPASS){
+    Ethernet.begin(ethMac, ethIp);
+    ethInitDone = true;
+  }
+}
+
+// A port besides config.udp_port, on both interfaces
+bool netifListen(uint16_t port){
+  if(port == config.udp_port) return true;
+  for(int i = 0; i < extraCount; i++) if(extraPorts[i] == port) return true;
+  if(extraCount >= NETIF_EXTRA_PORTS) return false;
+  extraPorts[extraCount++] = port;
+  return true;
+}
+
+void netifBegin(){
+  wifiUdp.begin(config.udp_port);
+  for(int i = 0; i < extraCount; i++) wifiExtra[i].begin(extraPorts[i]);
+  netifPoll();
+}
+
+static size_t readFrom(UDP &sock, uint8_t* buf, size_t len, NetifRx &rx, NetIface iface, uint16_t port){
+  if(sock.parsePacket() <= 0) return 0;
+  rx.iface = iface;
+  rx.port = port;
+  rx.from = sock.remoteIP();
+  int n = sock.read(buf, len);
+  sock.flush();   // WiFiUDP: parsePacket() returns 0 while a datagram's tail is still buffered
+  return n > 0 ? n : 0;
+}
+
+// One datagram per call, WiFi first; 0 when all sockets are empty.
+// Longer datagrams are cut to len, readFrom() drops the rest.
+size_t netifReceive(uint8_t* buf, size_t len, NetifRx &rx){
+  size_t n;
+  if((n = readFrom(wifiUdp, buf, len, rx, NETIF_WIFI, config.udp_port)) > 0) return n;
+  for(int i = 0; i < extraCount; i++)
+    if((n = readFrom(wifiExtra[i], buf, len, rx, NETIF_WIFI, extraPorts[i])) > 0) return n;
+  if(!ethHardware) return 0;
+  if((n = readFrom(ethUdp, buf, len, rx, NETIF_ETH, config.udp_port)) > 0) return n;
+  for(int i = 0; i < extraCount; i++)
+    if((n = readFrom(ethExtra[i], buf, len, rx, NETIF_ETH, extraPorts[i])) > 0) return n;
+  return 0;
+}
+
+size_t netifReceiveDhcp(uint8_t* buf, size_t len){
+  if(!ethHardware || ethDhcp.parsePacket() <= 0) return 0;
+  int n = ethDhcp.read(buf, len);
+  ethDhcp.flush();
+  return n > 0 ? n : 0;
+}
+
+IPAddress netifBroadcast(NetIface iface){
+  return iface == NETIF_ETH ? ethBcast : wifiBcast;
+}
+
+IPAddress netifLocalIP(NetIface iface){
+  return iface == NETIF_ETH ? ethLocal : wifiLocal;
+}
+
+static uint8_t netifRoute(uint8_t ifaces){
+  if(!ethernet_lan_present) return ifaces & NETIF_WIFI;
+  if(config.tx_mode == TX_MODE_FAILOVER && ifaces == NETIF_BOTH) return NETIF_ETH;
+  return ifaces;
+}
+
+static bool sendOn(UDP &sock, IPAddress dst, uint16_t port, const uint8_t* hdr, size_t hdrLen,
+                   const uint8_t* body, size_t bodyLen, NetifStats &stats, CounterId failId){
+  bool ok = sock.beginPacket(dst, port);
+  if(ok){
+    sock.write(hdr, hdrLen);
+    sock.write(body, bodyLen);
+    ok = sock.endPacket();
+  }
+  if(ok){
+    stats.sent++;
+  } else {
+    stats.failed++;
+    metricInc(failId);
+  }
+  return ok;
+}
+
+uint8_t netifSend(uint8_t ifaces, uint16_t port, const uint8_t* hdr, size_t hdrLen,
+                  const uint8_t* body, size_t bodyLen){
+  uint8_t route = netifRoute(ifaces);
+  uint8_t done = 0;
+
+  if((route & NETIF_WIFI) && sendOn(wifiUdp, wifiBcast, port, hdr, hdrLen, body, bodyLen, wifiStats, CNT_TX_FAIL_WIFI))
+    done |= NETIF_WIFI;
+  if((route & NETIF_ETH) && sendOn(ethUdp, ethBcast, port, hdr, hdrLen, body, bodyLen, ethStats, CNT_TX_FAIL_ETH))
+    done |= NETIF_ETH;
+
+  // Failover: a W5500 send error falls back to WiFi for this frame
+  if(route == NETIF_ETH && !done && (ifaces & NETIF_WIFI) &&
+     sendOn(wifiUdp, wifiBcast, port, hdr, hdrLen, body, bodyLen, wifiStats, CNT_TX_FAIL_WIFI))
+    done |= NETIF_WIFI;
+
+  return done;
+}
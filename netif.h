@@ -0,0 +1,61 @@
+/*
+ * netif.h
+ * -------------------------------
+ * Declares the network-interface transmit layer:
+ *  - One persistent UDP socket per interface (WiFi, W5500)
+ *  - Broadcast address derived from each interface's netmask
+ *  - TX mode: send on both interfaces, or fail over to WiFi
+ *    when the W5500 link is down
+ *  - Per-interface sent / failed counters
+ *  - netifReceive() reads datagrams sent to those sockets and to
+ *    the extra ports opened with netifListen() (agent acks, relayed
+ *    magic packets), with the interface, port and sender;
+ *    netifReceiveDhcp() reads DHCP requests seen on the W5500
+ *    (presence.h)
+ *  - W5500 init (blocking ~0.5 s in the Ethernet library) runs in
+ *    its own task so WiFi association and boot continue meanwhile
+ */
+
+#pragma once
+#include "config.h"
+
+#define NETIF_LINK_POLL_MS   1000
+#define NETIF_ETH_INIT_STACK 3072
+#define NETIF_EXTRA_PORTS    2       // netifListen(), per interface
+
+enum NetIface : uint8_t {
+  NETIF_WIFI = 1,
+  NETIF_ETH  = 2,
+  NETIF_BOTH = 3
+};
+
+enum TxMode : uint8_t {
+  TX_MODE_BOTH     = 0,
+  TX_MODE_FAILOVER = 1
+};
+
+struct NetifStats {
+  unsigned long sent;
+  unsigned long failed;
+};
+
+struct NetifRx {
+  uint8_t   iface;    // NetIface it arrived on
+  uint16_t  port;     // local port
+  IPAddress from;
+};
+
+extern bool ethernet_lan_present;
+extern NetifStats wifiStats;
+extern NetifStats ethStats;
+
+void    netifStartEthernet(const uint8_t mac[6], IPAddress ip);
+void    netifBegin();
+bool    netifListen(uint16_t port);   // before netifBegin()
+void    netifPoll();
+uint8_t netifSend(uint8_t ifaces, uint16_t port, const uint8_t* hdr, size_t hdrLen,
+                  const uint8_t* body, size_t bodyLen);
+size_t  netifReceive(uint8_t* buf, size_t len, NetifRx &rx);
+size_t  netifReceiveDhcp(uint8_t* buf, size_t len);
+IPAddress netifBroadcast(NetIface iface);
+IPAddress netifLocalIP(NetIface iface);
@@ -2,157 +2,584 @@
  * ota.cpp
  * -------------------------------
  * Implements the OTA update process:
- *  - Downloads version.txt from GitHub
- *  - Compares with the current firmware version
- *  - If newer, downloads firmware binary
- *  - Writes it to the OTA partition with progress via MQTT
- *  - Restarts on success
+ *  - Runs in its own FreeRTOS task, so boot and loop() never wait on
+ *    GitHub; otaPoll() starts it when a check is due
+ *  - Downloads version.txt with If-None-Match (ETag kept in NVS); an
+ *    unchanged file costs a 304 and reuses the cached version string
+ *  - Compares versions numerically ("6.10" > "6.9"), never downgrades
+ *  - If newer, downloads the SHA-256 digest and the firmware binary,
+ *    preferring the gzip image (inflated while streaming through a
+ *    fixed 32 KB window, never buffered whole)
+ *  - Network reads fill one buffer while a writer task flashes the
+ *    other one (double-buffered esp_ota_write)
+ *  - A dropped or stalled connection resumes with an HTTP Range
+ *    request from the last byte received
+ *  - The image is hashed on the fly and checked against the digest
+ *    before the boot partition is switched
+ *  - Progress and throughput (KB/s) via MQTT, restarts on success
  */
- 
+
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
 #include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <rom/miniz.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <Preferences.h>
+#include "ota.h"
 #include "mqtt.h"
+#include "tasks.h"
 #include "config.h"
 #include "helpers.h"
+#include "scheduler.h"
+#include "wifi_utils.h"
+#include "metrics.h"
+
+// URLs GitHub, unless OTA_BASE_URL is set in ota.h
+#ifndef OTA_BASE_URL
+#define OTA_BASE_URL "https://raw.githubusercontent.com/sergio-isidoro/Wake-on-LAN_ESP32C3/main/firmware/"
+#endif
+
+const char* versionURL   = OTA_BASE_URL "version.txt";
+const char* firmwareURL  = OTA_BASE_URL "WOL_ESP32.bin";
+const char* firmwareGzURL = OTA_BASE_URL "WOL_ESP32.bin.gz";
+const char* digestURL    = OTA_BASE_URL "WOL_ESP32.bin.sha256";
+
+#define OTA_BUF_SIZE      4096
+#define OTA_MAX_RESUMES   5
+#define OTA_STALL_MS      10000
+#define OTA_WRITER_STACK  4096
+#define OTA_TASK_STACK    8192
+
+static volatile bool otaRunning = false;
+static volatile bool otaRestart = false;
+
+// Flash side: two buffers cycle between the reader (fills, hashes)
+// and the writer task (esp_ota_write)
+struct OtaWriter {
+    esp_ota_handle_t  handle;
+    uint8_t*          bufs[2];
+    size_t            lens[2];
+    QueueHandle_t     full;      // buffer index to flash, -1 = stop
+    QueueHandle_t     empty;     // buffer index ready to fill
+    SemaphoreHandle_t done;
+    volatile bool     failed;
+    int               cur;       // buffer being filled, -1 = none
+    size_t            fill;
+    size_t            written;
+    mbedtls_sha256_context sha;
+};
+
+enum OtaOpen : uint8_t {
+    OTA_OPEN_OK,
+    OTA_OPEN_RETRY,      // network error, 5xx: resumed like a drop
+    OTA_OPEN_MISSING     // 4xx: final, e.g. no gzip image published
+};
+
+enum GzStage : uint8_t { GZ_FIXED, GZ_XLEN, GZ_EXTRA, GZ_NAME, GZ_COMMENT, GZ_HCRC, GZ_BODY };
+
+// gzip stream: header parser + ROM tinfl with a 32 KB circular window
+struct GzInflater {
+    tinfl_decompressor inf;
+    uint8_t  dict[TINFL_LZ_DICT_SIZE];
+    size_t   dictOfs;
+    uint8_t  stage;
+    uint8_t  flags;
+    uint16_t pos;
+    uint16_t xlen;
+    bool     done;
+};
+
+static void otaWriterTask(void* arg) {
+    OtaWriter* w = (OtaWriter*)arg;
+    int idx;
+
+    while (xQueueReceive(w->full, &idx, portMAX_DELAY) == pdTRUE && idx >= 0) {
+        if (!w->failed && esp_ota_write(w->handle, w->bufs[idx], w->lens[idx]) != ESP_OK) {
+            w->failed = true;
+        }
+        xQueueSend(w->empty, &idx, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(w->done);
+    vTaskDelete(NULL);
+}
+
+static void sinkSubmit(OtaWriter &w) {
+    if (w.cur < 0) return;
+    mbedtls_sha256_update(&w.sha, w.bufs[w.cur], w.fill);
+    w.lens[w.cur] = w.fill;
+    xQueueSend(w.full, &w.cur, portMAX_DELAY);
+    w.written += w.fill;
+    w.cur = -1;
+}
+
+static void sinkPut(OtaWriter &w, const uint8_t* data, size_t len) {
+    while (len && !w.failed) {
+        if (w.cur < 0) {
+            xQueueReceive(w.empty, &w.cur, portMAX_DELAY);
+            w.fill = 0;
+        }
+        size_t n = min(len, (size_t)OTA_BUF_SIZE - w.fill);
+        memcpy(w.bufs[w.cur] + w.fill, data, n);
+        w.fill += n;
+        data += n;
+        len -= n;
+        if (w.fill == OTA_BUF_SIZE) sinkSubmit(w);
+    }
+}
+
+// Moves to the next gzip header field present in the flags
+static void gzNext(GzInflater &g) {
+    for (;;) {
+        g.stage++;
+        g.pos = 0;
+        switch (g.stage) {
+            case GZ_XLEN:    if (g.flags & 0x04) return; break;
+            case GZ_EXTRA:   if ((g.flags & 0x04) && g.xlen) return; break;
+            case GZ_NAME:    if (g.flags & 0x08) return; break;
+            case GZ_COMMENT: if (g.flags & 0x10) return; break;
+            case GZ_HCRC:    if (g.flags & 0x02) return; break;
+            default:         return;
+        }
+    }
+}
+
+// Consumes header bytes; returns how many were used, or -1 if not gzip
+static int gzHeader(GzInflater &g, const uint8_t* p, size_t len) {
+    static const uint8_t magic[3] = { 0x1F, 0x8B, 0x08 };
+    size_t i = 0;
+
+    while (i < len && g.stage != GZ_BODY) {
+        uint8_t b = p[i++];
+        switch (g.stage) {
+            case GZ_FIXED:
+                if (g.pos < 3 && b != magic[g.pos]) return -1;
+                if (g.pos == 3) g.flags = b;
+                if (++g.pos == 10) gzNext(g);
+                break;
+            case GZ_XLEN:
+                g.xlen |= b << (8 * g.pos);
+                if (++g.pos == 2) gzNext(g);
+                break;
+            case GZ_EXTRA:
+                if (++g.pos == g.xlen) gzNext(g);
+                break;
+            case GZ_NAME:
+            case GZ_COMMENT:
+                if (b == 0) gzNext(g);
+                break;
+            case GZ_HCRC:
+                if (++g.pos == 2) gzNext(g);
+                break;
+        }
+    }
+    return i;
+}
+
+static bool gzFeed(GzInflater &g, const uint8_t* p, size_t len, OtaWriter &w) {
+    int used = gzHeader(g, p, len);
+    if (used < 0) return false;
+    p += used;
+    len -= used;
+    if (g.stage != GZ_BODY) return true;
+
+    tinfl_status st;
+    do {
+        if (g.done) return true;
+        size_t inSize = len;
+        size_t outSize = TINFL_LZ_DICT_SIZE - g.dictOfs;
+        st = tinfl_decompress(&g.inf, p, &inSize, g.dict, g.dict + g.dictOfs, &outSize,
+                              TINFL_FLAG_HAS_MORE_INPUT);
+        p += inSize;
+        len -= inSize;
+        sinkPut(w, g.dict + g.dictOfs, outSize);
+        g.dictOfs = (g.dictOfs + outSize) & (TINFL_LZ_DICT_SIZE - 1);
 
-// URLs GitHub
-const char* versionURL   = "https://raw.githubusercontent.com/sergio-isidoro/Wake-on-LAN_ESP32C3/main/firmware/version.txt";
-const char* firmwareURL  = "https://raw.githubusercontent.com/sergio-isidoro/Wake-on-LAN_ESP32C3/main/firmware/WOL_ESP32.bin";
+        if (st == TINFL_STATUS_DONE) g.done = true;   // trailer (CRC32, ISIZE) is ignored
+        else if (st < 0) return false;
+    } while (len || st == TINFL_STATUS_HAS_MORE_OUTPUT);
 
-#define OTA_BUF_SIZE 1024
+    return true;
+}
+
+static bool hexToBytes(const char* hex, uint8_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned int b;
+        if (sscanf(hex + i * 2, "%2x", &b) != 1) return false;
+        out[i] = (uint8_t)b;
+    }
+    return true;
+}
 
-// Direct OTA (without SPIFFS): download + flashing with percentage
-bool downloadAndFlashFirmware(const char* url) {
+// Small text file (version.txt, digest) into a String
+static bool httpGetText(const char* url, String &out) {
     WiFiClientSecure client;
     client.setInsecure();
     HTTPClient http;
-
     http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+
     if (!http.begin(client, url)) {
-        mqttPublish(("OTA: HTTP begin failed for " + String(url)).c_str());
+        logMsg(LOGL_ERROR, "OTA: HTTP begin failed for %s", url);
         return false;
     }
 
     int code = http.GET();
     if (code != HTTP_CODE_OK) {
-        mqttPublish(("OTA: HTTP GET failed, code " + String(code)).c_str());
+        logMsg(LOGL_ERROR, "OTA: HTTP GET failed for %s, code %d", url, code);
         http.end();
         return false;
     }
 
-    int contentLength = http.getSize();
-    if (contentLength <= 0) {
-        mqttPublish("OTA: Invalid content length");
+    out = http.getString();
+    out.trim();
+    http.end();
+    return true;
+}
+
+// Opens the image at 'offset'. Sets imageSize on the first call; 'skip' is
+// the number of leading bytes to discard when the server ignores Range.
+static OtaOpen openImage(HTTPClient &http, WiFiClientSecure &client, const char* url,
+                      size_t offset, size_t &imageSize, size_t &skip) {
+    client.setInsecure();
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    if (!http.begin(client, url)) return OTA_OPEN_RETRY;
+
+    const char* keys[] = { "Content-Range" };
+    http.collectHeaders(keys, 1);
+    if (offset) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%u-", (unsigned)offset);
+        http.addHeader("Range", range);
+    }
+
+    int code = http.GET();
+    size_t size = 0;
+    skip = 0;
+
+    if (code == HTTP_CODE_PARTIAL_CONTENT) {
+        const char* slash = strchr(http.header("Content-Range").c_str(), '/');
+        if (slash) size = strtoul(slash + 1, nullptr, 10);
+    } else if (code == HTTP_CODE_OK && http.getSize() > 0) {
+        size = http.getSize();
+        skip = offset;
+    } else if (code >= 400 && code < 500) {
+        logMsg(LOGL_WARN, "OTA: %s not available, code %d", url, code);
         http.end();
-        return false;
+        return OTA_OPEN_MISSING;
+    } else {
+        logMsg(LOGL_WARN, "OTA: HTTP GET failed, code %d", code);
+        http.end();
+        return OTA_OPEN_RETRY;
     }
 
-    mqttPublish(("OTA: Firmware size = " + String(contentLength) + " bytes").c_str());
+    if (size == 0) {
+        logMsg(LOGL_ERROR, "OTA: Unknown image size");
+        http.end();
+        return OTA_OPEN_RETRY;
+    }
+    if (imageSize == 0) {
+        imageSize = size;
+    } else if (size != imageSize) {
+        logMsg(LOGL_ERROR, "OTA: Image size changed during download");
+        http.end();
+        return OTA_OPEN_RETRY;
+    }
+    return OTA_OPEN_OK;
+}
 
-    // Prepare OTA partition
+// Direct OTA (without SPIFFS): download + flashing with percentage.
+// With gzip = true the stream is inflated on the fly; the digest is
+// always the one of the raw image that ends up in flash.
+bool downloadAndFlashFirmware(const char* url, const uint8_t* expectedSha, bool gzip) {
     const esp_partition_t* update_partition = esp_ota_get_next_update_partition(NULL);
     if (!update_partition) {
-        mqttPublish("OTA: No OTA partition found");
-        http.end();
+        logMsg(LOGL_ERROR, "OTA: No OTA partition found");
         return false;
     }
 
-    esp_ota_handle_t ota_handle;
-    if (esp_ota_begin(update_partition, contentLength, &ota_handle) != ESP_OK) {
-        mqttPublish("OTA: esp_ota_begin failed");
-        http.end();
+    OtaWriter w = {};
+    w.cur = -1;
+    if (esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &w.handle) != ESP_OK) {
+        logMsg(LOGL_ERROR, "OTA: esp_ota_begin failed");
         return false;
     }
 
-    WiFiClient* stream = http.getStreamPtr();
-    uint8_t buf[OTA_BUF_SIZE];
-    size_t total = 0;
+    uint8_t* net = (uint8_t*)malloc(OTA_BUF_SIZE);
+    GzInflater* gz = gzip ? (GzInflater*)calloc(1, sizeof(GzInflater)) : nullptr;
+    w.bufs[0] = (uint8_t*)malloc(OTA_BUF_SIZE);
+    w.bufs[1] = (uint8_t*)malloc(OTA_BUF_SIZE);
+    w.full = xQueueCreate(2, sizeof(int));
+    w.empty = xQueueCreate(2, sizeof(int));
+    w.done = xSemaphoreCreateBinary();
+    if (!net || (gzip && !gz) || !w.bufs[0] || !w.bufs[1] || !w.full || !w.empty || !w.done ||
+        xTaskCreate(otaWriterTask, "ota_write", OTA_WRITER_STACK, &w, 2, NULL) != pdPASS) {
+        logMsg(LOGL_ERROR, "OTA: Out of memory");
+        esp_ota_abort(w.handle);
+        free(net); free(gz);
+        free(w.bufs[0]); free(w.bufs[1]);
+        if (w.full) vQueueDelete(w.full);
+        if (w.empty) vQueueDelete(w.empty);
+        if (w.done) vSemaphoreDelete(w.done);
+        return false;
+    }
+    for (int i = 0; i < 2; i++) xQueueSend(w.empty, &i, 0);
+    if (gz) tinfl_init(&gz->inf);
+
+    mbedtls_sha256_init(&w.sha);
+    mbedtls_sha256_starts(&w.sha, 0);
+
+    size_t imageSize = 0;        // bytes to download (compressed when gzip)
+    size_t received = 0;
+    bool streamError = false;
+    bool missing = false;
+    int resumes = 0;
     int lastPercent = -1;
+    uint32_t lowHeap = ESP.getFreeHeap();
+    unsigned long t0 = millis();
 
-    // Ler stream HTTP e gravar direto na partição OTA
-    while (http.connected() && (total < (size_t)contentLength)) {
-        size_t avail = stream->available();
-        if (avail) {
-            int c = stream->readBytes(buf, min((size_t)OTA_BUF_SIZE, avail));
-            if (c > 0) {
-                if (esp_ota_write(ota_handle, buf, c) != ESP_OK) {
-                    mqttPublish("OTA: esp_ota_write failed");
-                    esp_ota_abort(ota_handle);
-                    http.end();
-                    return false;
-                }
-                total += c;
+    while (!w.failed && !streamError && (imageSize == 0 || received < imageSize)) {
+        WiFiClientSecure client;
+        HTTPClient http;
+        size_t skip;
+
+        OtaOpen open = openImage(http, client, url, received, imageSize, skip);
+        if (open == OTA_OPEN_MISSING) {
+            missing = true;
+            break;
+        }
+        if (open != OTA_OPEN_OK) {
+            if (++resumes > OTA_MAX_RESUMES) break;
+            delay(1000 * resumes);
+            continue;
+        }
+        if (received == 0) logMsg(LOGL_INFO, "OTA: Firmware size = %u bytes%s", (unsigned)imageSize, gzip ? " (gzip)" : "");
+        else logMsg(LOGL_WARN, "OTA: Resuming at %u bytes", (unsigned)received);
 
-                int percent = (total * 100) / contentLength;
-                if (percent != lastPercent && percent % 10 == 0) {
-                    lastPercent = percent;
-                    mqttPublish(("OTA: Download/Flashing progress " + String(percent) + "%").c_str());
+        WiFiClient* stream = http.getStreamPtr();
+        unsigned long lastData = millis();
+        bool dropped = false;
+
+        while (!w.failed && !streamError && received < imageSize) {
+            size_t avail = stream->available();
+            if (!avail) {
+                if (!http.connected() || millis() - lastData > OTA_STALL_MS) {
+                    dropped = true;
+                    break;
                 }
+                vTaskDelay(pdMS_TO_TICKS(2));    // lets the writer task flash meanwhile
+                continue;
+            }
+
+            int c = stream->read(net, min(avail, min((size_t)OTA_BUF_SIZE, imageSize - received + skip)));
+            if (c <= 0) continue;
+            lastData = millis();
+
+            const uint8_t* data = net;
+            if (skip) {                          // server ignored Range
+                size_t drop = min((size_t)c, skip);
+                skip -= drop;
+                data += drop;
+                c -= drop;
+            }
+            received += c;
+
+            if (gz) streamError = !gzFeed(*gz, data, c, w);
+            else sinkPut(w, data, c);
+
+            lowHeap = min(lowHeap, (uint32_t)ESP.getFreeHeap());
+            int percent = (received * 100) / imageSize;
+            if (percent != lastPercent && percent % 10 == 0) {
+                lastPercent = percent;
+                unsigned long ms = max(millis() - t0, 1UL);
+                logMsg(LOGL_INFO, "OTA: Download/Flashing progress %d%% (%lu KB/s)",
+                       percent, (unsigned long)((uint64_t)received * 1000 / ms / 1024));
             }
-        } else {
-            delay(1);
         }
+
+        http.end();
+        if (dropped && ++resumes > OTA_MAX_RESUMES) break;
     }
 
-    http.end();
+    sinkSubmit(w);
+    int stop = -1;
+    xQueueSend(w.full, &stop, portMAX_DELAY);
+    xSemaphoreTake(w.done, portMAX_DELAY);
+
+    bool inflated = !gz || gz->done;
+    free(net); free(gz);
+    free(w.bufs[0]); free(w.bufs[1]);
+    vQueueDelete(w.full);
+    vQueueDelete(w.empty);
+    vSemaphoreDelete(w.done);
 
-    if (esp_ota_end(ota_handle) != ESP_OK) {
-        mqttPublish("OTA: esp_ota_end failed.");
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&w.sha, digest);
+    mbedtls_sha256_free(&w.sha);
+
+    if (w.failed) {
+        logMsg(LOGL_ERROR, "OTA: esp_ota_write failed");
+        esp_ota_abort(w.handle);
+        return false;
+    }
+    if (streamError || !inflated) {
+        logMsg(LOGL_ERROR, "OTA: Corrupt gzip stream");
+        esp_ota_abort(w.handle);
+        return false;
+    }
+    if (missing || imageSize == 0 || received < imageSize) {
+        if (!missing) logMsg(LOGL_ERROR, "OTA: Download incomplete (%u of %u bytes)", (unsigned)received, (unsigned)imageSize);
+        esp_ota_abort(w.handle);
+        return false;
+    }
+    if (memcmp(digest, expectedSha, sizeof(digest)) != 0) {
+        logMsg(LOGL_ERROR, "OTA: SHA-256 mismatch, image rejected");
+        esp_ota_abort(w.handle);
+        return false;
+    }
+
+    if (esp_ota_end(w.handle) != ESP_OK) {
+        logMsg(LOGL_ERROR, "OTA: esp_ota_end failed.");
         return false;
     }
 
     if (esp_ota_set_boot_partition(update_partition) != ESP_OK) {
-        mqttPublish("OTA: Failed to set boot partition");
+        logMsg(LOGL_ERROR, "OTA: Failed to set boot partition");
         return false;
     }
 
+    logMsg(LOGL_INFO, "OTA: %u bytes downloaded, %u flashed in %lu ms, lowest free heap %lu, SHA-256 OK",
+           (unsigned)received, (unsigned)w.written, millis() - t0, (unsigned long)lowHeap);
     mqttPublish("OTA: Update successful, restarting...");
-    delay(1000);
-    ESP.restart();
+    otaRestart = true;       // otaPoll() flushes the log and restarts
     return true;
 }
 
+// Compares dotted numeric versions; missing parts count as 0.
+// Returns <0, 0 or >0 like strcmp.
+static int compareVersions(const char* a, const char* b) {
+    while (*a || *b) {
+        long x = atol(a);
+        long y = atol(b);
+        if (x != y) return x < y ? -1 : 1;
+        a += strcspn(a, ".");
+        b += strcspn(b, ".");
+        if (*a) a++;
+        if (*b) b++;
+    }
+    return 0;
+}
+
+// version.txt with a conditional GET; on 304 the version seen last time
+static bool fetchRemoteVersion(String &ver) {
+    Preferences prefs;
+    prefs.begin("ota", false);
+    String etag = prefs.getString("etag");
+
+    WiFiClientSecure client;
+    client.setInsecure();
+    HTTPClient http;
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    const char* keys[] = { "ETag" };
+
+    bool ok = false;
+    if (http.begin(client, versionURL)) {
+        http.collectHeaders(keys, 1);
+        if (etag.length()) http.addHeader("If-None-Match", etag);
+
+        int code = http.GET();
+        if (code == HTTP_CODE_NOT_MODIFIED) {
+            ver = prefs.getString("ver");
+            ok = ver.length() > 0;
+            logMsg(LOGL_DEBUG, "OTA: version.txt not modified");
+        } else if (code == HTTP_CODE_OK) {
+            ver = http.getString();
+            ver.trim();
+            prefs.putString("etag", http.header("ETag"));
+            prefs.putString("ver", ver);
+            ok = true;
+        } else {
+            logMsg(LOGL_ERROR, "OTA: HTTP GET failed for %s, code %d", versionURL, code);
+        }
+        http.end();
+    }
+    prefs.end();
+    return ok;
+}
+
 // Main OTA function
 void performOTA() {
     mqttPublish("OTA: Checking for updates...");
 
     // 1. Fetch remote version
     String remoteVer;
-    {
-        WiFiClientSecure clientVer;
-        clientVer.setInsecure();
-        HTTPClient httpVer;
-        httpVer.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-
-        if (!httpVer.begin(clientVer, versionURL)) {
-            mqttPublish("OTA: Failed to connect to version URL");
-            return;
-        }
-
-        int code = httpVer.GET();
-        if (code == HTTP_CODE_OK) {
-            remoteVer = httpVer.getString();
-            remoteVer.trim();
-        } else {
-            mqttPublish(("OTA: Failed to get version.txt, code " + String(code)).c_str());
-            httpVer.end();
-            return;
-        }
-        httpVer.end();
-    }
+    if (!fetchRemoteVersion(remoteVer)) return;
 
-    if (remoteVer == FIRMWARE_VERSION) {
+    if (compareVersions(remoteVer.c_str(), FIRMWARE_VERSION) <= 0) {
         mqttPublish("OTA: Already up to date.");
         return;
     }
 
-    mqttPublish(("OTA: New version available: " + remoteVer).c_str());
+    logMsg(LOGL_INFO, "OTA: New version available: %s", remoteVer.c_str());
+
+    // 2. Published digest of the image
+    String digestHex;
+    uint8_t digest[32];
+    if (!httpGetText(digestURL, digestHex) || digestHex.length() < 64 || !hexToBytes(digestHex.c_str(), digest, 32)) {
+        logMsg(LOGL_ERROR, "OTA: No valid SHA-256 digest published, update skipped");
+        return;
+    }
 
-    // 2. Download + Direct OTA
-    if (!downloadAndFlashFirmware(firmwareURL)) {
-        mqttPublish("OTA: Firmware update failed");
+    // 3. Download + Direct OTA, compressed image first
+    if (!downloadAndFlashFirmware(firmwareGzURL, digest, true) &&
+        !downloadAndFlashFirmware(firmwareURL, digest, false)) {
+        logMsg(LOGL_ERROR, "OTA: Firmware update failed");
         return;
     }
 }
+
+static void otaTask(void*) {
+    unsigned long t0 = millis();
+    metricInc(CNT_OTA_CHECKS);
+    performOTA();
+    metricObserve(HIST_OTA_CHECK_MS, millis() - t0);
+    otaRunning = false;
+    vTaskDelete(NULL);
+}
+
+// Runs on the loop task: decides when to check, owns the restart
+static void otaPoll() {
+    if (otaRestart) {
+        logFlush();
+        delay(1000);
+        ESP.restart();
+    }
+    if (otaRunning || !wifiConnected()) return;
+
+    if (millis() - lastOTACheck > OTA_CHECK_INTERVAL_MS || chkUpdate) {
+        lastOTACheck = millis();
+        chkUpdate = false;
+        otaRunning = true;
+        if (!taskStart(otaTask, "ota", OTA_TASK_STACK, TASK_PRIO_OTA, TASK_CORE_NET)) {
+            logMsg(LOGL_ERROR, "OTA: Could not start update task");
+            otaRunning = false;
+        }
+    }
+}
+
+static void otaFirstCheck() {
+    chkUpdate = true;
+}
+
+void otaBegin() {
+    lastOTACheck = millis();
+    schedulerEvery(OTA_POLL_MS, otaPoll);
+    schedulerAfter(OTA_FIRST_CHECK_MS, otaFirstCheck);
+}
+
+bool otaBusy() {
+    return otaRunning;
+}
@@ -4,9 +4,20 @@
  * Declares the OTA update function.
  * This module handles checking GitHub for a new firmware version
  * and flashing it directly to the OTA partition.
+ *  - otaBegin() schedules the checks; each one runs in a background
+ *    task, the first OTA_FIRST_CHECK_MS after boot
  */
  
 #pragma once
 #include <Arduino.h>
 
+#define OTA_POLL_MS         1000
+#define OTA_FIRST_CHECK_MS  30000UL   // let MQTT and commands come up first
+
+// Fetch the update from a local server instead of GitHub, e.g.
+// Tools/ota_fault_server.py to test resuming (any certificate is accepted)
+// #define OTA_BASE_URL "https://192.168.1.10:8443/"
+
+void otaBegin();
+bool otaBusy();
 void performOTA();
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""
+embed_assets.py
+-------------------------------
+Embeds the portal page in the firmware
+ - setup.html is gzipped (-9, mtime 0, so the output is reproducible)
+ - Writes ../portal_assets.h with the bytes as a constexpr array,
+   the raw/gzip sizes and a strong ETag (SHA-256 prefix)
+Run after every change to setup.html:  python3 portal/embed_assets.py
+"""
+import gzip
+import hashlib
+import io
+import os
+
+here = os.path.dirname(os.path.abspath(__file__))
+src = os.path.join(here, "setup.html")
+dst = os.path.join(here, "..", "portal_assets.h")
+
+with open(src, "rb") as f:
+    raw = f.read()
+
+buf = io.BytesIO()
+with gzip.GzipFile(filename="", mode="wb", compresslevel=9, fileobj=buf, mtime=0) as gz:
+    gz.write(raw)
+packed = buf.getvalue()
+etag = hashlib.sha256(raw).hexdigest()[:16]
+
+rows = []
+for i in range(0, len(packed), 16):
+    rows.append("  " + ", ".join("0x%02X" % b for b in packed[i:i + 16]) + ",")
+
+with open(dst, "w") as f:
+    f.write("""/*
+ * portal_assets.h
+ * -------------------------------
+ * Generated by portal/embed_assets.py from portal/setup.html,
+ * do not edit by hand.
+ *  - setupHtmlGz: gzip of the page, served as-is
+ *    (Content-Encoding: gzip)
+ *  - setupHtmlEtag changes whenever the page does
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+constexpr size_t  setupHtmlRawLen = %d;
+constexpr char    setupHtmlEtag[] = "\\"%s\\"";
+constexpr uint8_t setupHtmlGz[] = {
+%s
+};
+""" % (len(raw), etag, "\n".join(rows)))
+
+print(f"setup.html: {len(raw)} bytes -> {len(packed)} bytes gzip ({100.0 * len(packed) / len(raw):.1f}%), ETag {etag}")
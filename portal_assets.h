@@ -0,0 +1,177 @@
+/*
+ * portal_assets.h
+ * -------------------------------
+ * Generated by portal/embed_assets.py from portal/setup.html,
+ * do not edit by hand.
+ *  - setupHtmlGz: gzip of the page, served as-is
+ *    (Content-Encoding: gzip)
+ *  - setupHtmlEtag changes whenever the page does
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+constexpr size_t  setupHtmlRawLen = 7845;
+constexpr char    setupHtmlEtag[] = "\"dac71698a56bc3b6\"";
+constexpr uint8_t setupHtmlGz[] = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xFF, 0xC5, 0x59, 0xEB, 0x72, 0xDB, 0xB8,
+  0x15, 0xFE, 0xDF, 0x99, 0xBE, 0xC3, 0x09, 0x77, 0x9A, 0x25, 0x37, 0x12, 0x75, 0xF1, 0x25, 0x0E,
+  0x25, 0x7B, 0xEB, 0x5B, 0x5A, 0xB7, 0xD9, 0x58, 0x8D, 0x9C, 0x49, 0x3A, 0x99, 0x8C, 0x07, 0x22,
+  0x41, 0x09, 0x16, 0x45, 0x70, 0x01, 0xD0, 0xB6, 0x92, 0xCD, 0x03, 0xF5, 0x39, 0xFA, 0x62, 0x3D,
+  0x00, 0x2F, 0x22, 0x29, 0xD9, 0x2B, 0xB7, 0xDB, 0xD9, 0xF1, 0xD8, 0xA2, 0x00, 0x9C, 0xDB, 0x77,
+  0xAE, 0xA0, 0x87, 0xCF, 0xCE, 0x2E, 0x4F, 0xAF, 0xFE, 0x39, 0x3A, 0x87, 0x99, 0x5A, 0x44, 0x47,
+  0x7F, 0xFC, 0xC3, 0xB0, 0xFC, 0xA4, 0x24, 0xC0, 0x4F, 0x80, 0xE1, 0x82, 0x2A, 0x02, 0xFE, 0x8C,
+  0x08, 0x49, 0xD5, 0xA1, 0xF5, 0xFE, 0xEA, 0x75, 0xFB, 0xC0, 0xCA, 0x76, 0x14, 0x53, 0x11, 0x3D,
+  0xFA, 0x70, 0xF9, 0x06, 0xCE, 0xC7, 0xA3, 0x9D, 0xFE, 0xE9, 0x0E, 0x8C, 0xA9, 0x4A, 0x93, 0x61,
+  0x27, 0xDB, 0x30, 0x67, 0xA4, 0x5A, 0xE6, 0x8F, 0x00, 0x13, 0x1E, 0x2C, 0xE1, 0x6B, 0xF6, 0x0C,
+  0x10, 0xF2, 0x58, 0xB5, 0x43, 0xB2, 0x60, 0xD1, 0xD2, 0x83, 0x63, 0xC1, 0x48, 0xD4, 0x02, 0x49,
+  0x62, 0xD9, 0x96, 0x54, 0xB0, 0x70, 0x50, 0x1C, 0x5B, 0x90, 0xFB, 0xF6, 0x1D, 0x0B, 0xD4, 0xCC,
+  0x83, 0xDD, 0x7E, 0x37, 0xB9, 0xAF, 0x6C, 0x88, 0x29, 0x8B, 0x3D, 0x20, 0xA9, 0xE2, 0xE5, 0xE2,
+  0x84, 0xF8, 0xF3, 0xA9, 0xE0, 0x69, 0x1C, 0xB4, 0x7D, 0x1E, 0x71, 0xE1, 0xC1, 0x77, 0x3D, 0xAA,
+  0x7F, 0x06, 0xD0, 0xF9, 0x01, 0x7C, 0x16, 0x7F, 0x21, 0xF0, 0x73, 0x4A, 0x24, 0x85, 0x44, 0x50,
+  0xC5, 0xE1, 0x87, 0x4E, 0x41, 0x59, 0x1C, 0x0F, 0xBB, 0xFA, 0xA7, 0x64, 0x98, 0x90, 0x20, 0x60,
+  0xF1, 0xD4, 0x83, 0x9A, 0xEC, 0x09, 0x17, 0x01, 0x15, 0x6D, 0x41, 0x02, 0x96, 0x4A, 0x0F, 0x7A,
+  0xFD, 0x72, 0xEF, 0x5B, 0xF6, 0xC1, 0xE2, 0x24, 0x55, 0x9F, 0xD4, 0x32, 0xA1, 0x87, 0x96, 0xA2,
+  0xF7, 0xCA, 0xFA, 0xDC, 0xAA, 0xAD, 0x25, 0x44, 0xCA, 0x3B, 0x64, 0xD2, 0x5C, 0x8F, 0xD3, 0xC5,
+  0x84, 0x0A, 0xBD, 0x2A, 0x69, 0x44, 0x7D, 0xB5, 0x82, 0x2B, 0xC7, 0xA0, 0xD7, 0xED, 0xFE, 0x69,
+  0x5D, 0xB9, 0xDE, 0x26, 0x60, 0xF6, 0x93, 0x7B, 0xE8, 0x56, 0x54, 0xBE, 0x6F, 0x4B, 0xF6, 0xC5,
+  0x1C, 0xCF, 0xD5, 0xC7, 0xA5, 0x86, 0x45, 0xC8, 0x09, 0x89, 0x24, 0x8F, 0x58, 0x00, 0xDF, 0xED,
+  0xEE, 0xEE, 0x3E, 0x64, 0xF0, 0x7E, 0x15, 0x8B, 0x75, 0xC8, 0xFB, 0x44, 0xFF, 0x0C, 0x1E, 0x85,
+  0xF6, 0x41, 0xA0, 0xBC, 0x90, 0xFB, 0xA9, 0x7C, 0x08, 0xAE, 0x4D, 0xBB, 0x05, 0x68, 0xD9, 0xDE,
+  0x0A, 0x32, 0x9E, 0xAA, 0x88, 0xC5, 0xD4, 0x83, 0x98, 0xC7, 0xB4, 0x69, 0x4A, 0xA1, 0x54, 0xB7,
+  0x3B, 0xF1, 0x83, 0xDD, 0xC7, 0xAC, 0xD9, 0xD9, 0xD9, 0xA9, 0xEB, 0xEC, 0x16, 0xEA, 0xB4, 0x43,
+  0x46, 0xA3, 0x60, 0x25, 0x30, 0x60, 0x32, 0x89, 0x08, 0x86, 0x73, 0x18, 0xD1, 0xFB, 0x01, 0x90,
+  0x88, 0x4D, 0xE3, 0x36, 0x53, 0x74, 0x81, 0x90, 0xF9, 0x34, 0x56, 0x54, 0x0C, 0x60, 0x4A, 0x12,
+  0x0F, 0x0E, 0x9A, 0xF1, 0xD2, 0x64, 0x19, 0x91, 0x09, 0x8D, 0xFE, 0x0B, 0xC6, 0xBB, 0x15, 0xC7,
+  0x98, 0x04, 0xBB, 0xA3, 0x6C, 0x3A, 0x53, 0x1A, 0x02, 0xB1, 0x20, 0x51, 0xB9, 0x77, 0x37, 0x43,
+  0xEA, 0xB6, 0x4C, 0x88, 0x6F, 0xE0, 0xB9, 0x13, 0x24, 0xA9, 0xD3, 0x61, 0xA8, 0xE0, 0x4E, 0xD7,
+  0x7D, 0x45, 0x17, 0x75, 0x4D, 0x27, 0xA9, 0x52, 0x3C, 0xDE, 0x36, 0x2E, 0xFB, 0x6B, 0x71, 0xD9,
+  0x56, 0x3C, 0x69, 0x6C, 0x14, 0xB1, 0xB7, 0xC9, 0x4D, 0x5B, 0x46, 0x5C, 0xC3, 0x8B, 0x65, 0xC4,
+  0x85, 0xE1, 0x26, 0xB3, 0x7A, 0xA5, 0x51, 0x78, 0x34, 0x15, 0x52, 0x9F, 0x4D, 0x38, 0x33, 0x38,
+  0x6E, 0x30, 0xD6, 0x9B, 0xF1, 0x5B, 0x2A, 0x56, 0x26, 0x6F, 0x94, 0xFF, 0xEA, 0x25, 0x79, 0x59,
+  0x27, 0x9E, 0xF5, 0x57, 0x24, 0x3A, 0xB4, 0xDB, 0xC6, 0x6D, 0xA5, 0xC3, 0x1A, 0xB0, 0x4C, 0x38,
+  0x8A, 0x5A, 0xD4, 0xEA, 0x4C, 0xCE, 0xA7, 0x11, 0x0B, 0x35, 0xB7, 0x4E, 0x78, 0x14, 0x0C, 0xD6,
+  0xA2, 0x64, 0x12, 0x71, 0x7F, 0xBE, 0x19, 0xF7, 0x35, 0xEE, 0x21, 0xE7, 0xAA, 0x6A, 0xDC, 0xAF,
+  0x6B, 0x6A, 0x18, 0xF5, 0xF7, 0x9A, 0x91, 0x56, 0x44, 0xCC, 0xC1, 0x5E, 0x15, 0xDD, 0x1C, 0x9F,
+  0xC9, 0x64, 0x52, 0x17, 0xFB, 0xE7, 0x05, 0x0D, 0x18, 0x01, 0xBB, 0x5A, 0xDE, 0x0F, 0x50, 0x39,
+  0xA7, 0x02, 0xB3, 0x69, 0x17, 0x8D, 0x22, 0x57, 0xD0, 0x9B, 0x8F, 0x61, 0xA7, 0x68, 0x2F, 0xC3,
+  0x4E, 0xDE, 0xB0, 0x86, 0x9A, 0x2A, 0x6B, 0x3D, 0xB3, 0xFE, 0x7A, 0x6F, 0x82, 0x53, 0x1E, 0x87,
+  0x6C, 0x9A, 0x0A, 0xA2, 0x18, 0x8F, 0x91, 0xAA, 0x9F, 0x9D, 0x0D, 0x31, 0x3D, 0x80, 0x05, 0x87,
+  0x96, 0x1F, 0x4E, 0x2D, 0x20, 0xBE, 0xDE, 0x3D, 0xB4, 0x3A, 0x92, 0xDC, 0x52, 0x0B, 0xB0, 0x03,
+  0xCE, 0x38, 0xEE, 0x25, 0x5C, 0x2A, 0x2B, 0xEF, 0x65, 0xD9, 0xDF, 0xA1, 0xF1, 0xCD, 0xD1, 0x07,
+  0xF6, 0x9A, 0xC1, 0x78, 0x7C, 0x71, 0xE6, 0x0D, 0x3B, 0xD9, 0x4A, 0xBE, 0x6D, 0xAA, 0x14, 0x54,
+  0xAA, 0x1B, 0xC4, 0x64, 0x81, 0xCF, 0x52, 0xB2, 0xC0, 0x02, 0x74, 0x96, 0x4F, 0x67, 0xE8, 0x41,
+  0x2A, 0x0E, 0x2D, 0xC3, 0xE3, 0x2D, 0xEE, 0x5A, 0xA6, 0xA3, 0xF9, 0x7C, 0x91, 0x44, 0x54, 0xE1,
+  0xD9, 0x14, 0xFB, 0xA1, 0xA6, 0xD2, 0x92, 0xD7, 0xA5, 0x8E, 0xF2, 0xBA, 0xD1, 0x94, 0x1C, 0xB0,
+  0x5B, 0xF0, 0x23, 0xDC, 0x5C, 0x15, 0xCF, 0xAC, 0xB4, 0x14, 0x06, 0x34, 0xB4, 0x2B, 0x2B, 0xAC,
+  0x41, 0xE1, 0x8E, 0x85, 0xEC, 0x5A, 0x2F, 0x15, 0x0A, 0xAF, 0xB6, 0x6B, 0x4A, 0xA7, 0x31, 0x0E,
+  0x06, 0xF1, 0x94, 0x06, 0x4D, 0xA5, 0x31, 0xAB, 0x04, 0x06, 0x4F, 0xBB, 0xA4, 0x5B, 0x49, 0xCD,
+  0xD4, 0xAC, 0x09, 0xF7, 0x67, 0xD4, 0x9F, 0x63, 0x37, 0xB2, 0x80, 0xC7, 0x7E, 0xC4, 0xFC, 0x39,
+  0xA2, 0xC5, 0xA7, 0xD3, 0x88, 0x16, 0xD6, 0xD9, 0xDF, 0x97, 0x1A, 0x7D, 0xEF, 0x58, 0x47, 0x30,
+  0x9E, 0xF1, 0xBB, 0x86, 0xC1, 0x1D, 0xB4, 0xB8, 0x89, 0xD0, 0x4F, 0xFF, 0xB8, 0xBA, 0x42, 0xBF,
+  0x0B, 0xCC, 0xDE, 0x6D, 0x3D, 0xB3, 0xF8, 0x59, 0xA9, 0x6B, 0x69, 0x48, 0x1A, 0xB6, 0x4E, 0x04,
+  0x9F, 0x53, 0xE1, 0xD2, 0x7B, 0xA2, 0x8D, 0x74, 0xD1, 0xD6, 0x35, 0x4F, 0x89, 0xC8, 0xDA, 0xA8,
+  0xC2, 0x88, 0x0B, 0xF5, 0x98, 0x02, 0x79, 0x03, 0xAB, 0xAA, 0x90, 0x20, 0x89, 0x05, 0xB7, 0x24,
+  0x4A, 0x71, 0xE5, 0xE0, 0xE0, 0x60, 0x07, 0xC3, 0x90, 0x61, 0x48, 0xF6, 0x2C, 0x3D, 0x11, 0x1D,
+  0x5A, 0xFB, 0x7B, 0x7B, 0x3B, 0x7B, 0x9B, 0xA5, 0xBD, 0x97, 0x4F, 0x34, 0x57, 0x47, 0x58, 0xC3,
+  0xD8, 0x92, 0xD1, 0xD6, 0xD1, 0x98, 0x19, 0xFA, 0x7F, 0x89, 0xC6, 0x0C, 0x90, 0x4A, 0x34, 0x96,
+  0x0B, 0xBF, 0x6B, 0x48, 0x96, 0x5A, 0x3C, 0x25, 0x24, 0xAF, 0xB0, 0x86, 0x52, 0x05, 0x17, 0xA3,
+  0x6D, 0x3D, 0xA4, 0x0C, 0xC1, 0x35, 0x4B, 0x1A, 0x76, 0xF6, 0x5E, 0xF5, 0xDD, 0xDE, 0xFE, 0x81,
+  0xFB, 0xF1, 0xE3, 0x47, 0xFD, 0xDB, 0xB4, 0x96, 0x87, 0xE1, 0x9A, 0x8B, 0x4E, 0x04, 0x27, 0x81,
+  0x4F, 0xE4, 0x53, 0xC4, 0x4F, 0x0A, 0x9A, 0x8B, 0x51, 0x43, 0x01, 0x2D, 0x0F, 0xEC, 0x50, 0xF0,
+  0x05, 0xC4, 0x54, 0x2D, 0x88, 0x9C, 0x3B, 0xDB, 0x28, 0xF1, 0xFE, 0x6C, 0xF4, 0xC4, 0x7C, 0x48,
+  0x83, 0xA4, 0x9E, 0x0E, 0xAF, 0xB6, 0xCB, 0x85, 0xE3, 0x53, 0x38, 0x0E, 0x02, 0x41, 0xA5, 0xDC,
+  0x3A, 0x1B, 0x88, 0x7F, 0x4D, 0x32, 0x92, 0x86, 0xB1, 0xC7, 0xC7, 0xDE, 0xC9, 0x89, 0x77, 0x7A,
+  0xEA, 0x9D, 0x9D, 0x79, 0xE7, 0xE7, 0xDE, 0xEB, 0xD7, 0xDB, 0x98, 0x3A, 0xA6, 0x71, 0x00, 0x3F,
+  0xF1, 0x80, 0x36, 0xE5, 0xE7, 0xB3, 0x7D, 0xEE, 0xE0, 0xFB, 0xEB, 0x05, 0x9E, 0xA9, 0x84, 0x23,
+  0x4F, 0x74, 0xFB, 0x29, 0xAC, 0xC5, 0xC1, 0x60, 0x66, 0x61, 0xB1, 0x6F, 0x63, 0xB5, 0x7F, 0x01,
+  0x6F, 0x8E, 0xDF, 0x82, 0x3D, 0x1E, 0x5D, 0x38, 0xC3, 0x4E, 0x76, 0xEC, 0x21, 0xB2, 0x90, 0xB0,
+  0x48, 0x8F, 0x2D, 0xD6, 0x51, 0x49, 0xD2, 0x82, 0x8C, 0x0B, 0x0B, 0x01, 0xE7, 0xE2, 0x39, 0x04,
+  0xFC, 0x2E, 0x6E, 0xB0, 0xC1, 0x8E, 0x6A, 0x74, 0x6B, 0x9A, 0x32, 0xC2, 0x91, 0x07, 0xC3, 0xF6,
+  0x2F, 0x24, 0xC1, 0x96, 0x2D, 0x9D, 0xED, 0x9D, 0x87, 0xD6, 0xE1, 0x60, 0x7A, 0xBD, 0x90, 0xA5,
+  0xF7, 0xF6, 0x1A, 0xDE, 0xC3, 0xC9, 0xB1, 0xBB, 0x06, 0xDD, 0xD5, 0x29, 0x46, 0x89, 0xE0, 0x13,
+  0x6A, 0x62, 0x05, 0xEC, 0x2E, 0x1C, 0x42, 0x82, 0x53, 0x00, 0x66, 0x63, 0xB4, 0x7C, 0x82, 0xF8,
+  0x44, 0xF3, 0xA8, 0x47, 0x4F, 0x37, 0x97, 0xDF, 0x7D, 0x34, 0x7A, 0x3E, 0x90, 0x39, 0x85, 0x33,
+  0x9C, 0x29, 0xF4, 0x0D, 0x02, 0xEC, 0xA7, 0x98, 0x7C, 0x87, 0xA4, 0xD7, 0x41, 0x4E, 0x7A, 0xBD,
+  0x32, 0xBC, 0x77, 0x50, 0x88, 0xEE, 0x15, 0xB2, 0x77, 0xF6, 0x37, 0xD8, 0xAE, 0x87, 0x96, 0x77,
+  0x54, 0x09, 0x46, 0xE5, 0x13, 0x85, 0x8A, 0x8C, 0xAA, 0x94, 0xD8, 0x6F, 0x98, 0xDA, 0xDB, 0x20,
+  0xCC, 0x44, 0xC4, 0x65, 0xAA, 0xC8, 0x94, 0xC2, 0x09, 0xC5, 0x39, 0x88, 0xE6, 0x93, 0xD2, 0xF1,
+  0x08, 0xCD, 0x6E, 0x81, 0x46, 0x3E, 0xA6, 0x18, 0x48, 0x4F, 0x41, 0x40, 0x37, 0x6B, 0xF4, 0x3A,
+  0x09, 0x71, 0x7C, 0xAC, 0x22, 0xD0, 0x6F, 0x82, 0x7F, 0xB0, 0xBF, 0xBB, 0x01, 0x81, 0xD7, 0xBA,
+  0x46, 0xBD, 0xA3, 0x3E, 0x8F, 0x63, 0x9D, 0x27, 0xEB, 0xD5, 0xAA, 0x96, 0x40, 0x46, 0x9A, 0xA0,
+  0xD8, 0x99, 0x74, 0x95, 0x7C, 0x28, 0x1F, 0x50, 0xCA, 0xD9, 0x5F, 0x31, 0xAA, 0xB4, 0x29, 0x4B,
+  0x50, 0x6C, 0x41, 0x7F, 0x2D, 0x83, 0x7A, 0xD6, 0xD1, 0x3B, 0xCD, 0x15, 0x07, 0x70, 0x54, 0xC7,
+  0x10, 0x47, 0x94, 0x48, 0xBA, 0x65, 0xCA, 0x64, 0x6E, 0xC4, 0x79, 0x1C, 0xEC, 0x0C, 0xE4, 0xE7,
+  0x91, 0x1A, 0xB4, 0x9F, 0x4F, 0xD5, 0x40, 0x27, 0x71, 0x0B, 0x74, 0x21, 0x7C, 0xD9, 0x79, 0xE5,
+  0x3C, 0x6E, 0x1B, 0x8F, 0xD0, 0x34, 0x64, 0xF2, 0x98, 0x5D, 0x97, 0x61, 0xB8, 0x95, 0x2D, 0x5A,
+  0x17, 0xBC, 0x40, 0x62, 0x1E, 0xCF, 0x70, 0x92, 0x95, 0x5B, 0xDA, 0xF1, 0x86, 0xFB, 0x24, 0xC2,
+  0x68, 0xB8, 0x80, 0x2B, 0x1C, 0x80, 0xE2, 0xDF, 0xB6, 0xB5, 0x93, 0x84, 0x5D, 0x2B, 0xCD, 0xB6,
+  0x08, 0x9D, 0xCA, 0xC2, 0x43, 0x6D, 0x1D, 0x03, 0x27, 0xA2, 0xF1, 0x54, 0xCD, 0x30, 0x7F, 0xFA,
+  0x0F, 0xD4, 0xE1, 0xFF, 0xA9, 0xB1, 0x97, 0x3A, 0x3C, 0xA5, 0xB1, 0x8F, 0x67, 0xA9, 0xD2, 0x05,
+  0x15, 0x8E, 0xA7, 0x38, 0x65, 0xC0, 0xDF, 0x29, 0xFA, 0x9D, 0x2E, 0x12, 0xB5, 0xC4, 0xFC, 0x89,
+  0xE8, 0x94, 0xF8, 0x4B, 0xBC, 0xC9, 0xE8, 0x22, 0xEA, 0xFC, 0xC6, 0x08, 0x6A, 0x71, 0xD7, 0x73,
+  0xBA, 0x2C, 0x11, 0x5C, 0x2D, 0xFC, 0x7E, 0x08, 0x16, 0x3A, 0x6C, 0x87, 0x60, 0xFE, 0x4E, 0x21,
+  0x63, 0x2F, 0xD3, 0xC9, 0x82, 0xE1, 0x3D, 0x6B, 0x8C, 0x77, 0xAF, 0x61, 0x27, 0xDB, 0x2A, 0xC8,
+  0x12, 0x63, 0xB2, 0x54, 0x44, 0xA5, 0xD2, 0x3A, 0x1A, 0x76, 0x92, 0xEC, 0xF6, 0xD6, 0xD1, 0xD7,
+  0xB7, 0x9C, 0xDD, 0x30, 0xBB, 0xD0, 0xE6, 0x14, 0xA7, 0x82, 0x12, 0x45, 0x03, 0x98, 0x2C, 0x31,
+  0xB1, 0x12, 0x12, 0x83, 0xB9, 0x30, 0x62, 0x77, 0x34, 0x37, 0x56, 0xFD, 0xEC, 0x01, 0x53, 0x78,
+  0xDD, 0xF5, 0x07, 0xF9, 0x5D, 0xD5, 0x5C, 0x55, 0x51, 0xFA, 0xBF, 0xFF, 0x85, 0x97, 0x5D, 0x0E,
+  0x17, 0x78, 0x53, 0xE3, 0x82, 0x63, 0x72, 0x20, 0x75, 0x29, 0x2D, 0x97, 0x90, 0xBD, 0xE1, 0xF4,
+  0x05, 0x4B, 0x54, 0x2E, 0x2F, 0x44, 0x94, 0x4D, 0xDE, 0x35, 0x10, 0x61, 0x41, 0xE5, 0x62, 0x7B,
+  0x4B, 0x04, 0xDC, 0x63, 0x58, 0x04, 0xDC, 0x4F, 0x17, 0x08, 0x94, 0x8B, 0x03, 0xDE, 0x79, 0x44,
+  0xF5, 0xE3, 0xC9, 0xF2, 0xC2, 0x1C, 0x2E, 0x2F, 0xD0, 0xF7, 0xAE, 0x46, 0x05, 0x0F, 0xDB, 0xC5,
+  0xD3, 0xE1, 0x21, 0xAC, 0x42, 0xC0, 0x81, 0x1F, 0x21, 0x1F, 0x61, 0xBC, 0xCA, 0xF2, 0xEA, 0xAE,
+  0x9D, 0x3D, 0x68, 0x89, 0xE6, 0x8A, 0xFB, 0xB0, 0x50, 0x73, 0xF3, 0x2D, 0xE4, 0xEA, 0xF3, 0x19,
+  0xCA, 0x8F, 0x51, 0xE4, 0x7E, 0xA8, 0x12, 0x61, 0x1F, 0xA0, 0x82, 0xF9, 0x48, 0xF5, 0xA9, 0x72,
+  0x8F, 0x69, 0xC1, 0x6A, 0x88, 0xC3, 0xE7, 0xD5, 0x4C, 0x80, 0x5F, 0x2A, 0x1D, 0x1A, 0xBF, 0x35,
+  0x7B, 0x67, 0xB1, 0x54, 0x74, 0x36, 0xFD, 0xBD, 0xD1, 0x5C, 0x8A, 0xA5, 0xB2, 0x03, 0xE8, 0x85,
+  0xB2, 0x6C, 0x7E, 0x1E, 0x14, 0x18, 0x74, 0x3A, 0x70, 0x11, 0xC3, 0xF8, 0xEA, 0x18, 0xF4, 0xB8,
+  0x05, 0x6A, 0x46, 0x21, 0xA0, 0xB7, 0xCC, 0xA7, 0x70, 0x47, 0x62, 0x25, 0x31, 0x0C, 0xA4, 0xA9,
+  0x72, 0x26, 0xF3, 0xC1, 0xC6, 0x79, 0x16, 0xE3, 0x06, 0x23, 0x9C, 0xB6, 0x60, 0x4E, 0x13, 0x05,
+  0x2C, 0x36, 0x34, 0x38, 0x10, 0xDF, 0xE1, 0x1D, 0xC8, 0x69, 0xF8, 0x1B, 0x6B, 0x86, 0x8D, 0xF7,
+  0xBF, 0x16, 0x60, 0x4D, 0x95, 0x15, 0x5F, 0xEB, 0xAF, 0x88, 0x86, 0xF9, 0xF8, 0xE5, 0x17, 0xF8,
+  0xFA, 0x6D, 0x50, 0xDD, 0x71, 0xF5, 0x5B, 0x0B, 0x2A, 0x8A, 0x13, 0xE5, 0xD7, 0xFA, 0x49, 0x0D,
+  0x6C, 0xA6, 0x15, 0x96, 0x12, 0x5D, 0x8D, 0xC7, 0x8A, 0x0B, 0x4C, 0x31, 0xED, 0x90, 0x0B, 0x45,
+  0x17, 0xB6, 0xB1, 0x37, 0xAB, 0x9A, 0xAB, 0xC8, 0xC1, 0x29, 0xCF, 0x36, 0x6B, 0x4E, 0x8D, 0xF7,
+  0x27, 0xEB, 0x38, 0x55, 0x33, 0x2E, 0xD8, 0x17, 0xF3, 0x0A, 0xC4, 0xFA, 0x8C, 0x4C, 0xAD, 0x13,
+  0x4A, 0x04, 0x15, 0x60, 0xE1, 0x80, 0x69, 0x48, 0x4A, 0x26, 0x88, 0x7B, 0x2A, 0x62, 0x08, 0xA9,
+  0xF2, 0x67, 0x15, 0xFB, 0x5C, 0x44, 0x22, 0xB6, 0x4B, 0xE3, 0x6D, 0x51, 0xB1, 0x38, 0x93, 0x2C,
+  0xDC, 0x3C, 0x7E, 0x9E, 0x61, 0xBC, 0xEE, 0x76, 0x7B, 0x4E, 0xC1, 0x6A, 0xF5, 0x3A, 0x09, 0x4A,
+  0xA3, 0x30, 0x06, 0xB0, 0x52, 0xDA, 0xD6, 0xAA, 0xD5, 0x98, 0x1D, 0xAF, 0x62, 0x4D, 0xC6, 0xF5,
+  0x59, 0x6E, 0xD0, 0x06, 0x5E, 0x35, 0x60, 0xE4, 0x3A, 0x30, 0xAD, 0x8C, 0x67, 0x95, 0x63, 0xCE,
+  0xA5, 0xEE, 0xBA, 0x72, 0xFF, 0x9B, 0xD3, 0xCC, 0x22, 0x8C, 0xA0, 0xD3, 0xEC, 0x12, 0x99, 0xB5,
+  0x55, 0x09, 0x76, 0x91, 0x71, 0x12, 0x10, 0xC0, 0x6C, 0x4E, 0x02, 0xA9, 0x0F, 0xE8, 0x77, 0x84,
+  0x79, 0x8C, 0x68, 0xFE, 0x56, 0x07, 0xFF, 0x76, 0x7C, 0xF3, 0xF2, 0xC9, 0xDA, 0x08, 0x5F, 0x69,
+  0x93, 0x7B, 0x23, 0x79, 0x6C, 0x3B, 0x03, 0x54, 0xA0, 0x79, 0x0E, 0x53, 0xD4, 0xA9, 0xBE, 0x08,
+  0x14, 0x60, 0xEB, 0xD8, 0x98, 0xEB, 0xD8, 0xAC, 0xEF, 0x65, 0x70, 0xE9, 0x94, 0x77, 0x69, 0x96,
+  0xB2, 0xF2, 0xD3, 0xFC, 0xB3, 0x03, 0xCD, 0x15, 0xD7, 0x18, 0x82, 0x2E, 0x40, 0x72, 0xFC, 0xBA,
+  0x32, 0x3E, 0x37, 0xDD, 0x71, 0x7D, 0xA2, 0x5D, 0xBF, 0xD2, 0x01, 0x85, 0x18, 0x64, 0x4A, 0x48,
+  0x46, 0x44, 0x28, 0x86, 0x6E, 0x4B, 0x93, 0x00, 0x4B, 0xAD, 0x07, 0x59, 0xD3, 0x2B, 0x80, 0x01,
+  0xD3, 0xC9, 0x24, 0xA6, 0x10, 0x4D, 0x4C, 0xFE, 0x48, 0x74, 0x91, 0x49, 0x2C, 0x2A, 0x8B, 0x17,
+  0x90, 0xA8, 0x12, 0xDE, 0xBA, 0xCE, 0x6F, 0x51, 0xA7, 0x37, 0x4C, 0x2A, 0x1A, 0x53, 0x61, 0x17,
+  0x6D, 0xA0, 0xB5, 0x4A, 0x31, 0x9B, 0x56, 0x0C, 0xA4, 0x6E, 0x22, 0xA8, 0xA6, 0x38, 0xA3, 0x21,
+  0x49, 0x23, 0x65, 0x3B, 0xB5, 0x74, 0x31, 0xEF, 0x0E, 0x0F, 0xAB, 0x49, 0x54, 0xA2, 0xC5, 0x70,
+  0xBD, 0x3B, 0xC0, 0x8F, 0x61, 0x1D, 0x0D, 0x37, 0x6B, 0x89, 0xB8, 0xF3, 0xE2, 0x45, 0x0D, 0x49,
+  0x4D, 0x44, 0x23, 0xA4, 0xAA, 0x83, 0xC7, 0x3E, 0x37, 0x83, 0x93, 0x46, 0xAE, 0x6E, 0xC1, 0x3A,
+  0x7B, 0x6D, 0x7C, 0xDE, 0x50, 0xAE, 0xE1, 0xF9, 0x73, 0x64, 0x55, 0x80, 0xAE, 0xB7, 0x2C, 0xC7,
+  0xC1, 0xC6, 0x13, 0x2B, 0x16, 0xA7, 0xB4, 0xC2, 0x4F, 0xEB, 0xFF, 0x29, 0xE7, 0xA7, 0x33, 0x34,
+  0xAF, 0xAB, 0x2E, 0x8B, 0x03, 0x7A, 0x7F, 0x19, 0xDA, 0xF9, 0x96, 0x03, 0x47, 0x68, 0x0C, 0xF6,
+  0x80, 0xB7, 0x66, 0xFE, 0xB6, 0x0B, 0xDE, 0x0E, 0x76, 0x83, 0xE2, 0xB9, 0xE9, 0x53, 0xC8, 0x2B,
+  0xBB, 0xAB, 0xDB, 0xC6, 0x29, 0x8A, 0xD6, 0xE1, 0x8A, 0x9A, 0x60, 0xBF, 0xC5, 0x0B, 0x96, 0xEB,
+  0xBA, 0x56, 0x49, 0xB1, 0x16, 0xB9, 0x2D, 0x8C, 0xD3, 0xEC, 0x6D, 0x28, 0x76, 0x9B, 0xD1, 0xE5,
+  0xF8, 0x0A, 0x57, 0xF2, 0xBA, 0xE2, 0xE1, 0x96, 0x95, 0xB3, 0x6B, 0x5F, 0xA1, 0xE9, 0x16, 0x1E,
+  0x21, 0x49, 0x82, 0xAD, 0xD5, 0x14, 0x9A, 0x8E, 0x0E, 0x6B, 0x0B, 0xBE, 0xB5, 0x8C, 0x6D, 0x1E,
+  0xFC, 0x6D, 0x7C, 0xF9, 0x16, 0x6B, 0x84, 0x40, 0x99, 0x2C, 0x5C, 0xDA, 0x7A, 0xD1, 0xC1, 0x78,
+  0x5B, 0x41, 0xB0, 0x4D, 0x92, 0x34, 0xCF, 0xDC, 0x54, 0xCE, 0x7C, 0x05, 0x3E, 0xF7, 0xF0, 0x24,
+  0x9F, 0xB7, 0xE0, 0xC6, 0x83, 0x1B, 0xF8, 0xA6, 0x53, 0x6A, 0xF0, 0xB8, 0x0C, 0x2A, 0x6B, 0xAE,
+  0xCF, 0x1D, 0x8B, 0xCB, 0xC8, 0xC6, 0x79, 0x00, 0xB8, 0x73, 0x21, 0xF4, 0x3B, 0x6E, 0x5D, 0x3C,
+  0xF5, 0xC1, 0x1B, 0x97, 0xEA, 0x85, 0x41, 0x95, 0x0B, 0x8D, 0x24, 0xDD, 0x4C, 0x9D, 0x51, 0xE0,
+  0x5F, 0x85, 0x69, 0xA4, 0x9B, 0xB9, 0x1E, 0x7B, 0x82, 0x16, 0xAE, 0x4F, 0x70, 0xCA, 0xC8, 0x1D,
+  0xA2, 0x7B, 0xBB, 0x59, 0x07, 0x12, 0xE3, 0xAF, 0x06, 0x95, 0x06, 0x15, 0x3F, 0x95, 0x45, 0xD7,
+  0xE8, 0xA9, 0x83, 0x4C, 0xC3, 0xE9, 0x96, 0x73, 0xAC, 0xB3, 0x45, 0x75, 0x6C, 0x50, 0x54, 0x78,
+  0xD7, 0x00, 0xDB, 0x50, 0x0E, 0x1E, 0x87, 0x25, 0xEF, 0xB1, 0x31, 0x57, 0x68, 0x13, 0xC1, 0x11,
+  0x74, 0x12, 0x51, 0x6B, 0x50, 0xA9, 0xAE, 0xD9, 0x03, 0x0E, 0x58, 0xC5, 0x1C, 0x85, 0x43, 0x5F,
+  0xF6, 0x0E, 0x7F, 0xD8, 0x31, 0xFF, 0x8D, 0xFE, 0x0F, 0x14, 0xEF, 0xAB, 0x7F, 0xA5, 0x1E, 0x00,
+  0x00,
+};
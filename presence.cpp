@@ -0,0 +1,138 @@
+/*
+ * presence.cpp
+ * -------------------------------
+ * Implements passive host presence tracking:
+ *  - The WiFi STA netif's input function is wrapped: the wrapper
+ *    runs in the WiFi driver task, parses the frame in place and
+ *    passes the pbuf on untouched; it is re-installed if the netif
+ *    gets a new input function
+ *  - The tx task reads the W5500 DHCP socket (presenceEthPoll)
+ *  - Both push sightings into an MPSC queue; the loop task drains
+ *    it into the MacTable and stamps the matching fleet hosts
+ *  - hostSeen[] is a relaxed atomic per fleet host, so the probe
+ *    task can check freshness without touching the table
+ */
+
+#include <atomic>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/netif.h>
+#include <lwip/pbuf.h>
+#include <ArduinoJson.h>
+#include "presence.h"
+#include "presence_parse.h"
+#include "fleet.h"
+#include "netif.h"
+#include "helpers.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "lockfree_queue.h"
+
+#define PRESENCE_DHCP_BUF 576
+
+static MpscQueue<PresenceSighting, PRESENCE_QUEUE_LEN> sightings;   // WiFi driver, tx -> loop
+static std::atomic<uint32_t> hostSeen[FLEET_MAX_HOSTS];
+static netif_input_fn staInput = nullptr;
+
+// loop task only
+static MacTable<PRESENCE_TABLE_SIZE> table;
+static unsigned long lastHook = 0;
+
+static void push(PresenceSighting &s, uint8_t iface){
+  s.iface = iface;
+  s.ms = millis();
+  if(!sightings.push(s)) metricInc(CNT_PRESENCE_DROPS);
+}
+
+// WiFi driver task: only looks at the frame, the pbuf goes on to lwIP
+static err_t presenceInput(struct pbuf* p, struct netif* inp){
+  PresenceSighting s;
+  if(presenceParseFrame((const uint8_t*)p->payload, p->len, s)) push(s, NETIF_WIFI);
+  return staInput(p, inp);
+}
+
+static void hookWifi(){
+  esp_netif_t* sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  struct netif* n = sta ? (struct netif*)esp_netif_get_netif_impl(sta) : nullptr;
+  if(!n || !n->input || n->input == presenceInput) return;
+  staInput = n->input;
+  n->input = presenceInput;
+  logMsg(LOGL_DEBUG, "Presence: WiFi hook installed");
+}
+
+void presenceEthPoll(){
+  static uint8_t buf[PRESENCE_DHCP_BUF];
+  size_t n;
+  while((n = netifReceiveDhcp(buf, sizeof(buf))) > 0){
+    PresenceSighting s;
+    if(presenceParseDhcp(buf, n, s)) push(s, NETIF_ETH);
+  }
+}
+
+static void presenceTask(){
+  if(!lastHook || millis() - lastHook >= PRESENCE_HOOK_MS){
+    lastHook = millis();
+    hookWifi();
+  }
+
+  PresenceSighting s;
+  while(sightings.pop(s)){
+    metricInc(CNT_PRESENCE_SIGHTINGS);
+    const auto* e = table.update(s);
+    if(e->count == 1){
+      logMsg(LOGL_DEBUG, "Presence: new %02X:%02X:%02X:%02X:%02X:%02X (%u.%u.%u.%u) by %s",
+             s.mac[0], s.mac[1], s.mac[2], s.mac[3], s.mac[4], s.mac[5],
+             e->ip[0], e->ip[1], e->ip[2], e->ip[3], presenceKindNames[s.kind]);
+    }
+    portENTER_CRITICAL(&configLock);
+    for(int i = 0; i < fleetSize; i++){
+      if(!memcmp(fleetHosts[i].mac, s.mac, 6)) hostSeen[i].store(max(s.ms, (uint32_t)1), std::memory_order_relaxed);
+    }
+    portEXIT_CRITICAL(&configLock);
+  }
+}
+
+// Loop task: a host told to shut down is not "up" on old sightings
+void presenceForget(int host){
+  if(host >= 0 && host < FLEET_MAX_HOSTS) hostSeen[host].store(0, std::memory_order_relaxed);
+}
+
+uint32_t presenceLastSeen(int host){
+  if(host < 0 || host >= FLEET_MAX_HOSTS) return 0;
+  return hostSeen[host].load(std::memory_order_relaxed);
+}
+
+bool presenceFresh(int host, uint32_t maxAgeMs){
+  uint32_t seen = presenceLastSeen(host);
+  return seen && millis() - seen < maxAgeMs;
+}
+
+String presenceReport(){
+  JsonDocument doc;
+  uint32_t now = millis();
+  doc["size"] = table.size();
+  doc["capacity"] = table.MAX_LOAD;
+  JsonArray list = doc["seen"].to<JsonArray>();
+  table.forEach([&](const MacTable<PRESENCE_TABLE_SIZE>::Entry &e){
+    char mac[18], ip[16];
+    uint64_t k = e.key;
+    snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+             (uint8_t)(k >> 40), (uint8_t)(k >> 32), (uint8_t)(k >> 24),
+             (uint8_t)(k >> 16), (uint8_t)(k >> 8), (uint8_t)k);
+    snprintf(ip, sizeof(ip), "%u.%u.%u.%u", e.ip[0], e.ip[1], e.ip[2], e.ip[3]);
+    JsonObject o = list.add<JsonObject>();
+    o["mac"] = mac;
+    o["ip"] = ip;
+    o["by"] = presenceKindNames[e.kind];
+    o["iface"] = e.iface == NETIF_ETH ? "eth" : "wifi";
+    o["age_s"] = (now - e.lastMs) / 1000;
+    o["count"] = e.count;
+  });
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+void presenceBegin(){
+  schedulerEvery(PRESENCE_TASK_MS, presenceTask);
+}
@@ -0,0 +1,30 @@
+/*
+ * presence.h
+ * -------------------------------
+ * Declares passive host presence tracking:
+ *  - Every ARP (request, reply, probe, gratuitous) and DHCP request
+ *    received on WiFi is noted by MAC, no packet is sent
+ *  - On the W5500 (no raw frames with the Ethernet library) the DHCP
+ *    requests are read from a UDP socket on port 67
+ *  - MAC -> last seen, IP and kind in a MacTable (presence_parse.h)
+ *    of PRESENCE_TABLE_SIZE entries, owned by the loop task
+ *  - Fleet hosts seen within PRESENCE_FRESH_MS are answered "up"
+ *    by the probe engine without a probe; stale hosts are probed.
+ *    A shutdown drops the host's sighting
+ */
+
+#pragma once
+#include "config.h"
+
+#define PRESENCE_TABLE_SIZE  128     // power of two, 3/4 usable
+#define PRESENCE_QUEUE_LEN   32
+#define PRESENCE_FRESH_MS    120000UL
+#define PRESENCE_TASK_MS     50
+#define PRESENCE_HOOK_MS     5000    // re-check the WiFi netif hook
+
+void presenceBegin();
+void presenceEthPoll();                         // tx task only
+void presenceForget(int host);                  // loop task, on shutdown
+uint32_t presenceLastSeen(int host);            // millis(), 0 = never; any task
+bool presenceFresh(int host, uint32_t maxAgeMs);
+String presenceReport();
@@ -0,0 +1,205 @@
+/*
+ * presence_parse.h
+ * -------------------------------
+ * Passive presence: frame parser and MAC index, shared by the
+ * firmware (presence.cpp) and the Linux pcap replay
+ * (Tools/presence_replay.cpp):
+ *  - presenceParseFrame(): Ethernet II (optionally 802.1Q tagged)
+ *    frame -> sender MAC/IP of an ARP request, reply, probe or
+ *    gratuitous ARP, or the client of a DHCP request
+ *  - presenceParseDhcp(): the same for a bare BOOTP payload (a UDP
+ *    socket bound to port 67 on the W5500)
+ *  - MacTable<N>: fixed-size open-addressing (linear probing) MAC
+ *    -> last-seen index; backward-shift delete, the least recently
+ *    seen entry is evicted when it reaches 3/4 load
+ *  - Plain C++17, no Arduino headers
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum PresenceKind : uint8_t {
+  PRESENCE_ARP_REQUEST = 0,
+  PRESENCE_ARP_REPLY   = 1,
+  PRESENCE_ARP_GRATUITOUS = 2,
+  PRESENCE_ARP_PROBE   = 3,   // RFC 5227, sender IP 0.0.0.0
+  PRESENCE_DHCP        = 4,
+  PRESENCE_KIND_COUNT
+};
+
+static const char* const presenceKindNames[PRESENCE_KIND_COUNT] = {
+  "arp_request", "arp_reply", "arp_gratuitous", "arp_probe", "dhcp"
+};
+
+struct PresenceSighting {
+  uint8_t  mac[6];
+  uint8_t  ip[4];     // 0.0.0.0 when not known yet (ARP probe, DHCP discover)
+  uint8_t  kind;      // PresenceKind
+  uint8_t  iface;     // NetIface on the device, 0 in the replay
+  uint32_t ms;
+};
+
+inline uint16_t presenceBe16(const uint8_t* p){ return (uint16_t)(p[0] << 8 | p[1]); }
+
+inline bool presenceValidMac(const uint8_t* mac){
+  static const uint8_t zero[6] = { 0 };
+  return !(mac[0] & 1) && memcmp(mac, zero, 6) != 0;   // unicast, not 00:00:00:00:00:00
+}
+
+// BOOTP request (client -> server): chaddr, ciaddr or option 50
+inline bool presenceParseDhcp(const uint8_t* p, size_t len, PresenceSighting &out){
+  if(len < 240 || p[0] != 1 || p[1] != 1 || p[2] != 6) return false;   // BOOTREQUEST, Ethernet
+  if(p[236] != 0x63 || p[237] != 0x82 || p[238] != 0x53 || p[239] != 0x63) return false;
+  if(!presenceValidMac(p + 28)) return false;
+
+  memcpy(out.mac, p + 28, 6);
+  memcpy(out.ip, p + 12, 4);    // ciaddr (renewing clients)
+  out.kind = PRESENCE_DHCP;
+
+  uint8_t msgType = 0;
+  for(size_t i = 240; i < len && p[i] != 255;){
+    if(p[i] == 0){ i++; continue; }
+    if(i + 1 >= len || i + 2 + p[i + 1] > len) break;
+    uint8_t opt = p[i], olen = p[i + 1];
+    if(opt == 53 && olen == 1) msgType = p[i + 2];
+    if(opt == 50 && olen == 4 && !(out.ip[0] | out.ip[1] | out.ip[2] | out.ip[3])) memcpy(out.ip, p + i + 2, 4);
+    i += 2 + olen;
+  }
+  return msgType != 7;   // a RELEASE means the host is leaving
+}
+
+inline bool presenceParseFrame(const uint8_t* f, size_t len, PresenceSighting &out){
+  if(len < 14) return false;
+  size_t off = 12;
+  uint16_t type = presenceBe16(f + off);
+  if(type == 0x8100){
+    if(len < 18) return false;
+    off += 4;
+    type = presenceBe16(f + off);
+  }
+  off += 2;
+  const uint8_t* p = f + off;
+  len -= off;
+
+  if(type == 0x0806){
+    // htype 1, ptype IPv4, hlen 6, plen 4
+    if(len < 28 || presenceBe16(p) != 1 || presenceBe16(p + 2) != 0x0800 || p[4] != 6 || p[5] != 4) return false;
+    uint16_t op = presenceBe16(p + 6);
+    if((op != 1 && op != 2) || !presenceValidMac(p + 8)) return false;
+
+    memcpy(out.mac, p + 8, 6);
+    memcpy(out.ip, p + 14, 4);
+    bool noSender = !(p[14] | p[15] | p[16] | p[17]);
+    if(noSender) out.kind = PRESENCE_ARP_PROBE;
+    else if(!memcmp(p + 14, p + 24, 4)) out.kind = PRESENCE_ARP_GRATUITOUS;
+    else out.kind = op == 2 ? PRESENCE_ARP_REPLY : PRESENCE_ARP_REQUEST;
+    return true;
+  }
+
+  if(type == 0x0800){
+    if(len < 20 || (p[0] >> 4) != 4 || p[9] != 17) return false;   // IPv4 UDP
+    if(presenceBe16(p + 6) & 0x1FFF) return false;                  // not the first fragment
+    size_t ihl = (p[0] & 0x0F) * 4;
+    if(ihl < 20 || len < ihl + 8) return false;
+    const uint8_t* udp = p + ihl;
+    if(presenceBe16(udp + 2) != 67) return false;
+    size_t udpLen = presenceBe16(udp + 4);
+    if(udpLen < 8 || udpLen > len - ihl) udpLen = len - ihl;
+    return presenceParseDhcp(udp + 8, udpLen - 8, out);
+  }
+  return false;
+}
+
+template<size_t N>
+class MacTable {
+  static_assert(N >= 8 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  struct Entry {
+    uint64_t key;      // MAC in the low 48 bits, 0 = free slot
+    uint32_t lastMs;
+    uint32_t firstMs;
+    uint32_t count;
+    uint8_t  ip[4];
+    uint8_t  kind;
+    uint8_t  iface;
+  };
+
+  static constexpr size_t MAX_LOAD = N * 3 / 4;
+
+  static uint64_t keyOf(const uint8_t* mac){
+    uint64_t k = 0;
+    for(int i = 0; i < 6; i++) k = (k << 8) | mac[i];
+    return k;
+  }
+
+  Entry* find(const uint8_t* mac){
+    uint64_t k = keyOf(mac);
+    for(size_t i = home(k), n = 0; n < N; i = (i + 1) & (N - 1), n++){
+      if(slots[i].key == k) return &slots[i];
+      if(!slots[i].key) return nullptr;
+    }
+    return nullptr;
+  }
+
+  // Records a sighting; returns the entry (count == 1 when new)
+  Entry* update(const PresenceSighting &s){
+    Entry* e = find(s.mac);
+    if(!e){
+      if(used >= MAX_LOAD) erase(oldest());
+      uint64_t k = keyOf(s.mac);
+      size_t i = home(k);
+      while(slots[i].key) i = (i + 1) & (N - 1);
+      e = &slots[i];
+      memset(e, 0, sizeof(*e));
+      e->key = k;
+      e->firstMs = s.ms;
+      used++;
+    }
+    e->lastMs = s.ms;
+    e->count++;
+    e->kind = s.kind;
+    e->iface = s.iface;
+    if(s.ip[0] | s.ip[1] | s.ip[2] | s.ip[3]) memcpy(e->ip, s.ip, 4);
+    return e;
+  }
+
+  void erase(Entry* e){
+    if(!e || !e->key) return;
+    size_t hole = e - slots;
+    for(size_t i = (hole + 1) & (N - 1); slots[i].key; i = (i + 1) & (N - 1)){
+      size_t h = home(slots[i].key);
+      // Move back unless the entry's home lies cyclically in (hole, i]
+      bool stays = hole <= i ? (hole < h && h <= i) : (hole < h || h <= i);
+      if(stays) continue;
+      slots[hole] = slots[i];
+      hole = i;
+    }
+    slots[hole].key = 0;
+    used--;
+  }
+
+  size_t size() const { return used; }
+
+  template<typename F> void forEach(F fn) const {
+    for(size_t i = 0; i < N; i++) if(slots[i].key) fn(slots[i]);
+  }
+
+private:
+  static size_t home(uint64_t k){
+    return (size_t)((k * 0x9E3779B97F4A7C15ULL) >> 32) & (N - 1);
+  }
+
+  Entry* oldest(){
+    Entry* o = nullptr;
+    for(size_t i = 0; i < N; i++){
+      if(slots[i].key && (!o || (int32_t)(slots[i].lastMs - o->lastMs) < 0)) o = &slots[i];
+    }
+    return o;
+  }
+
+  Entry  slots[N] = {};
+  size_t used = 0;
+};
@@ -0,0 +1,203 @@
+/*
+ * probe.cpp
+ * -------------------------------
+ * Implements the non-blocking reachability engine:
+ *  - The rounds (attempts, slots, timeouts, stats) are
+ *    ProbeEngine in probe_engine.h; this file is its lwIP side
+ *  - One shared non-blocking raw ICMP socket; replies are matched
+ *    by echo id/sequence to an in-flight slot
+ *  - Optional TCP connect to config.probe_port (a refused
+ *    connection also proves the host is up)
+ *  - The engine runs on the "probe" task every PROBE_TASK_MS and
+ *    never waits on the network; probeHost() reaches it through an
+ *    SPSC request queue, finished rounds come back through another
+ *    one and probeDispatch() calls the listeners on the loop task
+ *  - The engine's stats are written by the probe task only; readers
+ *    on the loop task may see a round half-applied, each field is
+ *    still whole
+ *  - Passive answers (fresh presence) set the state and notify the
+ *    listeners like a round, without touching the RTT figures
+ */
+
+#include <lwip/sockets.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include "probe.h"
+#include "fleet.h"
+#include "helpers.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "tasks.h"
+#include "lockfree_queue.h"
+#include "presence.h"
+
+struct ProbeReq {
+  int16_t host;
+  bool    report;
+  bool    active;
+};
+
+struct ProbeResult {
+  int16_t host;
+  bool    up;
+};
+
+static SpscQueue<ProbeReq, FLEET_MAX_HOSTS>    requests;   // loop -> probe
+static SpscQueue<ProbeResult, FLEET_MAX_HOSTS> results;    // probe -> loop
+
+static int icmpFd = -1;
+static ProbeListener listeners[PROBE_MAX_LISTENERS];
+static uint8_t listenerCount = 0;
+
+static sockaddr_in hostAddr(int host, uint16_t port){
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family = AF_INET;
+  a.sin_port = htons(port);
+  memcpy(&a.sin_addr.s_addr, fleetHostCopy(host).ip, 4);
+  return a;
+}
+
+static void publishResult(int host, const ProbeStats &s){
+  logMsg(LOGL_INFO, "Ping: %s %s, rtt %u/%lu/%u ms, loss %lu%%",
+         fleetHosts[host].name, s.state == PROBE_UP ? "online" : "offline",
+         s.rttMin, (unsigned long)(s.replies ? s.rttSum / s.replies : 0), s.rttMax,
+         (unsigned long)((s.sent - s.replies) * 100 / max(s.sent, (uint32_t)1)));
+}
+
+// The engine's socket layer: lwIP, never blocking
+struct LwipProbeIo {
+  bool sendIcmp(int host, uint16_t seq){
+    if(icmpFd < 0) return false;
+    uint8_t pkt[PROBE_ECHO_LEN];
+    probeEchoRequest(pkt, seq);
+    sockaddr_in a = hostAddr(host, 0);
+    return sendto(icmpFd, pkt, sizeof(pkt), 0, (sockaddr*)&a, sizeof(a)) >= 0;
+  }
+
+  bool recvIcmp(uint16_t &seq){
+    if(icmpFd < 0) return false;
+    uint8_t buf[64];
+    sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    int n;
+    while((n = recvfrom(icmpFd, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen)) > 0){
+      if(probeEchoReply(buf, n, seq)) return true;
+      fromLen = sizeof(from);
+    }
+    return false;
+  }
+
+  int startTcp(int host){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) return -1;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in a = hostAddr(host, config.probe_port);
+    if(connect(fd, (sockaddr*)&a, sizeof(a)) < 0 && errno != EINPROGRESS){
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  // A refused connection also proves the host is up
+  int tcpResult(int fd){
+    fd_set wset;
+    FD_ZERO(&wset);
+    FD_SET(fd, &wset);
+    timeval tv = { 0, 0 };
+    if(select(fd + 1, NULL, &wset, NULL, &tv) <= 0) return 0;
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    return err == 0 || err == ECONNREFUSED ? 1 : -1;
+  }
+
+  void closeTcp(int fd){ close(fd); }
+
+  void onReply(uint32_t rtt){
+    metricInc(CNT_PROBE_REPLIES);
+    metricObserve(HIST_PING_RTT_MS, rtt);
+  }
+
+  void onTimeout(){ metricInc(CNT_PROBE_TIMEOUTS); }
+
+  void onRound(int host, const ProbeStats &s, bool publish){
+    if(publish) publishResult(host, s);
+    results.push({ (int16_t)host, s.state == PROBE_UP });
+  }
+};
+
+// probe task only
+static LwipProbeIo io;
+static ProbeEngine<LwipProbeIo, FLEET_MAX_HOSTS> engine(io);
+
+static void passiveUp(int host, bool report){
+  uint8_t prev = engine.markUp(host);
+  metricInc(CNT_PROBE_PASSIVE);
+  if(prev != PROBE_UP || report){
+    logMsg(LOGL_INFO, "Ping: %s online (seen %lu s ago on the LAN, not probed)", fleetHosts[host].name,
+           (unsigned long)((millis() - presenceLastSeen(host)) / 1000));
+  }
+  results.push({ (int16_t)host, true });
+}
+
+static void takeRequests(){
+  ProbeReq r;
+  while(requests.pop(r)){
+    if(!engine.running(r.host) && !r.active && presenceFresh(r.host, PRESENCE_FRESH_MS)){
+      passiveUp(r.host, r.report);
+      continue;
+    }
+    engine.request(r.host, r.report);
+  }
+}
+
+static void probeTask(void*){
+  for(;;){
+    takeRequests();
+    engine.poll(millis(), config.probe_port > 0);
+    vTaskDelay(pdMS_TO_TICKS(PROBE_TASK_MS));
+  }
+}
+
+// Loop task: hands finished rounds to the listeners
+static void probeDispatch(){
+  ProbeResult r;
+  while(results.pop(r)){
+    for(int i = 0; i < listenerCount; i++) listeners[i](r.host, r.up);
+  }
+}
+
+void probeBegin(){
+  icmpFd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+  if(icmpFd >= 0) fcntl(icmpFd, F_SETFL, fcntl(icmpFd, F_GETFL, 0) | O_NONBLOCK);
+  else logMsg(LOGL_ERROR, "Probe: ICMP socket failed");
+
+  if(!taskStart(probeTask, "probe", TASK_STACK_PROBE, TASK_PRIO_PROBE, TASK_CORE_APP))
+    logMsg(LOGL_ERROR, "Probe: Could not start task");
+  schedulerEvery(PROBE_TASK_MS, probeDispatch);
+}
+
+void probeAddListener(ProbeListener fn){
+  if(listenerCount < PROBE_MAX_LISTENERS) listeners[listenerCount++] = fn;
+}
+
+// Loop task only (single producer)
+bool probeHost(int host, bool report, bool active){
+  if(host < 0 || host >= fleetSize) return false;
+  return requests.push({ (int16_t)host, report, active });
+}
+
+int probeAll(bool report){
+  int n = 0;
+  for(int i = 0; i < fleetSize; i++) n += probeHost(i, report);
+  return n;
+}
+
+const ProbeStats& probeStats(int host){
+  return engine.stats(host);
+}
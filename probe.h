@@ -0,0 +1,29 @@
+/*
+ * probe.h
+ * -------------------------------
+ * Declares the non-blocking reachability engine:
+ *  - ICMP echo and TCP-connect probes against fleet hosts
+ *  - Up to PROBE_MAX_INFLIGHT probes in flight at once
+ *  - Per-host RTT min/avg/max and loss rate
+ *  - Publishes only on online/offline changes, unless a
+ *    round was explicitly requested with report = true
+ *  - Listeners (wake watch, local API) get every finished round,
+ *    called on the loop task; the engine has its own "probe" task
+ *  - A host seen by presence.h within PRESENCE_FRESH_MS is answered
+ *    "up" without a probe, unless the caller asks for an active one
+ */
+
+#pragma once
+#include "config.h"
+#include "probe_engine.h"
+
+#define PROBE_TASK_MS      10
+#define PROBE_MAX_LISTENERS 4
+
+typedef void (*ProbeListener)(int host, bool up);
+
+void probeBegin();
+void probeAddListener(ProbeListener fn);
+bool probeHost(int host, bool report, bool active = false);
+int  probeAll(bool report);
+const ProbeStats& probeStats(int host);
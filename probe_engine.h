@@ -0,0 +1,240 @@
+/*
+ * probe_engine.h
+ * -------------------------------
+ * Reachability probe rounds without the network, shared by the
+ * firmware (probe.cpp, lwIP sockets) and the Linux test
+ * (Tools/probe_test.cpp, mock sockets):
+ *  - ProbeEngine<Io, N>: per-host rounds of up to PROBE_ATTEMPTS
+ *    attempts; an attempt is an ICMP echo plus, when asked, a TCP
+ *    connect, in up to PROBE_MAX_INFLIGHT slots (PROBE_MAX_TCP of
+ *    them TCP); the first answer ends the round, PROBE_TIMEOUT_MS
+ *    without one retries
+ *  - Io is the socket layer and the reporting: sendIcmp(host, seq),
+ *    recvIcmp(seq), startTcp(host) -> fd, tcpResult(fd) (0 pending,
+ *    1 up, -1 failed), closeTcp(fd), onReply(rtt), onTimeout(),
+ *    onRound(host, stats, publish)
+ *  - probeEchoRequest() / probeEchoReply(): the ICMP packet, built
+ *    and matched by id/sequence
+ *  - Time is a millisecond counter passed in; plain C++17, no
+ *    Arduino headers
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PROBE_MAX_INFLIGHT 16
+#define PROBE_MAX_TCP      4      // TCP probes hold an lwIP socket each
+#define PROBE_TIMEOUT_MS   1000
+#define PROBE_ATTEMPTS     3
+#define PROBE_ICMP_ID      0x574F
+#define PROBE_ECHO_LEN     16
+
+enum ProbeState : uint8_t {
+  PROBE_UNKNOWN = 0,
+  PROBE_UP      = 1,
+  PROBE_DOWN    = 2
+};
+
+struct ProbeStats {
+  uint32_t sent;
+  uint32_t replies;
+  uint32_t rttSum;
+  uint16_t rttMin;
+  uint16_t rttMax;
+  uint8_t  state;
+};
+
+inline uint16_t probeChecksum(const uint8_t* data, size_t len){
+  uint32_t sum = 0;
+  for(size_t i = 0; i + 1 < len; i += 2) sum += (data[i] << 8) | data[i + 1];
+  if(len & 1) sum += data[len - 1] << 8;
+  while(sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+  return ~sum;
+}
+
+inline void probeEchoRequest(uint8_t pkt[PROBE_ECHO_LEN], uint16_t seq){
+  memset(pkt, 0, PROBE_ECHO_LEN);
+  pkt[0] = 8;                                   // echo request
+  pkt[4] = PROBE_ICMP_ID >> 8; pkt[5] = PROBE_ICMP_ID & 0xFF;
+  pkt[6] = seq >> 8; pkt[7] = seq & 0xFF;
+  uint16_t c = probeChecksum(pkt, PROBE_ECHO_LEN);
+  pkt[2] = c >> 8; pkt[3] = c & 0xFF;
+}
+
+// IPv4 datagram from the raw socket -> sequence of an echo reply with our id
+inline bool probeEchoReply(const uint8_t* buf, size_t n, uint16_t &seq){
+  if(n < 20) return false;
+  size_t ihl = (buf[0] & 0x0F) * 4;
+  if(ihl < 20 || n < ihl + 8) return false;
+  const uint8_t* icmp = buf + ihl;
+  if(icmp[0] != 0 || ((icmp[4] << 8) | icmp[5]) != PROBE_ICMP_ID) return false;
+  seq = (icmp[6] << 8) | icmp[7];
+  return true;
+}
+
+template<typename Io, size_t N>
+class ProbeEngine {
+public:
+  explicit ProbeEngine(Io &io) : io(io) {}
+
+  // Starts a round; a running one only takes the report flag
+  void request(int host, bool report){
+    roundReport[host] |= report;
+    if(roundLeft[host] > 0) return;
+    roundLeft[host] = PROBE_ATTEMPTS;
+    enqueue(host);
+  }
+
+  bool running(int host) const { return roundLeft[host] > 0; }
+
+  // State from elsewhere (fresh presence), RTT figures untouched; returns the previous one
+  uint8_t markUp(int host){
+    uint8_t prev = st[host].state;
+    st[host].state = PROBE_UP;
+    return prev;
+  }
+
+  // One pass: replies, TCP outcomes, timeouts, then new attempts
+  void poll(uint32_t nowMs, bool tcp){
+    uint16_t seq;
+    while(io.recvIcmp(seq)){
+      for(int i = 0; i < PROBE_MAX_INFLIGHT; i++){
+        if(slots[i].busy && slots[i].fd < 0 && slots[i].seq == seq){
+          finishAttempt(slots[i].host, true, nowMs - slots[i].sentAt);
+          break;
+        }
+      }
+    }
+
+    for(int i = 0; i < PROBE_MAX_INFLIGHT; i++){
+      if(!slots[i].busy || slots[i].fd < 0) continue;
+      int r = io.tcpResult(slots[i].fd);
+      if(r > 0) finishAttempt(slots[i].host, true, nowMs - slots[i].sentAt);
+      else if(r < 0) slotFailed(i);
+    }
+
+    for(int i = 0; i < PROBE_MAX_INFLIGHT; i++){
+      if(slots[i].busy && nowMs - slots[i].sentAt >= PROBE_TIMEOUT_MS) slotFailed(i);
+    }
+
+    launch(nowMs, tcp);
+  }
+
+  const ProbeStats& stats(int host) const { return st[host]; }
+
+  int inFlight(bool tcpOnly = false) const {
+    int n = 0;
+    for(int i = 0; i < PROBE_MAX_INFLIGHT; i++) n += slots[i].busy && (!tcpOnly || slots[i].fd >= 0);
+    return n;
+  }
+
+private:
+  struct Slot {
+    int16_t  host;
+    uint16_t seq;
+    uint32_t sentAt;
+    int      fd;         // TCP socket, -1 for ICMP
+    bool     busy;
+  };
+
+  void enqueue(int host){
+    if(queued[host] || queueCount >= (int)N) return;
+    queue[(queueHead + queueCount) % N] = host;
+    queueCount++;
+    queued[host] = true;
+  }
+
+  int freeSlot() const {
+    for(int i = 0; i < PROBE_MAX_INFLIGHT; i++) if(!slots[i].busy) return i;
+    return -1;
+  }
+
+  void finishAttempt(int host, bool ok, uint32_t rtt){
+    for(int i = 0; i < PROBE_MAX_INFLIGHT; i++){
+      if(slots[i].busy && slots[i].host == host){
+        if(slots[i].fd >= 0) io.closeTcp(slots[i].fd);
+        slots[i].busy = false;
+      }
+    }
+
+    ProbeStats &s = st[host];
+    uint8_t prev = s.state;
+    if(ok){
+      io.onReply(rtt);
+      uint16_t r = rtt < 65535 ? rtt : 65535;
+      s.replies++;
+      s.rttSum += r;
+      if(s.replies == 1 || r < s.rttMin) s.rttMin = r;
+      if(r > s.rttMax) s.rttMax = r;
+      s.state = PROBE_UP;
+      roundLeft[host] = 0;
+    } else {
+      io.onTimeout();
+      if(--roundLeft[host] > 0){
+        enqueue(host);
+        return;
+      }
+      s.state = PROBE_DOWN;
+    }
+
+    bool publish = s.state != prev || roundReport[host];
+    roundReport[host] = false;
+    io.onRound(host, s, publish);
+  }
+
+  // Drops one probe; the attempt fails once no other probe of the host is pending
+  void slotFailed(int i){
+    int host = slots[i].host;
+    if(slots[i].fd >= 0) io.closeTcp(slots[i].fd);
+    slots[i].busy = false;
+
+    for(int j = 0; j < PROBE_MAX_INFLIGHT; j++){
+      if(slots[j].busy && slots[j].host == host) return;
+    }
+    finishAttempt(host, false, 0);
+  }
+
+  void launch(uint32_t nowMs, bool tcp){
+    while(queueCount > 0){
+      int slot = freeSlot();
+      if(slot < 0) return;
+
+      int host = queue[queueHead];
+      queueHead = (queueHead + 1) % N;
+      queueCount--;
+      queued[host] = false;
+
+      st[host].sent++;
+      bool started = false;
+      uint16_t seq = ++icmpSeq;
+      if(io.sendIcmp(host, seq)){
+        slots[slot] = { (int16_t)host, seq, nowMs, -1, true };
+        started = true;
+      }
+
+      if(tcp && inFlight(true) < PROBE_MAX_TCP){
+        slot = freeSlot();
+        int fd = slot >= 0 ? io.startTcp(host) : -1;
+        if(fd >= 0){
+          slots[slot] = { (int16_t)host, 0, nowMs, fd, true };
+          started = true;
+        }
+      }
+
+      if(!started) finishAttempt(host, false, 0);
+    }
+  }
+
+  Io        &io;
+  Slot       slots[PROBE_MAX_INFLIGHT] = {};
+  ProbeStats st[N] = {};
+  uint8_t    roundLeft[N] = {};
+  bool       roundReport[N] = {};
+  bool       queued[N] = {};
+  int16_t    queue[N] = {};
+  int        queueHead = 0;
+  int        queueCount = 0;
+  uint16_t   icmpSeq = 0;
+};
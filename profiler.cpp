@@ -0,0 +1,156 @@
+/*
+ * profiler.cpp
+ * -------------------------------
+ * Implements the loop stall profiler (LOOP_PROFILER builds only):
+ *  - Sections are found by name pointer; names are literals, so the
+ *    lookup is a short pointer compare
+ *  - Samples are stored in microseconds in a ring per section; the
+ *    p99 is computed only when a report is requested
+ *  - Stall events are kept in a ring of PROF_MAX_STALLS and logged
+ *  - The synthetic load runs inside the loop iteration, so it shows
+ *    up as a "load" section and in the stalls
+ */
+
+#include "profiler.h"
+
+#ifdef LOOP_PROFILER
+
+#include <algorithm>
+#include <ArduinoJson.h>
+#include "mqtt.h"
+#include "logger.h"
+#include "configPortal.h"
+
+struct ProfSection {
+  const char* name;
+  uint32_t samples[PROF_WINDOW];
+  uint16_t pos;
+  uint32_t count;
+  uint32_t maxUs;
+};
+
+struct StallEvent {
+  uint32_t    atMs;
+  uint32_t    loopUs;
+  const char* worst;
+  uint32_t    worstUs;
+};
+
+static ProfSection sections[PROF_MAX_SECTIONS];
+static uint8_t sectionCount = 0;
+static StallEvent stalls[PROF_MAX_STALLS];
+static uint8_t stallHead = 0;
+static uint8_t stallCount = 0;
+static uint32_t stallTotal = 0;
+
+static uint32_t cpuMhz = 0;
+static uint32_t loopStart;
+static const char* iterWorst;
+static uint32_t iterWorstUs;
+static uint32_t loadMs = 0;
+
+static uint32_t elapsedUs(uint32_t startCycles){
+  if(!cpuMhz) cpuMhz = ESP.getCpuFreqMHz();
+  return (ESP.getCycleCount() - startCycles) / cpuMhz;
+}
+
+static ProfSection* findSection(const char* name){
+  for(int i = 0; i < sectionCount; i++){
+    if(sections[i].name == name) return &sections[i];
+  }
+  if(sectionCount == PROF_MAX_SECTIONS) return nullptr;
+  ProfSection* s = &sections[sectionCount++];
+  s->name = name;
+  return s;
+}
+
+void profRecord(const char* name, uint32_t startCycles){
+  uint32_t us = elapsedUs(startCycles);
+  ProfSection* s = findSection(name);
+  if(!s) return;
+
+  s->samples[s->pos] = us;
+  s->pos = (s->pos + 1) % PROF_WINDOW;
+  s->count++;
+  if(us > s->maxUs) s->maxUs = us;
+  if(us > iterWorstUs){
+    iterWorstUs = us;
+    iterWorst = name;
+  }
+}
+
+void profLoopBegin(){
+  loopStart = ESP.getCycleCount();
+  iterWorst = "?";
+  iterWorstUs = 0;
+  if(loadMs){
+    uint32_t c = ESP.getCycleCount();
+    delayMicroseconds(loadMs * 1000);
+    profRecord("load", c);
+  }
+}
+
+void profSetLoad(uint32_t ms){
+  loadMs = ms > PROF_LOAD_MAX_MS ? PROF_LOAD_MAX_MS : ms;
+  logMsg(LOGL_INFO, "Profiler: synthetic load %lu ms per loop", (unsigned long)loadMs);
+}
+
+void profLoopEnd(){
+  uint32_t us = elapsedUs(loopStart);
+  if(us < PROF_STALL_US) return;
+
+  StallEvent &e = stalls[(stallHead + stallCount) % PROF_MAX_STALLS];
+  if(stallCount == PROF_MAX_STALLS) stallHead = (stallHead + 1) % PROF_MAX_STALLS;
+  else stallCount++;
+  e = { (uint32_t)millis(), us, iterWorst, iterWorstUs };
+  stallTotal++;
+  logMsg(LOGL_WARN, "Stall: loop %lu us, %s took %lu us", (unsigned long)us, iterWorst, (unsigned long)iterWorstUs);
+}
+
+String profReport(){
+  JsonDocument doc;
+  doc["stall_us"] = PROF_STALL_US;
+  doc["stalls_total"] = stallTotal;
+
+  JsonArray secs = doc["sections"].to<JsonArray>();
+  uint32_t window[PROF_WINDOW];
+  for(int i = 0; i < sectionCount; i++){
+    const ProfSection &s = sections[i];
+    int n = min(s.count, (uint32_t)PROF_WINDOW);
+    memcpy(window, s.samples, n * sizeof(uint32_t));
+    std::sort(window, window + n);
+
+    JsonObject o = secs.add<JsonObject>();
+    o["name"]  = s.name;
+    o["calls"] = s.count;
+    o["max"]   = n ? window[n - 1] : 0;
+    o["p99"]   = n ? window[(n - 1) * 99 / 100] : 0;
+    o["max_all"] = s.maxUs;
+  }
+
+  JsonArray ev = doc["stalls"].to<JsonArray>();
+  for(int i = 0; i < stallCount; i++){
+    const StallEvent &e = stalls[(stallHead + i) % PROF_MAX_STALLS];
+    JsonObject o = ev.add<JsonObject>();
+    o["at_ms"]   = e.atMs;
+    o["loop_us"] = e.loopUs;
+    o["in"]      = e.worst;
+    o["in_us"]   = e.worstUs;
+  }
+
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+// Streamed by the mqtt task, so the report is not limited by the MQTT buffer size
+void profPublish(){
+  String r = profReport();
+  mqttPost("wol/profile", r.c_str(), r.length(), false);
+}
+
+void handleProfile(){
+  server.send(200, "application/json", profReport());
+}
+
+#endif
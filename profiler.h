@@ -0,0 +1,51 @@
+/*
+ * profiler.h
+ * -------------------------------
+ * Declares the opt-in loop stall profiler:
+ *  - Uncomment LOOP_PROFILER below to build it in; without it every
+ *    macro expands to the bare call and nothing else is compiled
+ *  - PROF_CALL() times one subsystem with the CPU cycle counter;
+ *    scheduler tasks are timed by the scheduler under their own
+ *    function name
+ *  - Per section: rolling max and p99 over the last PROF_WINDOW
+ *    calls, all-time max and call count
+ *  - A loop() iteration longer than PROF_STALL_US is recorded as a
+ *    stall event naming the slowest section of that iteration
+ *  - ProfDump command publishes the report on "wol/profile";
+ *    GET /profile returns the same JSON
+ *  - "ProfLoad:<ms>" busy-waits that long in every loop() iteration,
+ *    to measure button and command latency under a loaded loop
+ */
+
+#pragma once
+#include <Arduino.h>
+
+// #define LOOP_PROFILER
+
+#define PROF_MAX_SECTIONS 24
+#define PROF_WINDOW       128
+#define PROF_MAX_STALLS   8
+#define PROF_STALL_US     50000
+#define PROF_LOAD_MAX_MS  500
+
+#ifdef LOOP_PROFILER
+
+void profLoopBegin();
+void profLoopEnd();
+void profRecord(const char* name, uint32_t startCycles);
+String profReport();
+void profPublish();
+void handleProfile();
+void profSetLoad(uint32_t ms);
+
+#define PROF_LOOP_BEGIN()     profLoopBegin()
+#define PROF_LOOP_END()       profLoopEnd()
+#define PROF_CALL(name, call) do { uint32_t _c = ESP.getCycleCount(); call; profRecord(name, _c); } while(0)
+
+#else
+
+#define PROF_LOOP_BEGIN()     do {} while(0)
+#define PROF_LOOP_END()       do {} while(0)
+#define PROF_CALL(name, call) do { call; } while(0)
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * relay.cpp
+ * -------------------------------
+ * Implements the Wake-on-LAN relay:
+ *  - The tx task passes every datagram that is not an agent ack to
+ *    relayInput(); the filter and its allowlist are owned by it
+ *  - The allowlist is rebuilt from fleetHosts when a hash over
+ *    their MACs changes (checked every RELAY_ALLOW_CHECK_MS), which
+ *    also resets the per-MAC forward times
+ *  - Every verdict is counted (wol_relay_packets_total), forwards
+ *    are logged, refused magic packets at debug level
+ */
+
+#include "relay.h"
+#include "fleet.h"
+#include "helpers.h"
+#include "metrics.h"
+
+static bool enabled = false;
+
+// tx task only
+static RelayFilter<FLEET_MAX_HOSTS> filter;
+static uint32_t allowHash = 0;
+static unsigned long allowCheckedAt = 0;
+static uint64_t allowKeys[FLEET_MAX_HOSTS];
+
+// Snapshot of the fleet MACs (host 0 changes with the config) and their hash
+static uint32_t fleetMacSnapshot(){
+  uint32_t h = 2166136261u ^ (uint32_t)fleetSize;
+  portENTER_CRITICAL(&configLock);
+  for(int i = 0; i < fleetSize; i++){
+    for(int k = 0; k < 6; k++) h = (h ^ fleetHosts[i].mac[k]) * 16777619u;
+    allowKeys[i] = relayMacKey(fleetHosts[i].mac);
+  }
+  portEXIT_CRITICAL(&configLock);
+  return h;
+}
+
+static void refreshAllow(){
+  if(allowCheckedAt && millis() - allowCheckedAt < RELAY_ALLOW_CHECK_MS) return;
+  allowCheckedAt = max(millis(), 1UL);
+  uint32_t h = fleetMacSnapshot();
+  if(h == allowHash && filter.size()) return;
+  allowHash = h;
+  filter.setAllowed(fleetSize, [](size_t i){ return allowKeys[i]; });
+  logMsg(LOGL_DEBUG, "Relay: %u MACs allowed", (unsigned)filter.size());
+}
+
+bool relayEnabled(){
+  return enabled;
+}
+
+void relayBegin(){
+  enabled = config.wol_relay != 0;
+  if(!enabled) return;
+  if(!netifListen(RELAY_PORT_ECHO) || !netifListen(RELAY_PORT_DISCARD))
+    logMsg(LOGL_WARN, "Relay: could not listen on ports %d/%d", RELAY_PORT_ECHO, RELAY_PORT_DISCARD);
+  logMsg(LOGL_INFO, "Relay: on, UDP %d/%d, WiFi <-> LAN", RELAY_PORT_ECHO, RELAY_PORT_DISCARD);
+}
+
+void relayInput(const uint8_t* p, size_t len, const NetifRx &rx){
+  if(!enabled) return;
+  if(rx.from == netifLocalIP((NetIface)rx.iface)) return;   // our own broadcast
+  refreshAllow();
+
+  uint8_t mac[6];
+  RelayVerdict v = filter.check(p, len, millis(), mac);
+  if(v == RELAY_INVALID){
+    metricInc(CNT_RELAY_INVALID);
+    return;
+  }
+
+  char macStr[18];
+  snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  const char* from = rx.iface == NETIF_ETH ? "LAN" : "WiFi";
+  if(v != RELAY_FORWARD){
+    metricInc((CounterId)(CNT_RELAY_FORWARDED + v));
+    logMsg(LOGL_DEBUG, "Relay: WOL for %s from %s (%s) %s", macStr, rx.from.toString().c_str(), from, relayVerdictNames[v]);
+    return;
+  }
+
+  NetIface out = rx.iface == NETIF_ETH ? NETIF_WIFI : NETIF_ETH;
+  if(!netifSend(out, rx.port, p, 6, p + 6, len - 6)){
+    metricInc(CNT_RELAY_SEND_FAILED);
+    logMsg(LOGL_DEBUG, "Relay: WOL for %s not sent, %s down", macStr, out == NETIF_ETH ? "LAN" : "WiFi");
+    return;
+  }
+  metricInc(CNT_RELAY_FORWARDED);
+  logMsg(LOGL_INFO, "Relay: WOL for %s, %s -> %s port %u", macStr, from, out == NETIF_ETH ? "LAN" : "WiFi", rx.port);
+}
+
+uint32_t relayNextMs(){
+  return enabled ? RELAY_POLL_MS : UINT32_MAX;
+}
@@ -0,0 +1,31 @@
+/*
+ * relay.h
+ * -------------------------------
+ * Declares the Wake-on-LAN relay between WiFi and the W5500:
+ *  - With config.wol_relay, UDP ports 7 and 9 are listened on on
+ *    both interfaces (next to config.udp_port, netifListen())
+ *  - A valid magic packet (relay_parse.h) for a fleet host is sent
+ *    unchanged, same port, to the broadcast address of the other
+ *    interface; the fleet table is the MAC allowlist
+ *  - Each MAC is relayed at most once per RELAY_MIN_INTERVAL_MS;
+ *    packets sent from the device's own address are ignored
+ *  - Runs in the tx task, which reads the sockets
+ */
+
+#pragma once
+#include "config.h"
+#include "netif.h"
+#include "relay_parse.h"
+
+#define RELAY_PORT_ECHO      7
+#define RELAY_PORT_DISCARD   9
+#define RELAY_RX_LEN         (WOL_MAGIC_MAX_LEN + 1)   // longer datagrams are cut to this and rejected
+#define RELAY_POLL_MS        10       // tx task socket poll while relaying
+#define RELAY_ALLOW_CHECK_MS 10000    // fleet MACs re-read for the allowlist
+
+bool relayEnabled();
+void relayBegin();                  // before netifBegin()
+
+// tx task only
+void     relayInput(const uint8_t* p, size_t len, const NetifRx &rx);
+uint32_t relayNextMs();
@@ -0,0 +1,126 @@
+/*
+ * relay_parse.h
+ * -------------------------------
+ * Wake-on-LAN relay: magic packet check and forwarding filter,
+ * shared by the firmware (relay.cpp) and the Linux tools
+ * (Tools/relay_bench.cpp, Tools/relay_replay.cpp):
+ *  - wolMagicValid(): 6 x 0xFF then the target MAC 16 times, with
+ *    an optional 4 or 6 byte SecureOn password; the 96-byte MAC
+ *    block is checked as four 24-byte copies of its first three
+ *    64-bit words, all differences OR-ed, a single branch at the end
+ *  - RelayFilter<N>: sorted MAC allowlist (binary search) holding
+ *    the time of the last forward per MAC; a MAC is forwarded at
+ *    most once per RELAY_MIN_INTERVAL_MS
+ *  - Plain C++17, no Arduino headers
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#define WOL_MAGIC_LEN         102
+#define WOL_MAGIC_MAX_LEN     108    // + 6 byte SecureOn password
+// One forward per MAC per interval. It has to stay longer than a
+// round trip through a second relay on the same two segments, so a
+// packet the other relay sends back is dropped instead of looping.
+#define RELAY_MIN_INTERVAL_MS 1000
+
+enum RelayVerdict : uint8_t {
+  RELAY_FORWARD      = 0,
+  RELAY_INVALID      = 1,
+  RELAY_NOT_ALLOWED  = 2,
+  RELAY_RATE_LIMITED = 3,
+  RELAY_VERDICT_COUNT
+};
+
+static const char* const relayVerdictNames[RELAY_VERDICT_COUNT] = {
+  "forwarded", "invalid", "not_allowed", "rate_limited"
+};
+
+inline uint64_t relayLoad64(const uint8_t* p){
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+inline uint64_t relayMacKey(const uint8_t* mac){
+  uint64_t k = 0;
+  for(int i = 0; i < 6; i++) k = (k << 8) | mac[i];
+  return k;
+}
+
+// mac receives the target on success; broadcast, multicast and
+// all-zero targets are rejected
+inline bool wolMagicValid(const uint8_t* p, size_t len, uint8_t mac[6]){
+  if(len != WOL_MAGIC_LEN && len != WOL_MAGIC_LEN + 4 && len != WOL_MAGIC_LEN + 6) return false;
+
+  uint32_t s4;
+  uint16_t s2;
+  memcpy(&s4, p, 4);
+  memcpy(&s2, p + 4, 2);
+  uint64_t diff = (uint32_t)~s4 | (uint16_t)~s2;
+
+  // m[0..24) must have period 6, then m[24..96) repeat m[0..24)
+  const uint8_t* m = p + 6;
+  uint64_t a = relayLoad64(m), b = relayLoad64(m + 8), c = relayLoad64(m + 16);
+  diff |= (a ^ relayLoad64(m + 6)) | (b ^ relayLoad64(m + 14)) | (c ^ relayLoad64(m + 22));
+  for(int k = 24; k < 96; k += 24)
+    diff |= (a ^ relayLoad64(m + k)) | (b ^ relayLoad64(m + k + 8)) | (c ^ relayLoad64(m + k + 16));
+  if(diff) return false;
+
+  if((m[0] & 1) || !(m[0] | m[1] | m[2] | m[3] | m[4] | m[5])) return false;
+  memcpy(mac, m, 6);
+  return true;
+}
+
+template<size_t N>
+class RelayFilter {
+public:
+  // Replaces the allowlist with keyAt(0..n-1), forgets the forward times
+  template<typename F> void setAllowed(size_t n, F keyAt){
+    used = 0;
+    for(size_t i = 0; i < n && used < N; i++) entries[used++] = { keyAt(i), 0, false };
+    std::sort(entries, entries + used, [](const Entry &x, const Entry &y){ return x.key < y.key; });
+    used = std::unique(entries, entries + used, [](const Entry &x, const Entry &y){ return x.key == y.key; }) - entries;
+  }
+
+  // Adds one MAC (replay without an allowlist: every MAC seen)
+  void allow(uint64_t key){
+    if(find(key) || used >= N) return;
+    size_t i = used++;
+    for(; i > 0 && entries[i - 1].key > key; i--) entries[i] = entries[i - 1];
+    entries[i] = { key, 0, false };
+  }
+
+  RelayVerdict check(const uint8_t mac[6], uint32_t nowMs){
+    Entry* e = find(relayMacKey(mac));
+    if(!e) return RELAY_NOT_ALLOWED;
+    if(e->sent && nowMs - e->lastMs < RELAY_MIN_INTERVAL_MS) return RELAY_RATE_LIMITED;
+    e->sent = true;
+    e->lastMs = nowMs;
+    return RELAY_FORWARD;
+  }
+
+  RelayVerdict check(const uint8_t* p, size_t len, uint32_t nowMs, uint8_t mac[6]){
+    return wolMagicValid(p, len, mac) ? check(mac, nowMs) : RELAY_INVALID;
+  }
+
+  size_t size() const { return used; }
+
+private:
+  struct Entry {
+    uint64_t key;
+    uint32_t lastMs;
+    bool     sent;
+  };
+
+  Entry* find(uint64_t key){
+    Entry* e = std::lower_bound(entries, entries + used, key, [](const Entry &x, uint64_t k){ return x.key < k; });
+    return e != entries + used && e->key == key ? e : nullptr;
+  }
+
+  Entry  entries[N];
+  size_t used = 0;
+};
@@ -0,0 +1,81 @@
+/*
+ * scheduler.cpp
+ * -------------------------------
+ * Implements the cooperative timer scheduler:
+ *  - Fixed table of SCHEDULER_MAX_TASKS slots (no heap use)
+ *  - Due times compared with wrap-safe millis() arithmetic
+ *  - One-shot slots are released before their task runs,
+ *    so a task may re-arm itself from inside the callback
+ */
+
+#include "scheduler.h"
+
+struct SchedTask {
+  TaskFn fn;
+#ifdef LOOP_PROFILER
+  const char* name;
+#endif
+  unsigned long due;
+  unsigned long interval;
+  bool active;
+};
+
+static SchedTask tasks[SCHEDULER_MAX_TASKS];
+
+static int schedulerAdd(unsigned long delayMs, unsigned long intervalMs, TaskFn fn, const char* name){
+  for(int i = 0; i < SCHEDULER_MAX_TASKS; i++){
+    if(!tasks[i].active){
+      tasks[i].fn = fn;
+#ifdef LOOP_PROFILER
+      tasks[i].name = name;
+#else
+      (void)name;
+#endif
+      tasks[i].due = millis() + delayMs;
+      tasks[i].interval = intervalMs;
+      tasks[i].active = true;
+      return i;
+    }
+  }
+  Serial.println("Scheduler full");
+  return -1;
+}
+
+// Parenthesised names keep the profiler macros from expanding here
+int (schedulerEvery)(unsigned long intervalMs, TaskFn fn){
+  return schedulerAdd(intervalMs, intervalMs, fn, "task");
+}
+
+int (schedulerAfter)(unsigned long delayMs, TaskFn fn){
+  return schedulerAdd(delayMs, 0, fn, "task");
+}
+
+#ifdef LOOP_PROFILER
+int schedulerEveryNamed(unsigned long intervalMs, TaskFn fn, const char* name){
+  return schedulerAdd(intervalMs, intervalMs, fn, name);
+}
+
+int schedulerAfterNamed(unsigned long delayMs, TaskFn fn, const char* name){
+  return schedulerAdd(delayMs, 0, fn, name);
+}
+#endif
+
+void schedulerCancel(int id){
+  if(id >= 0 && id < SCHEDULER_MAX_TASKS) tasks[id].active = false;
+}
+
+void schedulerRun(){
+  for(int i = 0; i < SCHEDULER_MAX_TASKS; i++){
+    SchedTask &t = tasks[i];
+    unsigned long now = millis();
+    if(!t.active || (long)(now - t.due) < 0) continue;
+
+    TaskFn fn = t.fn;
+#ifdef LOOP_PROFILER
+    const char* name = t.name;
+#endif
+    if(t.interval) t.due = now + t.interval;
+    else t.active = false;
+    PROF_CALL(name, fn());
+  }
+}
@@ -0,0 +1,35 @@
+/*
+ * scheduler.h
+ * -------------------------------
+ * Declares a small cooperative timer scheduler:
+ *  - schedulerEvery() runs a task periodically
+ *  - schedulerAfter() runs a task once after a delay
+ *  - schedulerCancel() removes a pending task
+ *  - schedulerRun() dispatches due tasks, called from loop()
+ *
+ * With LOOP_PROFILER (profiler.h) every task is timed under its
+ * function name, captured by the macros below.
+ *
+ * Tasks must return quickly; long work is split into
+ * state machines that re-arm themselves with schedulerAfter().
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "profiler.h"
+
+#define SCHEDULER_MAX_TASKS 20
+
+typedef void (*TaskFn)();
+
+int  schedulerEvery(unsigned long intervalMs, TaskFn fn);
+int  schedulerAfter(unsigned long delayMs, TaskFn fn);
+void schedulerCancel(int id);
+void schedulerRun();
+
+#ifdef LOOP_PROFILER
+int  schedulerEveryNamed(unsigned long intervalMs, TaskFn fn, const char* name);
+int  schedulerAfterNamed(unsigned long delayMs, TaskFn fn, const char* name);
+#define schedulerEvery(ms, fn) schedulerEveryNamed(ms, fn, #fn)
+#define schedulerAfter(ms, fn) schedulerAfterNamed(ms, fn, #fn)
+#endif
@@ -0,0 +1,49 @@
+/*
+ * tasks.h
+ * -------------------------------
+ * FreeRTOS task layout:
+ *  - loop()  (Arduino loopTask): scheduler, HTTP/WS, command
+ *    dispatch, wake watch, metrics; owns the shared state
+ *  - "mqtt": broker connection, TLS, publishing (mqtt.cpp)
+ *  - "tx":   paced WOL/shutdown transmit, W5500 link (fleet.cpp)
+ *  - "probe": ICMP/TCP reachability engine (probe.cpp)
+ *  - "ui":   button and LED (ui.cpp)
+ *  - "ota":  update check and download, on demand (ota.cpp)
+ * Tasks talk through lockfree_queue.h. The one shared lock is
+ * configLock (config.h): held while the portal replaces config and
+ * fleetHosts[0] live, and by the tx, probe and presence tasks while
+ * they copy strings, MACs and IPs from either.
+ *
+ * On dual-core chips the network tasks (mqtt, ota) share core 0
+ * with the WiFi/lwIP stack and the rest stays on the Arduino core;
+ * single-core chips (C3) leave the choice to the scheduler.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#if CONFIG_FREERTOS_UNICORE
+#define TASK_CORE_NET tskNO_AFFINITY
+#define TASK_CORE_APP tskNO_AFFINITY
+#else
+#define TASK_CORE_NET 0
+#define TASK_CORE_APP ARDUINO_RUNNING_CORE
+#endif
+
+#define TASK_PRIO_UI     3
+#define TASK_PRIO_TX     3
+#define TASK_PRIO_PROBE  2
+#define TASK_PRIO_MQTT   1
+#define TASK_PRIO_OTA    1
+
+#define TASK_STACK_MQTT  8192    // TLS handshake
+#define TASK_STACK_TX    4096    // agent HMAC and NVS writes
+#define TASK_STACK_PROBE 3072
+#define TASK_STACK_UI    2048
+
+inline bool taskStart(TaskFunction_t fn, const char* name, uint32_t stack, UBaseType_t prio,
+                      BaseType_t core, TaskHandle_t* handle = nullptr){
+  return xTaskCreatePinnedToCore(fn, name, stack, NULL, prio, handle, core) == pdPASS;
+}
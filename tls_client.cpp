@@ -0,0 +1,305 @@
+/*
+ * tls_client.cpp
+ * -------------------------------
+ * Implements TlsClient:
+ *  - Non-blocking socket, connect and handshake bounded by timeouts
+ *  - After every full handshake the session is serialized with
+ *    mbedtls_ssl_session_save() into RTC_NOINIT memory (CRC checked,
+ *    keyed by host:port and the pinned CA) and offered again on the
+ *    next connect
+ *  - A failed handshake with a cached session drops the cache, so
+ *    the next attempt is a plain full handshake; TLS_NO_RESUME never
+ *    offers it
+ *  - The handshake runs step by step; the lowest free heap after
+ *    any step gives the heap it needed. Time and heap are logged
+ *    and kept in TlsStats
+ */
+
+#include "tls_client.h"
+#include <WiFi.h>
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include <lwip/sockets.h>
+#include <mbedtls/net_sockets.h>
+#include "logger.h"
+
+#define TLS_RTC_MAGIC 0x544C5332   // "TLS2"
+
+struct RtcSession {
+  uint32_t magic;
+  uint32_t key;
+  uint32_t crc;
+  uint16_t len;
+  uint8_t  data[TLS_SESSION_MAX];
+};
+
+RTC_NOINIT_ATTR static RtcSession rtcSession;
+
+static bool rtcSessionValid(uint32_t key){
+  return rtcSession.magic == TLS_RTC_MAGIC && rtcSession.key == key &&
+         rtcSession.len <= TLS_SESSION_MAX &&
+         rtcSession.crc == esp_rom_crc32_le(0, rtcSession.data, rtcSession.len);
+}
+
+static int bioSend(void* ctx, const unsigned char* buf, size_t len){
+  int r = send(*(int*)ctx, buf, len, 0);
+  if(r >= 0) return r;
+  return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int bioRecv(void* ctx, unsigned char* buf, size_t len){
+  int r = recv(*(int*)ctx, buf, len, 0);
+  if(r > 0) return r;
+  if(r == 0) return MBEDTLS_ERR_NET_CONN_RESET;
+  return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+TlsClient::TlsClient() : fd(-1), open(false), hasCA(false), seeded(false), peekByte(-1), caHash(0), tlsStats() {
+  mbedtls_ssl_config_init(&conf);
+  mbedtls_ctr_drbg_init(&drbg);
+  mbedtls_entropy_init(&entropy);
+  mbedtls_x509_crt_init(&ca);
+}
+
+TlsClient::~TlsClient(){
+  stop();
+  mbedtls_x509_crt_free(&ca);
+  mbedtls_ssl_config_free(&conf);
+  mbedtls_ctr_drbg_free(&drbg);
+  mbedtls_entropy_free(&entropy);
+}
+
+// Parsed once; every later handshake reuses the chain
+bool TlsClient::setCA(const char* pem){
+  mbedtls_x509_crt_free(&ca);
+  mbedtls_x509_crt_init(&ca);
+  hasCA = mbedtls_x509_crt_parse(&ca, (const unsigned char*)pem, strlen(pem) + 1) == 0;
+  caHash = hasCA ? esp_rom_crc32_le(0, (const uint8_t*)pem, strlen(pem)) : 0;
+  if(!hasCA) logMsg(LOGL_WARN, "TLS: Invalid CA certificate, peer will not be verified");
+  return hasCA;
+}
+
+void TlsClient::clearSession(){
+  rtcSession.magic = 0;
+}
+
+// Config and RNG are set up on first use, not in the global constructor
+bool TlsClient::setupConf(){
+  if(seeded) return true;
+  static const char pers[] = "wol_mqtt";
+  if(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, (const unsigned char*)pers, sizeof(pers)) != 0) return false;
+  if(mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) return false;
+  mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+  mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+  seeded = true;
+  return true;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port){
+  return connect(ip.toString().c_str(), port, TLS_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(const char* host, uint16_t port){
+  return connect(host, port, TLS_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout){
+  return connect(ip.toString().c_str(), port, timeout);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeout){
+  stop();
+  if(!setupConf()) return 0;
+
+  IPAddress ip;
+  if(!WiFi.hostByName(host, ip)) return 0;
+
+  fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if(fd < 0) return 0;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = (uint32_t)ip;
+
+  if(::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS){
+    stop();
+    return 0;
+  }
+
+  fd_set wr;
+  FD_ZERO(&wr);
+  FD_SET(fd, &wr);
+  struct timeval tv = { timeout / 1000, (timeout % 1000) * 1000 };
+  int err = 0;
+  socklen_t errLen = sizeof(err);
+  if(select(fd + 1, NULL, &wr, NULL, &tv) <= 0 ||
+     getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) < 0 || err){
+    stop();
+    return 0;
+  }
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  // A session from an unverified or differently pinned peer is not offered
+  uint32_t key = esp_rom_crc32_le(port, (const uint8_t*)host, strlen(host));
+  key = esp_rom_crc32_le(key, (const uint8_t*)&caHash, sizeof(caHash));
+  if(!handshake(host, key)){
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+bool TlsClient::handshake(const char* host, uint32_t key){
+  unsigned long t0 = millis();
+  uint32_t heap0 = ESP.getFreeHeap();
+
+  mbedtls_ssl_conf_authmode(&conf, hasCA ? MBEDTLS_SSL_VERIFY_REQUIRED : MBEDTLS_SSL_VERIFY_NONE);
+  if(hasCA) mbedtls_ssl_conf_ca_chain(&conf, &ca, NULL);
+
+  mbedtls_ssl_init(&ssl);
+  open = true;
+  if(mbedtls_ssl_setup(&ssl, &conf) != 0 || mbedtls_ssl_set_hostname(&ssl, host) != 0) return false;
+  mbedtls_ssl_set_bio(&ssl, &fd, bioSend, bioRecv, NULL);
+
+  bool offered = false;
+#ifndef TLS_NO_RESUME
+  if(rtcSessionValid(key)){
+    mbedtls_ssl_session s;
+    mbedtls_ssl_session_init(&s);
+    offered = mbedtls_ssl_session_load(&s, rtcSession.data, rtcSession.len) == 0 &&
+              mbedtls_ssl_set_session(&ssl, &s) == 0;
+    mbedtls_ssl_session_free(&s);
+  }
+#endif
+
+  uint32_t heapLow = ESP.getFreeHeap();
+  while(!mbedtls_ssl_is_handshake_over(&ssl)){
+    int r = mbedtls_ssl_handshake_step(&ssl);
+    heapLow = min(heapLow, ESP.getFreeHeap());
+    if(r == 0) continue;
+    if((r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+       millis() - t0 > TLS_HANDSHAKE_TIMEOUT_MS){
+      logMsg(LOGL_WARN, "TLS: Handshake failed (-0x%04x)", (unsigned)-r);
+      if(offered) clearSession();
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+
+  tlsStats.handshakes++;
+  if(offered) tlsStats.resumedOffers++;
+  tlsStats.lastHandshakeMs = millis() - t0;
+  tlsStats.lastHeapUsed = heap0 > heapLow ? heap0 - heapLow : 0;
+  logMsg(LOGL_INFO, "TLS: Handshake %lu ms%s, heap peak %lu, min free %lu",
+         (unsigned long)tlsStats.lastHandshakeMs, offered ? " (cached session offered)" : "",
+         (unsigned long)tlsStats.lastHeapUsed, (unsigned long)ESP.getMinFreeHeap());
+
+  saveSession(key);
+  return true;
+}
+
+void TlsClient::saveSession(uint32_t key){
+  mbedtls_ssl_session s;
+  mbedtls_ssl_session_init(&s);
+  rtcSession.magic = 0;
+
+  size_t len = 0;
+  if(mbedtls_ssl_get_session(&ssl, &s) == 0 &&
+     mbedtls_ssl_session_save(&s, rtcSession.data, TLS_SESSION_MAX, &len) == 0){
+    rtcSession.key = key;
+    rtcSession.len = len;
+    rtcSession.crc = esp_rom_crc32_le(0, rtcSession.data, len);
+    rtcSession.magic = TLS_RTC_MAGIC;
+  } else {
+    logMsg(LOGL_DEBUG, "TLS: Session not cached");
+  }
+  mbedtls_ssl_session_free(&s);
+}
+
+size_t TlsClient::write(uint8_t b){
+  return write(&b, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size){
+  if(!open) return 0;
+
+  size_t done = 0;
+  unsigned long t0 = millis();
+  while(done < size){
+    int r = mbedtls_ssl_write(&ssl, buf + done, size - done);
+    if(r > 0){
+      done += r;
+      continue;
+    }
+    if((r != MBEDTLS_ERR_SSL_WANT_WRITE && r != MBEDTLS_ERR_SSL_WANT_READ) ||
+       millis() - t0 > TLS_IO_TIMEOUT_MS){
+      stop();
+      break;
+    }
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  return done;
+}
+
+int TlsClient::available(){
+  if(!open) return 0;
+
+  // Zero-length read pulls pending records into mbedTLS
+  int r = mbedtls_ssl_read(&ssl, NULL, 0);
+  if(r < 0 && r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE){
+    stop();
+    return peekByte >= 0;
+  }
+  return mbedtls_ssl_get_bytes_avail(&ssl) + (peekByte >= 0);
+}
+
+int TlsClient::read(){
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size){
+  int n = 0;
+  if(peekByte >= 0 && size){
+    buf[n++] = peekByte;
+    peekByte = -1;
+  }
+  if(!open || (size_t)n == size) return n ? n : -1;
+
+  int r = mbedtls_ssl_read(&ssl, buf + n, size - n);
+  if(r > 0) return n + r;
+  if(r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) stop();
+  return n ? n : -1;
+}
+
+int TlsClient::peek(){
+  if(peekByte < 0){
+    uint8_t b;
+    if(read(&b, 1) == 1) peekByte = b;
+  }
+  return peekByte;
+}
+
+void TlsClient::flush(){
+}
+
+void TlsClient::stop(){
+  if(open){
+    mbedtls_ssl_close_notify(&ssl);
+    mbedtls_ssl_free(&ssl);
+    open = false;
+  }
+  if(fd >= 0){
+    close(fd);
+    fd = -1;
+  }
+  peekByte = -1;
+}
+
+uint8_t TlsClient::connected(){
+  return open || peekByte >= 0;
+}
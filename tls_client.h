@@ -0,0 +1,78 @@
+/*
+ * tls_client.h
+ * -------------------------------
+ * Declares TlsClient, the secure transport used for MQTT:
+ *  - Arduino Client on top of an lwIP socket and mbedTLS
+ *  - The negotiated session (ID or ticket) is cached in RTC memory,
+ *    so reconnects and soft resets resume instead of doing a full
+ *    handshake
+ *  - Optional pinned CA, parsed once by setCA(); without it the peer
+ *    is not verified (same as WiFiClientSecure::setInsecure())
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Client.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/x509_crt.h>
+
+#define TLS_CONNECT_TIMEOUT_MS 5000
+#define TLS_HANDSHAKE_TIMEOUT_MS 15000
+#define TLS_IO_TIMEOUT_MS 5000
+#define TLS_SESSION_MAX 1536      // serialized session kept in RTC memory
+
+// Full handshake on every connect, for measuring what resumption saves
+// (Tools/tls_resume_bench.py)
+// #define TLS_NO_RESUME
+
+struct TlsStats {
+  uint32_t handshakes;
+  uint32_t resumedOffers;   // handshakes started with a cached session
+  uint32_t lastHandshakeMs;
+  uint32_t lastHeapUsed;    // free heap before minus its lowest point during the handshake
+};
+
+class TlsClient : public Client {
+public:
+  TlsClient();
+  ~TlsClient();
+
+  bool setCA(const char* pem);
+  void clearSession();
+  const TlsStats &stats() const { return tlsStats; }
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  int connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+  int connect(const char* host, uint16_t port, int32_t timeout) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+
+private:
+  bool setupConf();
+  bool handshake(const char* host, uint32_t key);
+  void saveSession(uint32_t key);
+
+  int fd;
+  bool open;
+  bool hasCA;
+  bool seeded;
+  int peekByte;
+  uint32_t caHash;   // CRC32 of the pinned CA PEM, 0 = none; part of the session key
+  mbedtls_ssl_context ssl;
+  mbedtls_ssl_config conf;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_entropy_context entropy;
+  mbedtls_x509_crt ca;
+  TlsStats tlsStats;
+};
@@ -0,0 +1,78 @@
+/*
+ * ui.cpp
+ * -------------------------------
+ * Implements the "ui" task:
+ *  - Sleeps until a button ISR notifies it or BUTTON_POLL_MS passes;
+ *    buttonsPoll() (buttons.cpp) then debounces and recognises
+ *    gestures, whatever the loop and network tasks are doing
+ *  - blinkDigit() pushes into an MPSC queue; the task plays one
+ *    LED edge per deadline (ON -> OFF, gap after the last blink
+ *    of a group, next group), never sleeping longer than a poll
+ */
+
+#include "ui.h"
+#include "helpers.h"
+#include "wol_ping.h"
+#include "buttons.h"
+#include "tasks.h"
+#include "lockfree_queue.h"
+
+static MpscQueue<uint8_t, BLINK_QUEUE_LEN> blinkQueue;
+static TaskHandle_t uiHandle = NULL;
+
+// ui task only
+static int  blinkLeft = 0;
+static bool ledOn = false;
+static unsigned long nextEdge = 0;
+
+static void blinkTick(unsigned long now){
+  if((long)(now - nextEdge) < 0) return;
+
+  if(ledOn){
+    digitalWrite(LED_GPIO, LOW);
+    ledOn = false;
+    nextEdge = now + (blinkLeft > 0 ? BLINK_OFF_MS : BLINK_GAP_MS);
+    return;
+  }
+
+  if(blinkLeft == 0){
+    uint8_t n;
+    if(!blinkQueue.pop(n)) return;
+    blinkLeft = n;
+  }
+
+  digitalWrite(LED_GPIO, HIGH);
+  ledOn = true;
+  blinkLeft--;
+  nextEdge = now + BLINK_ON_MS;
+}
+
+static void uiTask(void*){
+  for(;;){
+    buttonsPoll();
+    blinkTick(millis());
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BUTTON_POLL_MS));
+  }
+}
+
+void uiBegin(){
+  buttonsBegin();
+  if(!taskStart(uiTask, "ui", TASK_STACK_UI, TASK_PRIO_UI, TASK_CORE_APP, &uiHandle)){
+    logMsg(LOGL_ERROR, "UI: Could not start task");
+    return;
+  }
+  buttonsAttach(uiHandle);
+}
+
+void blinkDigit(int n){
+  if(n > 0) blinkQueue.push((uint8_t)min(n, 255));
+}
+
+void blinkVersion(const char* version){
+  int len = strlen(version);
+  for(int i = 0; i < len; i++){
+    if(version[i] >= '1' && version[i] <= '9'){
+      blinkDigit(version[i] - '0');
+    }
+  }
+}
@@ -0,0 +1,21 @@
+/*
+ * ui.h
+ * -------------------------------
+ * Declares the "ui" task (button and LED):
+ *  - uiBegin() starts the task; it handles the buttons (buttons.h)
+ *    and plays the queued LED blink groups
+ *  - blinkDigit(): queue a group of n LED blinks, from any task
+ *  - blinkVersion(): queue LED blinks displaying firmware version
+ */
+
+#pragma once
+#include "config.h"
+
+#define BLINK_ON_MS     150
+#define BLINK_OFF_MS    150
+#define BLINK_GAP_MS    500
+#define BLINK_QUEUE_LEN 8
+
+void uiBegin();
+void blinkDigit(int n);
+void blinkVersion(const char* version);
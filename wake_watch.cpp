@@ -0,0 +1,130 @@
+/*
+ * wake_watch.cpp
+ * -------------------------------
+ * Implements post-wake monitoring:
+ *  - Per-host watch: WOL time, next probe time, probe interval
+ *    (x1.5 per miss), deadline and retries left
+ *  - Listens to probe.cpp round results; the first "up" closes
+ *    the watch and records wake-to-online latency
+ *  - Publishes the per-host latency distribution as retained JSON
+ *    on wol/boottime/<name>
+ */
+
+#include "wake_watch.h"
+#include "fleet.h"
+#include "probe.h"
+#include "helpers.h"
+#include "mqtt.h"
+#include "scheduler.h"
+#include "presence.h"
+
+struct WakeWatch {
+  unsigned long wokeAt;
+  unsigned long deadline;
+  unsigned long nextProbe;
+  uint16_t interval;
+  uint8_t  retriesLeft;
+  bool     active;
+};
+
+static WakeWatch watches[FLEET_MAX_HOSTS];
+static WakeStats wstats[FLEET_MAX_HOSTS];
+
+static void publishWakeStats(int host){
+  const WakeStats &s = wstats[host];
+  char topic[48];
+  char json[160];
+  snprintf(topic, sizeof(topic), "wol/boottime/%s", fleetHosts[host].name);
+  snprintf(json, sizeof(json),
+           "{\"last\":%lu,\"min\":%lu,\"avg\":%lu,\"max\":%lu,\"count\":%lu,\"misses\":%lu}",
+           (unsigned long)s.lastMs, (unsigned long)s.minMs,
+           (unsigned long)(s.count ? s.sumMs / s.count : 0), (unsigned long)s.maxMs,
+           (unsigned long)s.count, (unsigned long)s.misses);
+  mqttPost(topic, json, true);
+}
+
+static void wakeOnline(int host, uint32_t ms, const char* how){
+  WakeWatch &w = watches[host];
+  w.active = false;
+  WakeStats &s = wstats[host];
+  s.lastMs = ms;
+  if(s.count == 0 || ms < s.minMs) s.minMs = ms;
+  if(ms > s.maxMs) s.maxMs = ms;
+  s.sumMs += ms;
+  s.count++;
+
+  logMsg(LOGL_INFO, "Wake: %s online after %lu ms (%s)", fleetHosts[host].name, (unsigned long)ms, how);
+  publishWakeStats(host);
+}
+
+static void onProbeResult(int host, bool up){
+  if(!watches[host].active || !up) return;
+  wakeOnline(host, millis() - watches[host].wokeAt, "probe");
+}
+
+static void wakeWatchTask(){
+  unsigned long now = millis();
+
+  for(int i = 0; i < fleetSize; i++){
+    WakeWatch &w = watches[i];
+    if(!w.active) continue;
+
+    uint32_t seen = presenceLastSeen(i);
+    if(seen && (long)(seen - w.wokeAt) > 0){
+      wakeOnline(i, seen - w.wokeAt, "seen on the LAN");
+      continue;
+    }
+
+    if((long)(now - w.deadline) >= 0){
+      if(w.retriesLeft == 0){
+        w.active = false;
+        wstats[i].misses++;
+        logMsg(LOGL_WARN, "Wake: %s missed deadline, giving up", fleetHosts[i].name);
+        publishWakeStats(i);
+        continue;
+      }
+      w.retriesLeft--;
+      w.deadline = now + config.wake_deadline_s * 1000UL;
+      w.interval = WAKE_PROBE_FIRST_MS;
+      w.nextProbe = now + WAKE_PROBE_FIRST_MS;
+      fleetQueue(i, FLEET_PKT_WAKE, 10);
+      logMsg(LOGL_WARN, "Wake: %s missed deadline, resending WOL", fleetHosts[i].name);
+      continue;
+    }
+
+    if((long)(now - w.nextProbe) >= 0){
+      probeHost(i, false, true);   // presence from before the WOL must not count
+      w.nextProbe = now + w.interval;
+      w.interval = min((unsigned long)w.interval * 3 / 2, WAKE_PROBE_MAX_MS);
+    }
+  }
+}
+
+void wakeWatchBegin(){
+  probeAddListener(onProbeResult);
+  schedulerEvery(WAKE_TASK_MS, wakeWatchTask);
+}
+
+void wakeWatchStart(int host){
+  if(host < 0 || host >= fleetSize) return;
+  WakeWatch &w = watches[host];
+  if(w.active) return;   // keep the first WOL time across repeats/retries
+
+  unsigned long now = millis();
+  w.wokeAt = now;
+  w.deadline = now + config.wake_deadline_s * 1000UL;
+  w.nextProbe = now + WAKE_PROBE_FIRST_MS;
+  w.interval = WAKE_PROBE_FIRST_MS;
+  w.retriesLeft = config.wake_retries;
+  w.active = true;
+}
+
+void wakeWatchCancel(int host){
+  if(host < 0 || host >= fleetSize || !watches[host].active) return;
+  watches[host].active = false;
+  logMsg(LOGL_INFO, "Wake: %s was already awake", fleetHosts[host].name);
+}
+
+const WakeStats& wakeStats(int host){
+  return wstats[host];
+}
@@ -0,0 +1,37 @@
+/*
+ * wake_watch.h
+ * -------------------------------
+ * Declares post-wake monitoring:
+ *  - wakeWatchStart() begins probing a host after a WOL burst
+ *  - Probes start WAKE_PROBE_FIRST_MS after the WOL and back off
+ *    up to WAKE_PROBE_MAX_MS until config.wake_deadline_s; an ARP
+ *    or DHCP request seen after the WOL (presence.h) counts as
+ *    online at the time it was seen
+ *  - A missed deadline resends WOL (config.wake_retries times)
+ *  - Wake-to-online latency is kept per host and published
+ *  - wakeWatchCancel() closes a watch without a sample (the host
+ *    agent answered "already awake")
+ */
+
+#pragma once
+#include "config.h"
+
+#define WAKE_PROBE_FIRST_MS   3000UL
+#define WAKE_PROBE_MAX_MS     10000UL
+#define WAKE_TASK_MS          100
+#define WAKE_DEADLINE_S_DEFAULT 180
+#define WAKE_RETRIES_DEFAULT  2
+
+struct WakeStats {
+  uint32_t count;
+  uint32_t lastMs;
+  uint32_t minMs;
+  uint32_t maxMs;
+  uint32_t sumMs;
+  uint32_t misses;
+};
+
+void wakeWatchBegin();
+void wakeWatchStart(int host);
+void wakeWatchCancel(int host);
+const WakeStats& wakeStats(int host);
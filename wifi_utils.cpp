@@ -1,37 +1,302 @@
 /*
  * wifi_utils.cpp
  * -------------------------------
- * Implements WiFi setup:
+ * Implements WiFi setup and link supervision:
  *  - Connects to WiFi using SSID/password from config
- *  - Publishes status via MQTT
- *  - If connection fails, starts ESP32 in AP mode for config portal
+ *  - The last good BSSID, channel and DHCP lease are kept in RTC
+ *    memory (soft resets) and NVS (power cycles, written only when
+ *    they change); with them the association skips the scan, and
+ *    DHCP too with config.wifi_reuse_ip, as long as the lease's end
+ *    (wall clock, from lwIP's lease time) is WIFI_LEASE_MARGIN_S
+ *    away; before that end the station goes back to DHCP. A failed
+ *    fast attempt drops the cache and falls back to a full scan
+ *  - wifiTask() polls the link from the scheduler for the whole
+ *    uptime: a drop is reconnected at once, then with exponential
+ *    backoff; Arduino's own auto-reconnect is off
+ *  - After config.wifi_ap_after_s of outage the config AP opens
+ *    (AP+STA, the retries go on) and closes again on reconnect
+ *  - Association time and outage length go to the metrics, the log
+ *    and the retained wol/wifi report
+ *  - SNTP (UTC) is started on the first association
  */
- 
+
 #include "wifi_utils.h"
 #include <WiFi.h>
+#include <Preferences.h>
+#include <esp_rom_crc.h>
+#include <sys/time.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/dhcp.h>
 #include "helpers.h"
+#include "mqtt.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "boot_profile.h"
 
-void setupWiFi(){
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(config.ssid, config.password);
+#define WIFI_RTC_MAGIC 0x57464332   // "WFC2"
+
+enum WifiLinkState { WIFI_LINK_CONNECTING, WIFI_LINK_UP, WIFI_LINK_WAIT };
+
+struct WifiCache {
+  uint32_t magic;
+  uint32_t crc;        // over everything after it
+  uint32_t ssid;       // CRC32 of config.ssid
+  uint8_t  bssid[6];
+  uint8_t  channel;
+  uint8_t  reserved;
+  uint32_t ip, gateway, mask, dns;
+  uint32_t leaseEnd;   // Unix s the DHCP lease runs out, 0 = unknown
+};
+
+RTC_NOINIT_ATTR static WifiCache rtcCache;
+
+static WifiLinkState wifiState = WIFI_LINK_CONNECTING;
+static WifiCache cache;
+static bool cacheOk = false;
+static bool fastAttempt = false;
+static bool staticIp = false;
+static bool apOpen = false;
+static bool everUp = false;
+static bool reportPending = false;
+static int wifiTaskId = -1;
+static unsigned long attemptStart = 0;
+static unsigned long downSince = 0;
+static unsigned long retryAt = 0;
+static unsigned long backoff = WIFI_BACKOFF_MIN_MS;
+static unsigned long leaseCheckedAt = 0;
+static uint32_t lastAssocMs = 0;
+static uint32_t lastOutageMs = 0;
+
+static uint32_t cacheCrc(const WifiCache &c){
+  return esp_rom_crc32_le(0, (const uint8_t*)&c.ssid, sizeof(c) - offsetof(WifiCache, ssid));
+}
+
+static uint32_t ssidHash(){
+  return esp_rom_crc32_le(0, (const uint8_t*)config.ssid, strlen(config.ssid));
+}
+
+static bool cacheValid(const WifiCache &c){
+  return c.magic == WIFI_RTC_MAGIC && c.crc == cacheCrc(c) && c.ssid == ssidHash() && c.channel;
+}
+
+static uint32_t wallClockS(){
+  return (uint32_t)(wallClockMs() / 1000);
+}
+
+// End of the station's DHCP lease, 0 when it holds none or the clock is not synced
+static uint32_t dhcpLeaseEnd(){
+  uint32_t now = wallClockS();
+  esp_netif_t* sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  struct netif* n = sta ? (struct netif*)esp_netif_get_netif_impl(sta) : nullptr;
+  if(!now || !n || !dhcp_supplied_address(n)) return 0;
+  const struct dhcp* d = netif_dhcp_data(n);
+  uint32_t used = (uint32_t)d->lease_used * DHCP_COARSE_TIMER_SECS;
+  if(d->offered_t0_lease <= used) return 0;
+  return (uint32_t)min((uint64_t)now + (d->offered_t0_lease - used), (uint64_t)UINT32_MAX);
+}
 
-  mqttPublish("Connecting WiFi...");
+static bool leaseValid(){
+  uint32_t now = wallClockS();
+  return now && cache.leaseEnd && now + WIFI_LEASE_MARGIN_S < cache.leaseEnd;
+}
 
-  int retries=0;
-  while(WiFi.status() != WL_CONNECTED && retries<30){
-    delay(500);
-    Serial.print(".");
-    retries++;
+static void loadCache(){
+  if(cacheValid(rtcCache)){
+    cache = rtcCache;
+  } else {
+    Preferences prefs;
+    prefs.begin("wifi", true);
+    bool ok = prefs.getBytes("cache", &cache, sizeof(cache)) == sizeof(cache);
+    prefs.end();
+    if(!ok || !cacheValid(cache)) return;
+    rtcCache = cache;
   }
+  cacheOk = true;
+}
+
+static void storeCache(){
+  WifiCache c = {};
+  c.magic = WIFI_RTC_MAGIC;
+  c.ssid = ssidHash();
+  uint8_t* bssid = WiFi.BSSID();
+  if(bssid) memcpy(c.bssid, bssid, 6);
+  c.channel = WiFi.channel();
+  c.ip = WiFi.localIP();
+  c.gateway = WiFi.gatewayIP();
+  c.mask = WiFi.subnetMask();
+  c.dns = WiFi.dnsIP();
+  c.leaseEnd = staticIp ? cache.leaseEnd : dhcpLeaseEnd();   // a reused lease is not extended
+  c.crc = cacheCrc(c);
+  if(!bssid || !c.channel) return;
 
-  if(WiFi.status() == WL_CONNECTED){
-    IPAddress ip = WiFi.localIP();
-    Serial.print("WiFi connected, IP: ");
-    Serial.println(ip);
+  rtcCache = c;
+  if(cacheOk && !memcmp(&c, &cache, sizeof(c))) return;   // NVS already holds it
+  cache = c;
+  cacheOk = true;
+  Preferences prefs;
+  prefs.begin("wifi", false);
+  prefs.putBytes("cache", &c, sizeof(c));
+  prefs.end();
+}
+
+static void dropCache(){
+  cacheOk = false;
+  rtcCache.magic = 0;
+  Preferences prefs;
+  prefs.begin("wifi", false);
+  prefs.remove("cache");
+  prefs.end();
+}
+
+static void startAttempt(){
+  if(attemptStart) WiFi.disconnect();
+  fastAttempt = cacheOk;
+  attemptStart = max(millis(), 1UL);
+  wifiState = WIFI_LINK_CONNECTING;
 
+  bool reuse = fastAttempt && config.wifi_reuse_ip && cache.ip && leaseValid();
+  if(reuse){
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.mask), IPAddress(cache.dns));
+  } else if(staticIp){
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));   // back to DHCP
+  }
+  staticIp = reuse;
+
+  if(fastAttempt) WiFi.begin(config.ssid, config.password, cache.channel, cache.bssid);
+  else WiFi.begin(config.ssid, config.password);
+}
+
+// Link up: hand a reused lease back to DHCP before it runs out, and
+// keep the cached end current (renewals, or the first SNTP sync)
+static void leaseCheck(unsigned long now){
+  if(now - leaseCheckedAt < WIFI_LEASE_CHECK_MS) return;
+  leaseCheckedAt = now;
+  if(staticIp){
+    if(leaseValid()) return;
+    logMsg(LOGL_INFO, "WiFi: reused DHCP lease ends, back to DHCP");
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+    staticIp = false;
+    return;
+  }
+  uint32_t end = dhcpLeaseEnd();
+  if(end && (end > cache.leaseEnd + 2 * DHCP_COARSE_TIMER_SECS || end + 2 * DHCP_COARSE_TIMER_SECS < cache.leaseEnd))
+    storeCache();
+}
+
+static void openAp(){
+  apOpen = true;
+  logMsg(LOGL_ERROR, "WiFi: down for %lu s, starting AP...", (millis() - downSince) / 1000);
+  WiFi.mode(WIFI_AP_STA);
+  WiFi.softAP(WIFI_AP_SSID);
+}
+
+static void linkUp(unsigned long now){
+  lastAssocMs = now - attemptStart;
+  metricObserve(HIST_WIFI_ASSOC_MS, lastAssocMs);
+  logMsg(LOGL_INFO, "WiFi connected, IP: %s (%s, %lu ms)", WiFi.localIP().toString().c_str(),
+         fastAttempt ? "cached BSSID" : "scan", (unsigned long)lastAssocMs);
+  if(everUp){
+    lastOutageMs = now - downSince;
+    metricObserve(HIST_WIFI_OUTAGE_MS, lastOutageMs);
+    logMsg(LOGL_INFO, "WiFi: back after %lu ms outage", (unsigned long)lastOutageMs);
   } else {
-    mqttPublish("WiFi Failed, starting AP...");
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP("WOL_ESP32_Config");
+    everUp = true;
+    bootMarkOnce("wifi_up");
+    configTime(0, 0, WIFI_NTP_SERVER);
+  }
+
+  storeCache();
+  leaseCheckedAt = now;
+  backoff = WIFI_BACKOFF_MIN_MS;
+  wifiState = WIFI_LINK_UP;
+  reportPending = true;
+  if(apOpen){
+    apOpen = false;
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_STA);
+    logMsg(LOGL_INFO, "WiFi: AP closed");
   }
 }
+
+static void linkReport(){
+  if(!mqttConnected()) return;
+  char json[192];
+  const WifiCache &c = rtcCache;
+  snprintf(json, sizeof(json),
+           "{\"assoc_ms\":%lu,\"fast\":%s,\"outage_ms\":%lu,\"drops\":%lu,\"channel\":%u,"
+           "\"bssid\":\"%02X:%02X:%02X:%02X:%02X:%02X\",\"rssi\":%ld}",
+           (unsigned long)lastAssocMs, fastAttempt ? "true" : "false", (unsigned long)lastOutageMs,
+           (unsigned long)metricCounters[CNT_WIFI_DROPS].load(std::memory_order_relaxed), c.channel,
+           c.bssid[0], c.bssid[1], c.bssid[2], c.bssid[3], c.bssid[4], c.bssid[5], (long)WiFi.RSSI());
+  if(mqttPost("wol/wifi", json, true)) reportPending = false;
+}
+
+static void wifiTask(){
+  unsigned long now = millis();
+  bool linked = WiFi.status() == WL_CONNECTED;
+
+  switch(wifiState){
+  case WIFI_LINK_UP:
+    if(linked){
+      if(reportPending) linkReport();
+      leaseCheck(now);
+      return;
+    }
+    metricInc(CNT_WIFI_DROPS);
+    logMsg(LOGL_WARN, "WiFi: link lost");
+    downSince = now;
+    startAttempt();
+    return;
+
+  case WIFI_LINK_CONNECTING:
+    if(linked){
+      linkUp(now);
+      return;
+    }
+    if(now - attemptStart < (fastAttempt ? WIFI_FAST_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS)) break;
+    if(fastAttempt){
+      logMsg(LOGL_INFO, "WiFi: cached BSSID/channel failed, scanning");
+      metricInc(CNT_WIFI_SCAN_FALLBACKS);
+      dropCache();
+      startAttempt();
+      break;
+    }
+    WiFi.disconnect();
+    wifiState = WIFI_LINK_WAIT;
+    retryAt = now + backoff;
+    logMsg(LOGL_DEBUG, "WiFi: no link, retry in %lu ms", backoff);
+    backoff = min(backoff * 2, WIFI_BACKOFF_MAX_MS);
+    break;
+
+  case WIFI_LINK_WAIT:
+    if((long)(now - retryAt) >= 0) startAttempt();
+    break;
+  }
+
+  if(!apOpen && config.wifi_ap_after_s > 0 && now - downSince >= (unsigned long)config.wifi_ap_after_s * 1000UL) openAp();
+}
+
+void setupWiFi(){
+  WiFi.persistent(false);          // credentials come from config, not the WiFi NVS
+  WiFi.setAutoReconnect(false);    // wifiTask() reconnects
+  WiFi.mode(WIFI_STA);
+  loadCache();
+
+  mqttPublish(cacheOk ? "Connecting WiFi (cached BSSID)..." : "Connecting WiFi...");
+
+  downSince = millis();
+  startAttempt();
+  if(wifiTaskId < 0) wifiTaskId = schedulerEvery(WIFI_POLL_MS, wifiTask);
+}
+
+bool wifiConnected(){
+  return WiFi.status() == WL_CONNECTED;
+}
+
+uint64_t wallClockMs(){
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if(tv.tv_sec < (time_t)WALL_CLOCK_MIN_S) return 0;
+  return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
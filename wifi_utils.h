@@ -1,12 +1,30 @@
 /*
  * wifi_utils.h
  * -------------------------------
- * Declares WiFi setup functions.
- * Handles connection to configured WiFi network
- * or starts an access point for configuration if connection fails.
+ * Declares WiFi setup and link supervision.
+ * Associates with the last good BSSID/channel when it is cached
+ * (RTC memory, then NVS), otherwise with a full scan; the link is
+ * watched for its whole life and reconnected with backoff, and the
+ * config access point opens only after config.wifi_ap_after_s of
+ * outage. Starts SNTP once the station is up, for the command
+ * timestamps.
  */
- 
+
 #pragma once
 #include "config.h"
 
-void setupWiFi();
\ No newline at end of file
+#define WIFI_POLL_MS            100
+#define WIFI_FAST_TIMEOUT_MS    3000     // cached BSSID/channel, then a full scan
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#define WIFI_BACKOFF_MIN_MS     1000UL
+#define WIFI_BACKOFF_MAX_MS     60000UL
+#define WIFI_AP_AFTER_S_DEFAULT 120
+#define WIFI_AP_SSID            "WOL_ESP32_Config"
+#define WIFI_LEASE_MARGIN_S     300      // a reused lease needs this much left; DHCP takes over here
+#define WIFI_LEASE_CHECK_MS     60000
+#define WIFI_NTP_SERVER  "pool.ntp.org"
+#define WALL_CLOCK_MIN_S 1700000000UL   // earlier = not synced yet
+
+void setupWiFi();
+bool wifiConnected();
+uint64_t wallClockMs();   // Unix time in ms, 0 until SNTP has synced
@@ -2,110 +2,47 @@
  * wol_ping.cpp
  * -------------------------------
  * Implements Wake-on-LAN and ping monitoring:
- *  - Builds and sends the magic packet to broadcast address
- *  - Uses ESP32Ping to check if the PC is online
- *  - Button press can trigger WOL
- *  - After sending WOL, performs a delayed ping
+ *  - Queues the magic packet for the default fleet host (fleet.cpp)
+ *  - doPing() starts a non-blocking probe round (probe.cpp)
+ *  - After WOL, wake_watch.cpp probes until the PC is online
+ *  - After shutdown, performs a delayed ping (cancelled when the host
+ *    agent acknowledges the request, agent.cpp)
  */
 
 #include "wol_ping.h"
 #include "helpers.h"
 #include "config.h"
-#include <ESP32Ping.h>
-
-void sendWOL(const char* reason, int n) {
-    uint8_t magic_packet[102];
-
-    memset(magic_packet, 0xFF, 6);
-    for(int j = 0; j < 16; j++) {
-        memcpy(&magic_packet[6 + j * 6], config.mac_address, 6);
+#include "fleet.h"
+#include "probe.h"
+#include "agent.h"
+
+// false when nothing was queued (TX queue full or no fleet host)
+bool sendWOL(const char* reason, int n) {
+    if (!fleetQueue(0, FLEET_PKT_WAKE, n)) {
+        logMsg(LOGL_WARN, "WOL not sent - %s: TX queue full or no host", reason);
+        return false;
     }
-
-    // --- Send by Wi-Fi---
-    IPAddress wifi_bcast;
-    if(wifi_bcast.fromString(config.broadcastIPStr)) {
-        for(int i = 0; i < n; i++) {
-            udp.beginPacket(wifi_bcast, config.udp_port);
-            udp.write(magic_packet, sizeof(magic_packet));
-            udp.endPacket();
-        }
-        mqttPublish(("WOL sent (Wi-Fi) - " + String(reason)).c_str());
-        Serial.println("WOL sent (Wi-Fi)");
-    }
-
-    // --- Send by if Ethernet (SPI) ---
-    if (ethernet_lan_present) {
-        EthernetUDP ethUdp;
-        ethUdp.begin(config.udp_port);
-        
-        IPAddress eth_bcast(192, 168, 5, 255); 
-
-        for(int i = 0; i < n; i++) {
-            ethUdp.beginPacket(eth_bcast, config.udp_port);
-            ethUdp.write(magic_packet, sizeof(magic_packet));
-            ethUdp.endPacket();
-        }
-        mqttPublish(("WOL sent (LAN/SPI) - " + String(reason)).c_str());
-        Serial.println("WOL sent (LAN/SPI)");
-        ethUdp.stop();
-    }
-
-    wolSentAt = millis();
-    wolPendingPing = true;
+    logMsg(LOGL_INFO, "WOL sent - %s", reason);
+    return true;
 }
 
 
-void sendShutdownPacket(const char* reason, int n) {
-    uint8_t packet[102];
-
-    for(int i = 0; i < n; i++) {
-        memset(packet, 0xEE, 6); 
-        for(int j = 0; j < 16; j++) {
-            memcpy(&packet[6+j*6], config.mac_address, 6);
-        }
-
-        IPAddress bcast;
-        if(!bcast.fromString(config.broadcastIPStr)) {
-            Serial.println("Broadcast IP error");
-            return;
-        }
-
-        udp.beginPacket(bcast, config.udp_port);
-        udp.write(packet, sizeof(packet));
-        udp.endPacket();
+bool sendShutdownPacket(const char* reason, int n) {
+    if (!fleetQueue(0, FLEET_PKT_SHUTDOWN, n)) {
+        logMsg(LOGL_WARN, "Shutdown not sent (%s): TX queue full or no host", reason);
+        return false;
     }
-
-    mqttPublish(("Shutdown Packet sent (" + String(reason) + ")").c_str());
-    Serial.println("Shutdown Packet sent " + String(reason));
+    logMsg(LOGL_INFO, agentEnabled() ? "Shutdown request sent (%s)" : "Shutdown Packet sent (%s)", reason);
 
     wolSentAt = millis();
     wolPendingPing = true;
+    return true;
 }
 
+// Active: after a shutdown the host's ARP/DHCP traffic of the last
+// PRESENCE_FRESH_MS would otherwise still answer "online"
 void doPing(){
-  IPAddress target; 
-  target.fromString(config.target_ip);
-  bool ok = Ping.ping(target,3);
-  if(ok){
-    mqttPublish("Ping: PC online");
-  } else {
-    mqttPublish("Ping: PC offline");
-  }  
-}
-
-void handleButton(){
-  static unsigned long t0 = 0;
-  if(digitalRead(BUTTON_GPIO) == LOW){
-    if(!buttonTriggered){ 
-      buttonTriggered = true; 
-      t0=millis(); 
-    }
-    else if(millis() - t0 > 1000){ 
-      blinkDigit(1);
-      sendWOL("Button", 10); 
-      buttonTriggered = false;
-    }
-  } else buttonTriggered = false;
+  probeHost(0, true, true);
 }
 
 void handleScheduledPing(){
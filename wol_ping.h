@@ -2,21 +2,21 @@
  * wol_ping.h
  * -------------------------------
  * Declares functions for Wake-on-LAN and ping monitoring:
- *  - sendWOL() sends a magic packet to wake the PC
- *  - doPing() checks if the PC is online
- *  - handleButton() triggers WOL by button press
- *  - handleScheduledPing() does ping after WOL delay
+ *  - sendWOL() sends a magic packet to wake the PC; false when
+ *    nothing could be queued
+ *  - doPing() starts a probe of the PC (result published async)
+ *  - handleScheduledPing() does ping after shutdown delay
  */
 
 #pragma once
 #include "config.h"
-#include <EthernetUdp.h>
+
+#define BUTTON_POLL_MS 10    // ui task tick (buttons.h, ui.h)
+#define PING_POLL_MS   100
 
 extern bool wolPendingPing;
-extern bool ethernet_lan_present;
 
-void sendWOL(const char* reason, int n);
-void sendShutdownPacket(const char* reason, int n);
+bool sendWOL(const char* reason, int n);
+bool sendShutdownPacket(const char* reason, int n);
 void doPing();
-void handleButton();
 void handleScheduledPing();
\ No newline at end of file